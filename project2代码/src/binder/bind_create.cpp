@@ -129,7 +129,7 @@ auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<
     }
   }
 
-  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols));
+  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols), stmt->accessMethod);
 }
 
 }  // namespace bustub
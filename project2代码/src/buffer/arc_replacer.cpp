@@ -0,0 +1,172 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+ArcReplacer::ArcReplacer(size_t num_frames) : replacer_size_(num_frames), frames_(num_frames) {}
+
+auto ArcReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> candidates;
+  CollectEvictable(PreferT1() ? t1_ : t2_, 1, &candidates);
+  if (candidates.empty()) {
+    CollectEvictable(PreferT1() ? t2_ : t1_, 1, &candidates);
+  }
+  if (candidates.empty()) {
+    return false;
+  }
+
+  *frame_id = candidates[0];
+  auto &frame = frames_[*frame_id];
+  if (frame.page_id_ != INVALID_PAGE_ID) {
+    auto &ghosts = frame.list_ == ListType::T1 ? b1_ : b2_;
+    ghosts.push_front(frame.page_id_);
+    ghosts_[frame.page_id_] = {frame.list_ == ListType::T2, ghosts.begin()};
+  }
+  Untrack(*frame_id);
+  TrimGhosts();
+  return true;
+}
+
+void ArcReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  auto &frame = frames_[frame_id];
+  if (frame.list_ != ListType::NONE) {
+    // A hit: the frame has now been used at least twice.
+    GetList(frame.list_).erase(frame.pos_);
+    t2_.push_front(frame_id);
+    frame.list_ = ListType::T2;
+    frame.pos_ = t2_.begin();
+    return;
+  }
+
+  // A miss. A page that was evicted recently tells which list should have kept it.
+  frame.list_ = ListType::T1;
+  frame.page_id_ = page_id;
+  auto it = page_id == INVALID_PAGE_ID ? ghosts_.end() : ghosts_.find(page_id);
+  if (it != ghosts_.end()) {
+    if (it->second.in_b2_) {
+      auto delta = std::max<size_t>(1, b1_.size() / b2_.size());
+      target_t1_ = target_t1_ > delta ? target_t1_ - delta : 0;
+      b2_.erase(it->second.pos_);
+    } else {
+      auto delta = std::max<size_t>(1, b2_.size() / b1_.size());
+      target_t1_ = std::min(target_t1_ + delta, replacer_size_);
+      b1_.erase(it->second.pos_);
+    }
+    ghosts_.erase(it);
+    frame.list_ = ListType::T2;
+  }
+  auto &list = GetList(frame.list_);
+  list.push_front(frame_id);
+  frame.pos_ = list.begin();
+  TrimGhosts();
+}
+
+void ArcReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  auto &frame = frames_[frame_id];
+  if (frame.list_ == ListType::NONE || frame.is_evictable_ == set_evictable) {
+    return;
+  }
+  frame.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    num_evictable_++;
+  } else {
+    num_evictable_--;
+  }
+}
+
+void ArcReplacer::Remove(frame_id_t frame_id) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  const auto &frame = frames_[frame_id];
+  if (frame.list_ == ListType::NONE) {
+    return;
+  }
+  if (!frame.is_evictable_) {
+    throw Exception(ExceptionType::INVALID, "cannot remove a non-evictable frame");
+  }
+  Untrack(frame_id);
+}
+
+auto ArcReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return num_evictable_;
+}
+
+auto ArcReplacer::GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> candidates;
+  CollectEvictable(PreferT1() ? t1_ : t2_, max_frames, &candidates);
+  CollectEvictable(PreferT1() ? t2_ : t1_, max_frames, &candidates);
+  return candidates;
+}
+
+auto ArcReplacer::GetTargetRecencySize() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return target_t1_;
+}
+
+void ArcReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "invalid frame id");
+  }
+}
+
+void ArcReplacer::CollectEvictable(const std::list<frame_id_t> &list, size_t max_frames,
+                                   std::vector<frame_id_t> *candidates) {
+  for (auto it = list.rbegin(); it != list.rend() && candidates->size() < max_frames; it++) {
+    if (frames_[*it].is_evictable_) {
+      candidates->push_back(*it);
+    }
+  }
+}
+
+void ArcReplacer::Untrack(frame_id_t frame_id) {
+  auto &frame = frames_[frame_id];
+  GetList(frame.list_).erase(frame.pos_);
+  if (frame.is_evictable_) {
+    num_evictable_--;
+  }
+  frame = FrameEntry{};
+}
+
+void ArcReplacer::TrimGhosts() {
+  // |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c, as in the paper.
+  while (!b1_.empty() && t1_.size() + b1_.size() > replacer_size_) {
+    PopGhost(&b1_);
+  }
+  while (t1_.size() + t2_.size() + b1_.size() + b2_.size() > 2 * replacer_size_) {
+    PopGhost(b2_.empty() ? &b1_ : &b2_);
+  }
+}
+
+void ArcReplacer::PopGhost(std::list<page_id_t> *ghosts) {
+  ghosts_.erase(ghosts->back());
+  ghosts->pop_back();
+}
+
+}  // namespace bustub
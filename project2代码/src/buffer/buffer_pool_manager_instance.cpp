@@ -12,18 +12,55 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <cstring>
+#include <future>  // NOLINT
+
 #include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
+/** Hand a batch of requests to the disk manager, which may perform them concurrently, and wait for all of them. */
+static void PerformBatch(DiskManager *disk_manager, std::vector<DiskRequest> *requests) {
+  if (requests->empty()) {
+    return;
+  }
+  std::vector<std::future<bool>> futures;
+  futures.reserve(requests->size());
+  for (auto &request : *requests) {
+    futures.push_back(request.callback_.get_future());
+  }
+  disk_manager->Schedule(requests);
+  for (auto &future : futures) {
+    future.wait();
+  }
+}
+
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, replacer_type) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 0.");
   // we allocate a consecutive memory space for the buffer pool
   pages_ = new Page[pool_size_];
+  frame_cv_ = new std::condition_variable[pool_size_];
+  io_in_progress_.resize(pool_size_, false);
+  cleaned_.resize(pool_size_, false);
+  on_probation_.resize(pool_size_, false);
   page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  replacer_ = MakeReplacementPolicy(replacer_type, pool_size, replacer_k);
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -32,110 +69,193 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManag
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  StopPageCleaner();
+  StopPrefetcher();
   delete[] pages_;
+  delete[] frame_cv_;
   delete page_table_;
-  delete replacer_;
 }
 
-auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
+auto BufferPoolManagerInstance::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  stats.pool_size_ = pool_size_;
+  stats.fetches_ = fetches_.load(std::memory_order_relaxed);
+  stats.hits_ = hits_.load(std::memory_order_relaxed);
+  stats.misses_ = misses_.load(std::memory_order_relaxed);
+  stats.new_pages_ = new_pages_.load(std::memory_order_relaxed);
+  stats.failed_requests_ = failed_requests_.load(std::memory_order_relaxed);
+  stats.evictions_ = evictions_.load(std::memory_order_relaxed);
+  stats.dirty_writebacks_ = dirty_writebacks_.load(std::memory_order_relaxed);
+  stats.pages_cleaned_ = GetPagesCleaned();
+  stats.writebacks_avoided_ = GetWritebacksAvoided();
+  stats.pages_prefetched_ = GetPagesPrefetched();
+  stats.swizzled_fetches_ = GetSwizzledFetches();
+  stats.admissions_rejected_ = GetAdmissionsRejected();
+  stats.page_table_bytes_ = page_table_->GetMemoryUsage();
 
-  bool is_free_page = false;
+  std::scoped_lock<std::mutex> lock(latch_);
   for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() == 0) {
-      is_free_page = true;
-      break;
+    const auto &page = pages_[i];
+    if (page.page_id_ == INVALID_PAGE_ID) {
+      stats.free_frames_++;
+      continue;
     }
+    stats.pinned_frames_ += page.pin_count_ > 0 ? 1 : 0;
+    stats.dirty_frames_ += page.is_dirty_ ? 1 : 0;
+    stats.resident_pages_[static_cast<size_t>(page.GetPageType())]++;
   }
+  return stats;
+}
 
-  if (!is_free_page) {
-    return nullptr;
-  }
-
-  *page_id = AllocatePage();
-
-  frame_id_t frame_id;
+void BufferPoolManagerInstance::SetAccessTrace(PageAccessTrace *trace) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  trace_ = trace;
+}
 
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    // assert(replacer_->Evict(&frame_id));
-    replacer_->Evict(&frame_id);
-    page_id_t evicted_page_id = pages_[frame_id].GetPageId();
+void BufferPoolManagerInstance::TraceAccess(PageAccessTrace::EventType type, page_id_t page_id) {
+  if (trace_ != nullptr) {
+    trace_->Record(type, page_id);
+  }
+}
 
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(evicted_page_id, pages_[frame_id].GetData());
-      pages_[frame_id].is_dirty_ = false;
-    }
+auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * { return NewPgWithStrategyImp(page_id, nullptr); }
 
-    pages_[frame_id].ResetMemory();
+auto BufferPoolManagerInstance::NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
+  std::unique_lock<std::mutex> lock(latch_);
 
-    page_table_->Remove(evicted_page_id);
+  frame_id_t frame_id;
+  page_id_t victim_page_id;
+  if (!AcquireFrame(&frame_id, &victim_page_id, strategy)) {
+    failed_requests_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
   }
 
-  page_table_->Insert(*page_id, frame_id);
-
-  pages_[frame_id].page_id_ = *page_id;
-  pages_[frame_id].pin_count_ = 1;
-
-  replacer_->RecordAccess(frame_id);
-  replacer_->SetEvictable(frame_id, false);
+  new_pages_.fetch_add(1, std::memory_order_relaxed);
+  *page_id = AllocatePage();
+  TraceAccess(PageAccessTrace::EventType::NEW, *page_id);
+  if (admission_filter_ != nullptr) {
+    admission_filter_->RecordAccess(*page_id);
+  }
+  InstallPage(*page_id, frame_id);
+  if (strategy != nullptr) {
+    strategy->Advance(*page_id);
+  }
+  LoadFrame(&lock, frame_id, victim_page_id, false);
 
   return &pages_[frame_id];
 }
 
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
+  return FetchPgWithStrategyImp(page_id, nullptr);
+}
 
-  frame_id_t frame_id;
-  if (page_table_->Find(page_id, frame_id)) {
-    pages_[frame_id].pin_count_++;
-    replacer_->RecordAccess(frame_id);
-    replacer_->SetEvictable(frame_id, false);
-    return &pages_[frame_id];
+auto BufferPoolManagerInstance::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  std::unique_lock<std::mutex> lock(latch_);
+  return FetchPageLocked(&lock, page_id, strategy);
+}
+
+auto BufferPoolManagerInstance::FetchChildPgImp(Page *parent, int slot, page_id_t page_id) -> Page * {
+  if (parent->swips_ == nullptr || slot < 0 || static_cast<size_t>(slot) >= SWIP_SLOTS) {
+    return FetchPgImp(page_id);
   }
 
-  bool is_free_page = false;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() == 0) {
-      is_free_page = true;
-      break;
+  std::unique_lock<std::mutex> lock(latch_);
+  auto &swip = parent->swips_[slot];
+  auto frame_id = swip.load(std::memory_order_relaxed);
+  // The child may have been evicted since, or the slot may point to another child after a split or a merge.
+  if (frame_id != INVALID_FRAME_ID && static_cast<size_t>(frame_id) < pool_size_ &&
+      pages_[frame_id].page_id_ == page_id) {
+    PinResidentFrame(&lock, frame_id, nullptr);
+    TraceAccess(PageAccessTrace::EventType::FETCH, page_id);
+    if (admission_filter_ != nullptr) {
+      admission_filter_->RecordAccess(page_id);
     }
+    fetches_.fetch_add(1, std::memory_order_relaxed);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    swizzled_fetches_.fetch_add(1, std::memory_order_relaxed);
+    return &pages_[frame_id];
   }
 
-  if (!is_free_page) {
-    return nullptr;
+  auto *page = FetchPageLocked(&lock, page_id, nullptr);
+  if (page != nullptr) {
+    swip.store(static_cast<frame_id_t>(page - pages_), std::memory_order_relaxed);
   }
+  return page;
+}
 
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    // assert(replacer_->Evict(&frame_id));
-    replacer_->Evict(&frame_id);
-    page_id_t evicted_page_id = pages_[frame_id].GetPageId();
+auto BufferPoolManagerInstance::PeekChildPgImp(Page *parent, int slot, page_id_t page_id, uint64_t *version)
+    -> Page * {
+  if (parent->swips_ == nullptr || slot < 0 || static_cast<size_t>(slot) >= SWIP_SLOTS) {
+    return nullptr;
+  }
+  // Frames are never freed, so a stale swip is safe to follow: the version and the page id tell whether it still holds
+  // the child.
+  auto frame_id = parent->swips_[slot].load(std::memory_order_relaxed);
+  if (frame_id == INVALID_FRAME_ID || static_cast<size_t>(frame_id) >= pool_size_ ||
+      !pages_[frame_id].OptimisticLatchFrame(page_id, version)) {
+    return nullptr;
+  }
+  return &pages_[frame_id];
+}
 
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(evicted_page_id, pages_[frame_id].GetData());
-      pages_[frame_id].is_dirty_ = false;
+auto BufferPoolManagerInstance::FetchPageLocked(std::unique_lock<std::mutex> *lock, page_id_t page_id,
+                                                BufferAccessStrategy *strategy) -> Page * {
+  fetches_.fetch_add(1, std::memory_order_relaxed);
+  TraceAccess(PageAccessTrace::EventType::FETCH, page_id);
+  if (admission_filter_ != nullptr) {
+    admission_filter_->RecordAccess(page_id);
+  }
+  frame_id_t frame_id;
+  while (true) {
+    if (page_table_->Find(page_id, frame_id)) {
+      PinResidentFrame(lock, frame_id, strategy);
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return &pages_[frame_id];
     }
 
-    pages_[frame_id].ResetMemory();
+    // The page was just evicted and its write-back has not finished yet, so the copy on disk is stale.
+    auto it = writeback_pages_.find(page_id);
+    if (it == writeback_pages_.end()) {
+      break;
+    }
+    frame_cv_[it->second].wait(*lock);
+  }
 
-    page_table_->Remove(evicted_page_id);
+  page_id_t victim_page_id;
+  // A scan has its own ring and does not need the filter to protect the rest of the pool from it.
+  page_id_t rival_page_id;
+  bool on_probation = strategy == nullptr && !AdmitPage(page_id, &rival_page_id);
+  if (!(on_probation && AcquireProbationFrame(rival_page_id, &frame_id, &victim_page_id)) &&
+      !AcquireFrame(&frame_id, &victim_page_id, strategy)) {
+    failed_requests_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
   }
 
-  page_table_->Insert(page_id, frame_id);
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  InstallPage(page_id, frame_id);
+  if (on_probation) {
+    admissions_rejected_.fetch_add(1, std::memory_order_relaxed);
+    on_probation_[frame_id] = true;
+    probation_.push_back(page_id);
+  }
+  if (strategy != nullptr) {
+    strategy->Advance(page_id);
+  }
+  LoadFrame(lock, frame_id, victim_page_id, true);
 
-  pages_[frame_id].page_id_ = page_id;
-  pages_[frame_id].pin_count_ = 1;
-  disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
+  return &pages_[frame_id];
+}
 
-  replacer_->RecordAccess(frame_id);
+void BufferPoolManagerInstance::PinResidentFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id,
+                                                 BufferAccessStrategy *strategy) {
+  pages_[frame_id].pin_count_++;
+  // A scan revisits its current page once per tuple; that must not make the page look hot.
+  if (strategy == nullptr) {
+    replacer_->RecordAccess(frame_id, pages_[frame_id].page_id_);
+  }
   replacer_->SetEvictable(frame_id, false);
-
-  return &pages_[frame_id];
+  // Another thread may still be reading the page in. The pin keeps the frame from being reused while we wait.
+  frame_cv_[frame_id].wait(*lock, [&] { return !io_in_progress_[frame_id]; });
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
@@ -151,7 +271,7 @@ auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) ->
   }
 
   if (is_dirty) {
-    pages_[frame_id].is_dirty_ = is_dirty;
+    SetDirty(frame_id, true);
   }
 
   pages_[frame_id].pin_count_--;
@@ -168,49 +288,532 @@ auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
     return false;
   }
 
+  std::unique_lock<std::mutex> lock(latch_);
   frame_id_t frame_id;
-
+  while (page_table_->Find(page_id, frame_id) && io_in_progress_[frame_id]) {
+    frame_cv_[frame_id].wait(lock);
+  }
   if (!page_table_->Find(page_id, frame_id)) {
     return false;
   }
 
-  disk_manager_->WritePage(page_id, pages_[frame_id].data_);
+  // Like the page cleaner, write a copy taken under the page's read latch with latch_ released, so that the write does
+  // not stall the rest of the pool
+  PinForWriteBack(frame_id);
+  WriteBackFrames(&lock, {frame_id});
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  std::scoped_lock<std::mutex> lock(latch_);
-  for (size_t frame_id = 0; frame_id < pool_size_; frame_id++) {
-    FlushPgImp(pages_[frame_id].GetPageId());
+  std::unique_lock<std::mutex> lock(latch_);
+  std::vector<frame_id_t> batch;
+  for (size_t i = 0; i < pool_size_; i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    frame_cv_[frame_id].wait(lock, [&] { return !io_in_progress_[frame_id]; });
+    if (pages_[frame_id].GetPageId() == INVALID_PAGE_ID) {
+      continue;
+    }
+    PinForWriteBack(frame_id);
+    batch.push_back(frame_id);
+    if (batch.size() == IO_BATCH_SIZE) {
+      WriteBackFrames(&lock, batch);
+      batch.clear();
+    }
   }
+  WriteBackFrames(&lock, batch);
+  lock.unlock();
+  disk_manager_->SyncDatabase();
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
 
   frame_id_t frame_id;
-  if (!page_table_->Find(page_id, frame_id)) {
-    return true;
+  while (!page_table_->Find(page_id, frame_id)) {
+    auto it = writeback_pages_.find(page_id);
+    if (it == writeback_pages_.end()) {
+      DeallocatePage(page_id);
+      return true;
+    }
+    // The page was just evicted, and its write-back must land before the page is reused
+    frame_cv_[it->second].wait(lock);
   }
 
   if (pages_[frame_id].GetPinCount() > 0) {
     return false;
   }
 
+  TraceAccess(PageAccessTrace::EventType::DELETE, page_id);
+  DiscardFrame(frame_id);
+  DeallocatePage(page_id);
+
+  return true;
+}
+
+void BufferPoolManagerInstance::DiscardFrame(frame_id_t frame_id) {
   replacer_->Remove(frame_id);
+  page_table_->Remove(pages_[frame_id].page_id_);
 
+  pages_[frame_id].BeginFrameChange();
   pages_[frame_id].ResetMemory();
-  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+  pages_[frame_id].page_id_.store(INVALID_PAGE_ID, std::memory_order_relaxed);
   pages_[frame_id].pin_count_ = 0;
-  pages_[frame_id].is_dirty_ = false;
+  pages_[frame_id].page_type_.store(PageType::UNKNOWN, std::memory_order_relaxed);
+  SetDirty(frame_id, false);
+  ResetSwips(frame_id);
+  pages_[frame_id].EndFrameChange();
 
-  page_table_->Remove(page_id);
   free_list_.push_back(frame_id);
-  DeallocatePage(page_id);
+}
 
+auto BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id, page_id_t *victim_page_id,
+                                             BufferAccessStrategy *strategy) -> bool {
+  *victim_page_id = INVALID_PAGE_ID;
+  if (strategy != nullptr && AcquireRingFrame(frame_id, strategy)) {
+    EvictFrame(*frame_id, victim_page_id);
+    return true;
+  }
+
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+
+  // Every frame holding a page with pin count 0 is evictable in the replacer, so an empty free list plus a failed
+  // eviction means that all frames are pinned.
+  if (!replacer_->Evict(frame_id)) {
+    return false;
+  }
+  EvictFrame(*frame_id, victim_page_id);
+  return true;
+}
+
+auto BufferPoolManagerInstance::AcquireRingFrame(frame_id_t *frame_id, BufferAccessStrategy *strategy) -> bool {
+  auto ring_page_id = strategy->CurrentPage();
+  if (ring_page_id == INVALID_PAGE_ID || !page_table_->Find(ring_page_id, *frame_id)) {
+    return false;
+  }
+  const auto &page = pages_[*frame_id];
+  if (page.pin_count_ > 0 || io_in_progress_[*frame_id]) {
+    return false;
+  }
+  // Writing back a dirty page is fine for a bulk write, but a bulk read leaves pages somebody else modified to the
+  // regular replacement policy.
+  if (page.is_dirty_ && strategy->GetType() == BufferAccessStrategy::Type::BULK_READ) {
+    return false;
+  }
+  replacer_->Remove(*frame_id);
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+auto BufferPoolManagerInstance::AdmitPage(page_id_t page_id, page_id_t *rival_page_id) -> bool {
+  if (admission_filter_ == nullptr || !free_list_.empty()) {
+    return true;
+  }
+  auto candidates = replacer_->GetEvictionCandidates(1);
+  if (candidates.empty()) {
+    return true;
+  }
+  *rival_page_id = pages_[candidates[0]].page_id_;
+  return admission_filter_->Admit(page_id, *rival_page_id);
+}
+
+auto BufferPoolManagerInstance::AcquireProbationFrame(page_id_t rival_page_id, frame_id_t *frame_id,
+                                                      page_id_t *victim_page_id) -> bool {
+  *victim_page_id = INVALID_PAGE_ID;
+  // Until the area is full, a page on probation gets a regular victim's frame, like an access strategy's ring.
+  while (probation_.size() >= probation_size_) {
+    auto page_id = probation_.front();
+    probation_.pop_front();
+    if (!page_table_->Find(page_id, *frame_id) || !on_probation_[*frame_id]) {
+      continue;
+    }
+    // A page that is in use, or that became popular while on probation, has earned its place in the pool.
+    if (pages_[*frame_id].pin_count_ > 0 || io_in_progress_[*frame_id] ||
+        admission_filter_->Admit(page_id, rival_page_id)) {
+      on_probation_[*frame_id] = false;
+      continue;
+    }
+    replacer_->Remove(*frame_id);
+    EvictFrame(*frame_id, victim_page_id);
+    return true;
+  }
+  return false;
+}
+
+void BufferPoolManagerInstance::EvictFrame(frame_id_t frame_id, page_id_t *victim_page_id) {
+  page_id_t evicted_page_id = pages_[frame_id].GetPageId();
+  evictions_.fetch_add(1, std::memory_order_relaxed);
+  if (pages_[frame_id].IsDirty()) {
+    dirty_writebacks_.fetch_add(1, std::memory_order_relaxed);
+    *victim_page_id = evicted_page_id;
+    writeback_pages_[evicted_page_id] = frame_id;
+    SetDirty(frame_id, false);
+  } else if (cleaned_[frame_id]) {
+    writebacks_avoided_.fetch_add(1, std::memory_order_relaxed);
+  }
+  page_table_->Remove(evicted_page_id);
+}
+
+void BufferPoolManagerInstance::InstallPage(page_id_t page_id, frame_id_t frame_id) {
+  page_table_->Insert(page_id, frame_id);
+
+  // Until the load is done, optimistic readers that found the frame without a pin fail to start or to validate
+  pages_[frame_id].BeginFrameChange();
+  pages_[frame_id].page_id_.store(page_id, std::memory_order_relaxed);
+  pages_[frame_id].pin_count_ = 1;
+  pages_[frame_id].page_type_.store(PageType::UNKNOWN, std::memory_order_relaxed);
+  io_in_progress_[frame_id] = true;
+  cleaned_[frame_id] = false;
+  on_probation_[frame_id] = false;
+  ResetSwips(frame_id);
+
+  replacer_->RecordAccess(frame_id, page_id);
+  replacer_->SetEvictable(frame_id, false);
+}
+
+void BufferPoolManagerInstance::EnableSwizzling() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (swips_ != nullptr) {
+    return;
+  }
+  swips_ = std::make_unique<std::atomic<frame_id_t>[]>(pool_size_ * SWIP_SLOTS);
+  for (size_t i = 0; i < pool_size_; i++) {
+    pages_[i].swips_ = &swips_[i * SWIP_SLOTS];
+    ResetSwips(static_cast<frame_id_t>(i));
+  }
+}
+
+void BufferPoolManagerInstance::EnableAdmissionFilter() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (admission_filter_ != nullptr) {
+    return;
+  }
+  admission_filter_ = std::make_unique<TinyLfu>(pool_size_);
+  probation_size_ = std::max<size_t>(1, pool_size_ / PROBATION_DIVISOR);
+}
+
+void BufferPoolManagerInstance::ResetSwips(frame_id_t frame_id) {
+  auto *swips = pages_[frame_id].swips_;
+  if (swips == nullptr) {
+    return;
+  }
+  for (size_t i = 0; i < SWIP_SLOTS; i++) {
+    swips[i].store(INVALID_FRAME_ID, std::memory_order_relaxed);
+  }
+}
+
+void BufferPoolManagerInstance::LoadFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id,
+                                          page_id_t victim_page_id, bool read_page) {
+  // A fresh page in a clean frame needs no disk I/O, so don't bother dropping the latch.
+  if (victim_page_id == INVALID_PAGE_ID && !read_page) {
+    pages_[frame_id].ResetMemory();
+    io_in_progress_[frame_id] = false;
+    pages_[frame_id].EndFrameChange();
+    return;
+  }
+
+  // The frame is pinned and marked as I/O in progress, so nobody else touches its data until we are done.
+  lock->unlock();
+  if (victim_page_id != INVALID_PAGE_ID) {
+    disk_manager_->WritePage(victim_page_id, pages_[frame_id].GetData());
+  }
+  if (read_page) {
+    disk_manager_->ReadPage(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
+  } else {
+    pages_[frame_id].ResetMemory();
+  }
+  lock->lock();
+
+  if (victim_page_id != INVALID_PAGE_ID) {
+    writeback_pages_.erase(victim_page_id);
+  }
+  io_in_progress_[frame_id] = false;
+  pages_[frame_id].EndFrameChange();
+  frame_cv_[frame_id].notify_all();
+}
+
+void BufferPoolManagerInstance::PrefetchPage(page_id_t page_id) {
+  if (!disk_manager_->IsAllocated(page_id)) {
+    return;
+  }
+
+  std::scoped_lock<std::mutex> lock(prefetch_latch_);
+  if (prefetch_queue_.size() >= PREFETCH_QUEUE_SIZE) {
+    return;
+  }
+  if (prefetch_thread_ == nullptr) {
+    enable_prefetcher_ = true;
+    prefetch_thread_ = new std::thread(&BufferPoolManagerInstance::RunPrefetcher, this);
+  }
+  prefetch_queue_.push_back(page_id);
+  prefetch_cv_.notify_one();
+}
+
+auto BufferPoolManagerInstance::PeekNextPageId(page_id_t page_id, next_page_id_fn next_page_id) -> page_id_t {
+  std::unique_lock<std::mutex> lock(latch_);
+  frame_id_t frame_id;
+  if (!page_table_->Find(page_id, frame_id) || io_in_progress_[frame_id]) {
+    return INVALID_PAGE_ID;
+  }
+  auto &page = pages_[frame_id];
+  page.pin_count_++;
+  replacer_->SetEvictable(frame_id, false);
+  lock.unlock();
+
+  // Never wait for the page latch: the caller is a scan that holds the latch of an earlier page in the chain
+  page_id_t next = INVALID_PAGE_ID;
+  auto version = page.version_.load(std::memory_order_acquire);
+  if ((version & 1) == 0) {
+    next = next_page_id(&page);
+    if (!page.ValidateOptimisticLatch(version)) {
+      next = INVALID_PAGE_ID;
+    }
+  }
+
+  lock.lock();
+  page.pin_count_--;
+  if (page.pin_count_ == 0) {
+    replacer_->SetEvictable(frame_id, true);
+  }
+  return next;
+}
+
+void BufferPoolManagerInstance::StopPrefetcher() {
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    if (prefetch_thread_ == nullptr) {
+      return;
+    }
+    enable_prefetcher_ = false;
+    prefetch_cv_.notify_one();
+  }
+  prefetch_thread_->join();
+  delete prefetch_thread_;
+  prefetch_thread_ = nullptr;
+}
+
+void BufferPoolManagerInstance::RunPrefetcher() {
+  while (true) {
+    std::vector<page_id_t> page_ids;
+    {
+      std::unique_lock<std::mutex> lock(prefetch_latch_);
+      prefetch_cv_.wait(lock, [&] { return !enable_prefetcher_ || !prefetch_queue_.empty(); });
+      if (!enable_prefetcher_) {
+        return;
+      }
+      while (!prefetch_queue_.empty() && page_ids.size() < IO_BATCH_SIZE) {
+        page_ids.push_back(prefetch_queue_.front());
+        prefetch_queue_.pop_front();
+      }
+    }
+    LoadPrefetchedPages(page_ids);
+  }
+}
+
+void BufferPoolManagerInstance::LoadPrefetchedPages(const std::vector<page_id_t> &page_ids) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  // Install every page like a regular miss, so that fetches of it wait for the read
+  std::vector<frame_id_t> frame_ids;
+  std::vector<page_id_t> victim_page_ids;
+  std::vector<DiskRequest> writes;
+  std::vector<DiskRequest> reads;
+  // The frames stay pinned until the whole batch is read. Leave at least half of the frames that could be had to the
+  // fetches the batch is meant to speed up, or a small pool fails them.
+  size_t max_frames = (free_list_.size() + replacer_->Size()) / 2;
+  for (auto page_id : page_ids) {
+    frame_id_t frame_id;
+    // A page deleted since it was queued may be allocated again by NewPage(), which must not find it in the pool
+    if (page_table_->Find(page_id, frame_id) || writeback_pages_.count(page_id) != 0 ||
+        !disk_manager_->IsAllocated(page_id)) {
+      continue;
+    }
+    page_id_t victim_page_id;
+    if (frame_ids.size() >= max_frames || !AcquireFrame(&frame_id, &victim_page_id)) {
+      break;
+    }
+    InstallPage(page_id, frame_id);
+    frame_ids.push_back(frame_id);
+    if (victim_page_id != INVALID_PAGE_ID) {
+      victim_page_ids.push_back(victim_page_id);
+      writes.push_back({true, pages_[frame_id].GetData(), victim_page_id, {}});
+    }
+    reads.push_back({false, pages_[frame_id].GetData(), page_id, {}});
+  }
+  if (frame_ids.empty()) {
+    return;
+  }
+
+  // All the victims are written back at once, and must be on disk before their frames are overwritten by the reads
+  lock.unlock();
+  PerformBatch(disk_manager_, &writes);
+  PerformBatch(disk_manager_, &reads);
+  lock.lock();
+
+  // Drop our pins so that the pages are evictable until somebody fetches them
+  for (auto victim_page_id : victim_page_ids) {
+    writeback_pages_.erase(victim_page_id);
+  }
+  for (auto frame_id : frame_ids) {
+    io_in_progress_[frame_id] = false;
+    pages_[frame_id].EndFrameChange();
+    frame_cv_[frame_id].notify_all();
+    pages_[frame_id].pin_count_--;
+    if (pages_[frame_id].pin_count_ == 0) {
+      replacer_->SetEvictable(frame_id, true);
+    }
+  }
+  pages_prefetched_.fetch_add(frame_ids.size(), std::memory_order_relaxed);
+}
+
+void BufferPoolManagerInstance::SetDirty(frame_id_t frame_id, bool is_dirty) {
+  if (pages_[frame_id].is_dirty_ == is_dirty) {
+    return;
+  }
+  pages_[frame_id].is_dirty_ = is_dirty;
+  if (is_dirty) {
+    dirty_frames_.fetch_add(1, std::memory_order_relaxed);
+    cleaned_[frame_id] = false;
+  } else {
+    dirty_frames_.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void BufferPoolManagerInstance::StartPageCleaner() {
+  if (page_cleaner_thread_ != nullptr) {
+    return;
+  }
+  enable_page_cleaner_ = true;
+  page_cleaner_thread_ = new std::thread(&BufferPoolManagerInstance::RunPageCleaner, this);
+}
+
+void BufferPoolManagerInstance::StopPageCleaner() {
+  if (page_cleaner_thread_ == nullptr) {
+    return;
+  }
+  enable_page_cleaner_ = false;
+  page_cleaner_thread_->join();
+  delete page_cleaner_thread_;
+  page_cleaner_thread_ = nullptr;
+}
+
+void BufferPoolManagerInstance::RunPageCleaner() {
+  const auto lookahead = std::max<size_t>(1, static_cast<size_t>(pool_size_ * PAGE_CLEANER_LOOKAHEAD));
+  while (enable_page_cleaner_) {
+    // Throttle on the dirty ratio: a mostly clean pool gets a trickle of writes, a pool at or above the high watermark
+    // gets the full lookahead every round without sleeping in between.
+    auto dirty_ratio = GetDirtyRatio();
+    auto max_writes = std::max<size_t>(
+        1, static_cast<size_t>(lookahead * std::min(1.0, dirty_ratio / PAGE_CLEANER_HIGH_WATERMARK)));
+
+    size_t writes = 0;
+    if (dirty_ratio > 0) {
+      std::unique_lock<std::mutex> lock(latch_);
+      std::vector<frame_id_t> batch;
+      for (auto frame_id : replacer_->GetEvictionCandidates(lookahead)) {
+        if (writes == max_writes || !enable_page_cleaner_) {
+          break;
+        }
+        auto &page = pages_[frame_id];
+        if (!page.is_dirty_ || io_in_progress_[frame_id] || page.pin_count_ > 0 || page.page_id_ == INVALID_PAGE_ID) {
+          continue;
+        }
+        PinForWriteBack(frame_id);
+        batch.push_back(frame_id);
+        writes++;
+        if (batch.size() == IO_BATCH_SIZE) {
+          CleanFrames(&lock, batch);
+          batch.clear();
+        }
+      }
+      CleanFrames(&lock, batch);
+    }
+
+    if (writes == 0 || dirty_ratio < PAGE_CLEANER_HIGH_WATERMARK) {
+      std::this_thread::sleep_for(page_cleaner_interval);
+    }
+  }
+}
+
+void BufferPoolManagerInstance::CleanFrames(std::unique_lock<std::mutex> *lock,
+                                            const std::vector<frame_id_t> &frame_ids) {
+  WriteBackFrames(lock, frame_ids);
+  for (auto frame_id : frame_ids) {
+    cleaned_[frame_id] = !pages_[frame_id].is_dirty_;
+  }
+  pages_cleaned_.fetch_add(frame_ids.size(), std::memory_order_relaxed);
+}
+
+void BufferPoolManagerInstance::PinForWriteBack(frame_id_t frame_id) {
+  // Pin the page so that it stays in this frame, and clear the dirty flag up front: a writer that modifies the page
+  // after we read it marks it dirty again when it unpins.
+  pages_[frame_id].pin_count_++;
+  replacer_->SetEvictable(frame_id, false);
+  SetDirty(frame_id, false);
+}
+
+void BufferPoolManagerInstance::WriteBackFrames(std::unique_lock<std::mutex> *lock,
+                                                const std::vector<frame_id_t> &frame_ids) {
+  if (frame_ids.empty()) {
+    return;
+  }
+
+  lock->unlock();
+  // A pinned page may still be modified by its writers. Each page is copied out under its read latch rather than
+  // written while latched, so that we never hold one page latch while waiting for another.
+  std::vector<char> copies(frame_ids.size() * BUSTUB_PAGE_SIZE);
+  std::vector<DiskRequest> writes;
+  writes.reserve(frame_ids.size());
+  for (size_t i = 0; i < frame_ids.size(); i++) {
+    auto &page = pages_[frame_ids[i]];
+    char *data = &copies[i * BUSTUB_PAGE_SIZE];
+    page.RLatch();
+    std::memcpy(data, page.GetData(), BUSTUB_PAGE_SIZE);
+    page.RUnlatch();
+    writes.push_back({true, data, page.GetPageId(), {}});
+  }
+  PerformBatch(disk_manager_, &writes);
+  lock->lock();
+
+  for (auto frame_id : frame_ids) {
+    pages_[frame_id].pin_count_--;
+    if (pages_[frame_id].pin_count_ == 0) {
+      replacer_->SetEvictable(frame_id, true);
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
+  std::vector<page_id_t> skipped;
+  page_id_t page_id;
+  while (true) {
+    page_id = disk_manager_->AllocatePage(num_instances_, instance_index_);
+    ValidatePageId(page_id);
+    frame_id_t frame_id;
+    if (!page_table_->Find(page_id, frame_id)) {
+      if (writeback_pages_.count(page_id) == 0) {
+        break;
+      }
+    } else if (pages_[frame_id].pin_count_ == 0) {
+      // The copy is of the deleted page, there is nothing worth writing back
+      DiscardFrame(frame_id);
+      break;
+    }
+    skipped.push_back(page_id);
+  }
+  // Handed out again once their stale copies are gone
+  for (auto skipped_page_id : skipped) {
+    DeallocatePage(skipped_page_id);
+  }
+  return page_id;
+}
+
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+}
 
 }  // namespace bustub
@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include "fmt/format.h"
+
+namespace bustub {
+
+static auto PageTypeName(PageType page_type) -> const char * {
+  switch (page_type) {
+    case PageType::HEADER:
+      return "header";
+    case PageType::TABLE:
+      return "table";
+    case PageType::INDEX:
+      return "index";
+    case PageType::UNKNOWN:
+      break;
+  }
+  return "unknown";
+}
+
+auto BufferPoolStats::HitRatio() const -> double {
+  auto lookups = hits_ + misses_;
+  return lookups == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(lookups);
+}
+
+auto BufferPoolStats::operator+=(const BufferPoolStats &other) -> BufferPoolStats & {
+  pool_size_ += other.pool_size_;
+  fetches_ += other.fetches_;
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  new_pages_ += other.new_pages_;
+  failed_requests_ += other.failed_requests_;
+  evictions_ += other.evictions_;
+  dirty_writebacks_ += other.dirty_writebacks_;
+  pages_cleaned_ += other.pages_cleaned_;
+  writebacks_avoided_ += other.writebacks_avoided_;
+  pages_prefetched_ += other.pages_prefetched_;
+  swizzled_fetches_ += other.swizzled_fetches_;
+  admissions_rejected_ += other.admissions_rejected_;
+  free_frames_ += other.free_frames_;
+  pinned_frames_ += other.pinned_frames_;
+  dirty_frames_ += other.dirty_frames_;
+  page_table_bytes_ += other.page_table_bytes_;
+  for (size_t i = 0; i < NUM_PAGE_TYPES; i++) {
+    resident_pages_[i] += other.resident_pages_[i];
+  }
+  return *this;
+}
+
+auto BufferPoolStats::ToRows() const -> std::vector<std::pair<std::string, std::string>> {
+  std::vector<std::pair<std::string, std::string>> rows{
+      {"pool_size", std::to_string(pool_size_)},
+      {"fetches", std::to_string(fetches_)},
+      {"hits", std::to_string(hits_)},
+      {"misses", std::to_string(misses_)},
+      {"hit_ratio", fmt::format("{:.4f}", HitRatio())},
+      {"new_pages", std::to_string(new_pages_)},
+      {"failed_requests", std::to_string(failed_requests_)},
+      {"evictions", std::to_string(evictions_)},
+      {"dirty_writebacks", std::to_string(dirty_writebacks_)},
+      {"pages_cleaned", std::to_string(pages_cleaned_)},
+      {"writebacks_avoided", std::to_string(writebacks_avoided_)},
+      {"pages_prefetched", std::to_string(pages_prefetched_)},
+      {"swizzled_fetches", std::to_string(swizzled_fetches_)},
+      {"admissions_rejected", std::to_string(admissions_rejected_)},
+      {"free_frames", std::to_string(free_frames_)},
+      {"pinned_frames", std::to_string(pinned_frames_)},
+      {"dirty_frames", std::to_string(dirty_frames_)},
+      {"page_table_bytes", std::to_string(page_table_bytes_)},
+  };
+  for (size_t i = 0; i < NUM_PAGE_TYPES; i++) {
+    rows.emplace_back(fmt::format("resident_{}_pages", PageTypeName(static_cast<PageType>(i))),
+                      std::to_string(resident_pages_[i]));
+  }
+  return rows;
+}
+
+auto BufferPoolStats::ToString() const -> std::string {
+  std::string result;
+  for (const auto &[name, value] : ToRows()) {
+    result += fmt::format("{}: {}\n", name, value);
+  }
+  return result;
+}
+
+}  // namespace bustub
@@ -0,0 +1,216 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.cpp
+//
+// Identification: src/buffer/clock_pro_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/clock_pro_replacer.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+ClockProReplacer::ClockProReplacer(size_t num_frames)
+    : replacer_size_(num_frames), cold_target_(std::max<size_t>(1, num_frames / 4)), frames_(num_frames) {}
+
+auto ClockProReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  if (num_evictable_ == 0) {
+    return false;
+  }
+  while (true) {
+    // Keep the hot frames within their share, and make sure the cold hand has something to evict. Every evictable frame
+    // is either cold or hot, so the hot hand eventually demotes one if none is cold.
+    while (num_hot_ > 0 && (num_hot_ + cold_target_ > replacer_size_ || num_cold_evictable_ == 0)) {
+      RunHandHot();
+    }
+    if (RunHandCold(frame_id)) {
+      return true;
+    }
+  }
+}
+
+void ClockProReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  auto &frame = frames_[frame_id];
+  if (frame.is_tracked_) {
+    frame.referenced_ = true;
+    return;
+  }
+
+  frame.is_tracked_ = true;
+  frame.page_id_ = page_id;
+  auto it = page_id == INVALID_PAGE_ID ? test_page_map_.end() : test_page_map_.find(page_id);
+  if (it == test_page_map_.end()) {
+    frame.in_test_ = true;
+    return;
+  }
+  // The page came back within its test period: its reuse distance is short, and cold pages deserve more room.
+  test_pages_.erase(it->second);
+  test_page_map_.erase(it);
+  cold_target_ = std::min(cold_target_ + 1, std::max<size_t>(1, replacer_size_ - 1));
+  SetHot(frame_id, true);
+}
+
+void ClockProReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  auto &frame = frames_[frame_id];
+  if (!frame.is_tracked_ || frame.is_evictable_ == set_evictable) {
+    return;
+  }
+  frame.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    num_evictable_++;
+    num_cold_evictable_ += frame.is_hot_ ? 0 : 1;
+  } else {
+    num_evictable_--;
+    num_cold_evictable_ -= frame.is_hot_ ? 0 : 1;
+  }
+}
+
+void ClockProReplacer::Remove(frame_id_t frame_id) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  const auto &frame = frames_[frame_id];
+  if (!frame.is_tracked_) {
+    return;
+  }
+  if (!frame.is_evictable_) {
+    throw Exception(ExceptionType::INVALID, "cannot remove a non-evictable frame");
+  }
+  Untrack(frame_id);
+}
+
+auto ClockProReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return num_evictable_;
+}
+
+auto ClockProReplacer::GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  // The frames the cold hand would evict on its current sweep, without moving it.
+  std::vector<frame_id_t> candidates;
+  for (size_t i = 0; i < replacer_size_ && candidates.size() < max_frames; i++) {
+    auto frame_id = static_cast<frame_id_t>((hand_cold_ + i) % replacer_size_);
+    const auto &frame = frames_[frame_id];
+    if (frame.is_tracked_ && frame.is_evictable_ && !frame.is_hot_ && !frame.referenced_) {
+      candidates.push_back(frame_id);
+    }
+  }
+  return candidates;
+}
+
+auto ClockProReplacer::GetColdTarget() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return cold_target_;
+}
+
+void ClockProReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "invalid frame id");
+  }
+}
+
+auto ClockProReplacer::RunHandCold(frame_id_t *frame_id) -> bool {
+  auto current = static_cast<frame_id_t>(hand_cold_);
+  hand_cold_ = (hand_cold_ + 1) % replacer_size_;
+  auto &frame = frames_[current];
+  if (!frame.is_tracked_ || frame.is_hot_ || !frame.is_evictable_) {
+    return false;
+  }
+
+  if (frame.referenced_) {
+    frame.referenced_ = false;
+    if (frame.in_test_) {
+      frame.in_test_ = false;
+      SetHot(current, true);
+    } else {
+      frame.in_test_ = true;
+    }
+    return false;
+  }
+
+  if (frame.in_test_ && frame.page_id_ != INVALID_PAGE_ID) {
+    AddTestPage(frame.page_id_);
+  }
+  Untrack(current);
+  *frame_id = current;
+  return true;
+}
+
+void ClockProReplacer::RunHandHot() {
+  auto current = static_cast<frame_id_t>(hand_hot_);
+  hand_hot_ = (hand_hot_ + 1) % replacer_size_;
+  auto &frame = frames_[current];
+  if (!frame.is_tracked_) {
+    return;
+  }
+
+  if (frame.is_hot_) {
+    if (frame.referenced_) {
+      frame.referenced_ = false;
+    } else {
+      SetHot(current, false);
+    }
+  } else if (frame.in_test_ && !frame.referenced_) {
+    // The test period ran out without a reuse.
+    frame.in_test_ = false;
+    ShrinkColdTarget();
+  }
+}
+
+void ClockProReplacer::SetHot(frame_id_t frame_id, bool is_hot) {
+  auto &frame = frames_[frame_id];
+  if (frame.is_hot_ == is_hot) {
+    return;
+  }
+  frame.is_hot_ = is_hot;
+  if (is_hot) {
+    num_hot_++;
+    num_cold_evictable_ -= frame.is_evictable_ ? 1 : 0;
+  } else {
+    num_hot_--;
+    num_cold_evictable_ += frame.is_evictable_ ? 1 : 0;
+  }
+}
+
+void ClockProReplacer::Untrack(frame_id_t frame_id) {
+  auto &frame = frames_[frame_id];
+  if (frame.is_hot_) {
+    num_hot_--;
+  }
+  if (frame.is_evictable_) {
+    num_evictable_--;
+    if (!frame.is_hot_) {
+      num_cold_evictable_--;
+    }
+  }
+  frame = FrameEntry{};
+}
+
+void ClockProReplacer::AddTestPage(page_id_t page_id) {
+  test_pages_.push_front(page_id);
+  test_page_map_[page_id] = test_pages_.begin();
+  if (test_pages_.size() > replacer_size_) {
+    test_page_map_.erase(test_pages_.back());
+    test_pages_.pop_back();
+    ShrinkColdTarget();
+  }
+}
+
+}  // namespace bustub
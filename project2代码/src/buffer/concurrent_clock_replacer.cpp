@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_clock_replacer.cpp
+//
+// Identification: src/buffer/concurrent_clock_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/concurrent_clock_replacer.h"
+
+#include "common/exception.h"
+
+namespace bustub {
+
+ConcurrentClockReplacer::ConcurrentClockReplacer(size_t num_frames)
+    : replacer_size_(num_frames), state_(std::make_unique<std::atomic<uint8_t>[]>(num_frames)) {
+  for (size_t i = 0; i < replacer_size_; i++) {
+    state_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+auto ConcurrentClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  // Two sweeps clear every reference bit, so a third one finds a victim unless other threads keep taking the evictable
+  // frames or touching them. Give up only when no frame is evictable anymore.
+  while (num_evictable_.load() > 0) {
+    for (size_t i = 0; i < 3 * replacer_size_; i++) {
+      auto current = hand_.fetch_add(1, std::memory_order_relaxed) % replacer_size_;
+      auto &state = state_[current];
+      auto observed = state.load();
+      if ((observed & (TRACKED | EVICTABLE)) != (TRACKED | EVICTABLE)) {
+        continue;
+      }
+      if ((observed & REFERENCED) != 0) {
+        // Losing this race to another thread only means the frame keeps or loses its second chance a bit early.
+        state.compare_exchange_strong(observed, static_cast<uint8_t>(observed & ~REFERENCED));
+        continue;
+      }
+      if (state.compare_exchange_strong(observed, 0)) {
+        num_evictable_.fetch_sub(1);
+        *frame_id = static_cast<frame_id_t>(current);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void ConcurrentClockReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  CheckFrameId(frame_id);
+  auto &state = state_[frame_id];
+  auto observed = state.load();
+  // The hit path of a hot page: the bit is already set, so leave the cache line alone.
+  if ((observed & (TRACKED | REFERENCED)) == (TRACKED | REFERENCED)) {
+    return;
+  }
+  while (true) {
+    auto desired = static_cast<uint8_t>((observed & TRACKED) != 0 ? observed | REFERENCED : TRACKED | REFERENCED);
+    if (state.compare_exchange_weak(observed, desired)) {
+      return;
+    }
+  }
+}
+
+void ConcurrentClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  CheckFrameId(frame_id);
+  // The count goes up before a frame becomes evictable and down after it stopped being evictable, so that it never
+  // drops below the number of evictable frames, even for a moment.
+  if (set_evictable) {
+    num_evictable_.fetch_add(1);
+  }
+  auto &state = state_[frame_id];
+  auto observed = state.load();
+  while (true) {
+    if ((observed & TRACKED) == 0 || ((observed & EVICTABLE) != 0) == set_evictable) {
+      if (set_evictable) {
+        num_evictable_.fetch_sub(1);
+      }
+      return;
+    }
+    if (state.compare_exchange_weak(observed, static_cast<uint8_t>(observed ^ EVICTABLE))) {
+      break;
+    }
+  }
+  if (!set_evictable) {
+    num_evictable_.fetch_sub(1);
+  }
+}
+
+void ConcurrentClockReplacer::Remove(frame_id_t frame_id) {
+  CheckFrameId(frame_id);
+  auto &state = state_[frame_id];
+  auto observed = state.load();
+  while (true) {
+    if ((observed & TRACKED) == 0) {
+      return;
+    }
+    if ((observed & EVICTABLE) == 0) {
+      throw Exception(ExceptionType::INVALID, "cannot remove a non-evictable frame");
+    }
+    if (state.compare_exchange_weak(observed, 0)) {
+      break;
+    }
+  }
+  num_evictable_.fetch_sub(1);
+}
+
+auto ConcurrentClockReplacer::Size() -> size_t { return num_evictable_.load(); }
+
+auto ConcurrentClockReplacer::GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  // The unreferenced frames ahead of the hand go first, the referenced ones after the hand came around once more. Other
+  // threads may change any of this right away; the result is a hint.
+  std::vector<frame_id_t> candidates;
+  std::vector<frame_id_t> referenced;
+  auto hand = hand_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < replacer_size_ && candidates.size() < max_frames; i++) {
+    auto current = (hand + i) % replacer_size_;
+    auto observed = state_[current].load(std::memory_order_relaxed);
+    if ((observed & (TRACKED | EVICTABLE)) != (TRACKED | EVICTABLE)) {
+      continue;
+    }
+    ((observed & REFERENCED) == 0 ? candidates : referenced).push_back(static_cast<frame_id_t>(current));
+  }
+  for (size_t i = 0; i < referenced.size() && candidates.size() < max_frames; i++) {
+    candidates.push_back(referenced[i]);
+  }
+  return candidates;
+}
+
+void ConcurrentClockReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "invalid frame id");
+  }
+}
+
+}  // namespace bustub
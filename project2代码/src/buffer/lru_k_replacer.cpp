@@ -12,126 +12,105 @@
 
 #include "buffer/lru_k_replacer.h"
 
+#include "common/exception.h"
+
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {}
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : replacer_size_(num_frames), k_(k), frames_(num_frames), history_(num_frames * k) {
+  BUSTUB_ASSERT(k > 0, "k must be at least 1");
+}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::scoped_lock<std::mutex> lock(latch_);
 
-  if (curr_size_ == 0) {
+  if (evictable_.empty()) {
     return false;
   }
 
-  for (auto it = history_list_.rbegin(); it != history_list_.rend(); it++) {
-    auto frame = *it;
-    if (is_evictable_[frame]) {
-      access_count_[frame] = 0;
-      history_list_.erase(history_map_[frame]);
-      history_map_.erase(frame);
-      *frame_id = frame;
-      curr_size_--;
-      is_evictable_[frame] = false;
-      return true;
-    }
-  }
-
-  for (auto it = cache_list_.rbegin(); it != cache_list_.rend(); it++) {
-    auto frame = *it;
-    if (is_evictable_[frame]) {
-      access_count_[frame] = 0;
-      cache_list_.erase(cache_map_[frame]);
-      cache_map_.erase(frame);
-      *frame_id = frame;
-      curr_size_--;
-      is_evictable_[frame] = false;
-      return true;
-    }
-  }
-
-  return false;
+  *frame_id = evictable_.begin()->second;
+  RemoveEvictable(*frame_id);
+  return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  CheckFrameId(frame_id);
   std::scoped_lock<std::mutex> lock(latch_);
 
-  if (frame_id > static_cast<int>(replacer_size_)) {
-    throw std::exception();
+  auto &frame = frames_[frame_id];
+  // The frame's key changes with its history, so take it out of the index while the history is updated.
+  if (frame.is_evictable_) {
+    evictable_.erase(GetEvictionKey(frame_id));
   }
-
-  access_count_[frame_id]++;
-
-  if (access_count_[frame_id] == k_) {
-    auto it = history_map_[frame_id];
-    history_list_.erase(it);
-    history_map_.erase(frame_id);
-
-    cache_list_.push_front(frame_id);
-    cache_map_[frame_id] = cache_list_.begin();
-  } else if (access_count_[frame_id] > k_) {
-    if (cache_map_.count(frame_id) != 0U) {
-      auto it = cache_map_[frame_id];
-      cache_list_.erase(it);
-    }
-    cache_list_.push_front(frame_id);
-    cache_map_[frame_id] = cache_list_.begin();
-  } else {
-    if (history_map_.count(frame_id) == 0U) {
-      history_list_.push_front(frame_id);
-      history_map_[frame_id] = history_list_.begin();
-    }
+  history_[frame_id * k_ + frame.access_count_ % k_] = current_timestamp_++;
+  frame.access_count_++;
+  if (frame.is_evictable_) {
+    evictable_.emplace(GetEvictionKey(frame_id), frame_id);
   }
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  CheckFrameId(frame_id);
   std::scoped_lock<std::mutex> lock(latch_);
-  if (frame_id > static_cast<int>(replacer_size_)) {
-    throw std::exception();
-  }
 
-  if (access_count_[frame_id] == 0) {
+  auto &frame = frames_[frame_id];
+  if (frame.access_count_ == 0 || frame.is_evictable_ == set_evictable) {
     return;
   }
 
-  if (!is_evictable_[frame_id] && set_evictable) {
-    curr_size_++;
-  }
-  if (is_evictable_[frame_id] && !set_evictable) {
-    curr_size_--;
+  if (set_evictable) {
+    evictable_.emplace(GetEvictionKey(frame_id), frame_id);
+  } else {
+    evictable_.erase(GetEvictionKey(frame_id));
   }
-  is_evictable_[frame_id] = set_evictable;
+  frame.is_evictable_ = set_evictable;
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
+  CheckFrameId(frame_id);
   std::scoped_lock<std::mutex> lock(latch_);
 
-  if (frame_id > static_cast<int>(replacer_size_)) {
-    throw std::exception();
-  }
-
-  auto cnt = access_count_[frame_id];
-  if (cnt == 0) {
+  const auto &frame = frames_[frame_id];
+  if (frame.access_count_ == 0) {
     return;
   }
-  if (!is_evictable_[frame_id]) {
-    throw std::exception();
-  }
-  if (cnt < k_) {
-    history_list_.erase(history_map_[frame_id]);
-    history_map_.erase(frame_id);
-
-  } else {
-    cache_list_.erase(cache_map_[frame_id]);
-    cache_map_.erase(frame_id);
+  if (!frame.is_evictable_) {
+    throw Exception(ExceptionType::INVALID, "cannot remove a non-evictable frame");
   }
-  curr_size_--;
-  access_count_[frame_id] = 0;
-  is_evictable_[frame_id] = false;
+  RemoveEvictable(frame_id);
 }
 
 auto LRUKReplacer::Size() -> size_t {
   std::scoped_lock<std::mutex> lock(latch_);
-  return curr_size_;
+  return evictable_.size();
+}
+
+auto LRUKReplacer::GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> candidates;
+  for (auto it = evictable_.begin(); it != evictable_.end() && candidates.size() < max_frames; it++) {
+    candidates.push_back(it->second);
+  }
+  return candidates;
+}
+
+void LRUKReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "invalid frame id");
+  }
+}
+
+auto LRUKReplacer::GetEvictionKey(frame_id_t frame_id) const -> EvictionKey {
+  auto access_count = frames_[frame_id].access_count_;
+  // Until the frame has k accesses its oldest one is in slot 0; after that it is the slot written next.
+  auto oldest_slot = access_count < k_ ? 0 : access_count % k_;
+  return {access_count >= k_, history_[frame_id * k_ + oldest_slot]};
+}
+
+void LRUKReplacer::RemoveEvictable(frame_id_t frame_id) {
+  evictable_.erase(GetEvictionKey(frame_id));
+  frames_[frame_id] = FrameEntry{};
 }
 
 }  // namespace bustub
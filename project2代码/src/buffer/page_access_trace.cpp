@@ -0,0 +1,36 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_access_trace.cpp
+//
+// Identification: src/buffer/page_access_trace.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_access_trace.h"
+
+namespace bustub {
+
+void PageAccessTrace::Record(EventType type, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  *out_ << static_cast<char>(type) << ' ' << page_id << '\n';
+}
+
+auto PageAccessTrace::Read(std::istream *in) -> std::vector<Event> {
+  std::vector<Event> events;
+  char type;
+  page_id_t page_id;
+  while (*in >> type >> page_id) {
+    if (type != static_cast<char>(EventType::FETCH) && type != static_cast<char>(EventType::NEW) &&
+        type != static_cast<char>(EventType::DELETE)) {
+      break;
+    }
+    events.push_back({static_cast<EventType>(type), page_id});
+  }
+  return events;
+}
+
+}  // namespace bustub
@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager,
+                                                     ReplacerType replacer_type)
+    : num_instances_(num_instances), pool_size_(pool_size) {
+  BUSTUB_ASSERT(num_instances_ > 0, "a parallel buffer pool needs at least one instance");
+  instances_.reserve(num_instances_);
+  for (size_t i = 0; i < num_instances_; i++) {
+    instances_.emplace_back(std::make_unique<BufferPoolManagerInstance>(
+        pool_size_, static_cast<uint32_t>(num_instances_), static_cast<uint32_t>(i), disk_manager, replacer_k,
+        log_manager, replacer_type));
+  }
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  BUSTUB_ASSERT(page_id >= 0, "invalid page id");
+  return instances_[static_cast<size_t>(page_id) % num_instances_].get();
+}
+
+auto ParallelBufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  for (auto &instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::PrefetchPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  GetBufferPoolManager(page_id)->PrefetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::PeekNextPageId(page_id_t page_id, next_page_id_fn next_page_id) -> page_id_t {
+  if (page_id == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  return GetBufferPoolManager(page_id)->PeekNextPageId(page_id, next_page_id);
+}
+
+void ParallelBufferPoolManager::SetAccessTrace(PageAccessTrace *trace) {
+  for (auto &instance : instances_) {
+    instance->SetAccessTrace(trace);
+  }
+}
+
+void ParallelBufferPoolManager::StartPageCleaner() {
+  for (auto &instance : instances_) {
+    instance->StartPageCleaner();
+  }
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (auto &instance : instances_) {
+    instance->StopPageCleaner();
+  }
+}
+
+void ParallelBufferPoolManager::EnableSwizzling() {
+  for (auto &instance : instances_) {
+    instance->EnableSwizzling();
+  }
+}
+
+void ParallelBufferPoolManager::EnableAdmissionFilter() {
+  for (auto &instance : instances_) {
+    instance->EnableAdmissionFilter();
+  }
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * { return NewPgWithStrategyImp(page_id, nullptr); }
+
+auto ParallelBufferPoolManager::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  if (strategy == nullptr) {
+    return FetchPgImp(page_id);
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, *strategy);
+}
+
+auto ParallelBufferPoolManager::NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
+  auto start = next_instance_.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < num_instances_; i++) {
+    auto *instance = instances_[(start + i) % num_instances_].get();
+    auto *page = strategy == nullptr ? instance->NewPage(page_id) : instance->NewPage(page_id, *strategy);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::FetchChildPgImp(Page *parent, int slot, page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchChildPage(parent, slot, page_id);
+}
+
+auto ParallelBufferPoolManager::PeekChildPgImp(Page *parent, int slot, page_id_t page_id, uint64_t *version)
+    -> Page * {
+  return GetBufferPoolManager(page_id)->PeekChildPage(parent, slot, page_id, version);
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  for (auto &instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+}  // namespace bustub
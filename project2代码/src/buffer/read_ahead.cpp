@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead.cpp
+//
+// Identification: src/buffer/read_ahead.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/read_ahead.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+void ReadAheadDetector::OnPageAccess(page_id_t page_id, page_id_t next_page_id) {
+  if (page_id == INVALID_PAGE_ID || bpm_ == nullptr) {
+    return;
+  }
+
+  const bool on_chain = expected_page_id_ != INVALID_PAGE_ID && page_id == expected_page_id_;
+  contiguous_ = (!on_chain || contiguous_) && next_page_id == page_id + 1;
+  if (on_chain) {
+    run_length_++;
+  } else {
+    run_length_ = 0;
+  }
+  // Leaving the chain resets the window, and so does a step that shows the guesses wrong: the scan stays on the chain,
+  // but the window starts over from it
+  if (!on_chain || (!contiguous_ && guessed_ > 0)) {
+    window_ = READ_AHEAD_MIN_WINDOW;
+    frontier_ = INVALID_PAGE_ID;
+    ahead_ = 0;
+    filled_ = false;
+    guessed_ = 0;
+  }
+  expected_page_id_ = next_page_id;
+  if (ahead_ > 0) {
+    ahead_--;
+  }
+  guessed_ = std::min(guessed_, ahead_);
+
+  if (run_length_ < READ_AHEAD_TRIGGER || next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  // Refill once the scan has consumed half of the window, so that the reads stay ahead of it. Every refill after a
+  // full one doubles the window.
+  if (ahead_ > window_ / 2) {
+    return;
+  }
+  if (filled_) {
+    window_ = std::min(window_ * 2, READ_AHEAD_MAX_WINDOW);
+    filled_ = false;
+  }
+  if (ahead_ == 0) {
+    bpm_->PrefetchPage(next_page_id);
+    frontier_ = next_page_id;
+    ahead_ = 1;
+  }
+  // Walk the chain past the frontier through the pages that are in the pool already. A page still being read in ends
+  // the walk, the next call picks it up from there, unless the run is contiguous: then the ids after it are guessed.
+  bool guess = contiguous_;
+  while (ahead_ < window_) {
+    auto next = guessed_ > 0 ? INVALID_PAGE_ID : bpm_->PeekNextPageId(frontier_, next_page_id_);
+    if (next == INVALID_PAGE_ID) {
+      if (!guess) {
+        break;
+      }
+      next = frontier_ + 1;
+      guessed_++;
+    }
+    guess = guess && next == frontier_ + 1;
+    bpm_->PrefetchPage(next);
+    frontier_ = next;
+    ahead_++;
+  }
+  filled_ = ahead_ == window_;
+}
+
+}  // namespace bustub
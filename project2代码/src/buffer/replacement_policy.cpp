@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacement_policy.cpp
+//
+// Identification: src/buffer/replacement_policy.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacement_policy.h"
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_pro_replacer.h"
+#include "buffer/concurrent_clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
+#include "common/exception.h"
+
+namespace bustub {
+
+auto MakeReplacementPolicy(ReplacerType type, size_t num_frames, size_t k) -> std::unique_ptr<ReplacementPolicy> {
+  switch (type) {
+    case ReplacerType::LRU_K:
+      return std::make_unique<LRUKReplacer>(num_frames, k);
+    case ReplacerType::ARC:
+      return std::make_unique<ArcReplacer>(num_frames);
+    case ReplacerType::TWO_Q:
+      return std::make_unique<TwoQueueReplacer>(num_frames);
+    case ReplacerType::CLOCK_PRO:
+      return std::make_unique<ClockProReplacer>(num_frames);
+    case ReplacerType::CLOCK:
+      return std::make_unique<ConcurrentClockReplacer>(num_frames);
+  }
+  throw Exception(ExceptionType::INVALID, "unknown replacer type");
+}
+
+auto ReplacerTypeToString(ReplacerType type) -> std::string {
+  switch (type) {
+    case ReplacerType::LRU_K:
+      return "lru-k";
+    case ReplacerType::ARC:
+      return "arc";
+    case ReplacerType::TWO_Q:
+      return "2q";
+    case ReplacerType::CLOCK_PRO:
+      return "clock-pro";
+    case ReplacerType::CLOCK:
+      return "clock";
+  }
+  return "unknown";
+}
+
+}  // namespace bustub
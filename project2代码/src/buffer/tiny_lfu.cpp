@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tiny_lfu.cpp
+//
+// Identification: src/buffer/tiny_lfu.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/tiny_lfu.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+/** Odd multipliers, one per row, so that the rows hash independently. */
+static constexpr uint64_t ROW_SEEDS[] = {0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL,
+                                         0xD6E8FEB86659FD93ULL};
+
+TinyLfu::TinyLfu(size_t num_frames) : width_(64), sample_size_(10 * std::max(MIN_SAMPLE_FRAMES, num_frames)) {
+  // Four counters per frame keep collisions rare among the pages that matter, the resident ones and their rivals.
+  while (width_ < 4 * num_frames) {
+    width_ *= 2;
+  }
+  counters_.resize(DEPTH * width_);
+}
+
+void TinyLfu::RecordAccess(page_id_t page_id) {
+  size_t indexes[DEPTH];
+  uint8_t min_count = MAX_COUNT;
+  for (size_t row = 0; row < DEPTH; row++) {
+    indexes[row] = Index(page_id, row);
+    min_count = std::min(min_count, counters_[indexes[row]]);
+  }
+  if (min_count < MAX_COUNT) {
+    for (auto index : indexes) {
+      if (counters_[index] == min_count) {
+        counters_[index]++;
+      }
+    }
+  }
+
+  if (++additions_ >= sample_size_) {
+    Age();
+  }
+}
+
+auto TinyLfu::Estimate(page_id_t page_id) const -> uint32_t {
+  uint8_t min_count = MAX_COUNT;
+  for (size_t row = 0; row < DEPTH; row++) {
+    min_count = std::min(min_count, counters_[Index(page_id, row)]);
+  }
+  return min_count;
+}
+
+auto TinyLfu::Index(page_id_t page_id, size_t row) const -> size_t {
+  auto hash = (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) + row) * ROW_SEEDS[row];
+  // The high bits of a multiplicative hash are the well mixed ones.
+  return row * width_ + static_cast<size_t>((hash ^ (hash >> 29)) >> 32) % width_;
+}
+
+void TinyLfu::Age() {
+  for (auto &counter : counters_) {
+    counter >>= 1;
+  }
+  additions_ /= 2;
+}
+
+}  // namespace bustub
@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.cpp
+//
+// Identification: src/buffer/two_queue_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_queue_replacer.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_frames)
+    : replacer_size_(num_frames),
+      a1in_size_(std::max<size_t>(1, num_frames / 4)),
+      a1out_size_(std::max<size_t>(1, num_frames / 2)),
+      frames_(num_frames) {}
+
+auto TwoQueueReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> candidates;
+  CollectEvictable(PreferA1in() ? a1in_ : am_, 1, &candidates);
+  if (candidates.empty()) {
+    CollectEvictable(PreferA1in() ? am_ : a1in_, 1, &candidates);
+  }
+  if (candidates.empty()) {
+    return false;
+  }
+
+  *frame_id = candidates[0];
+  const auto &frame = frames_[*frame_id];
+  // Only pages that never made it to Am are remembered: a page evicted from Am has had its chance.
+  if (frame.queue_ == QueueType::A1IN && frame.page_id_ != INVALID_PAGE_ID) {
+    a1out_.push_front(frame.page_id_);
+    a1out_map_[frame.page_id_] = a1out_.begin();
+    if (a1out_.size() > a1out_size_) {
+      a1out_map_.erase(a1out_.back());
+      a1out_.pop_back();
+    }
+  }
+  Untrack(*frame_id);
+  return true;
+}
+
+void TwoQueueReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  auto &frame = frames_[frame_id];
+  if (frame.queue_ == QueueType::AM) {
+    am_.erase(frame.pos_);
+    am_.push_front(frame_id);
+    frame.pos_ = am_.begin();
+    return;
+  }
+  if (frame.queue_ == QueueType::A1IN) {
+    return;
+  }
+
+  frame.queue_ = QueueType::A1IN;
+  frame.page_id_ = page_id;
+  auto it = page_id == INVALID_PAGE_ID ? a1out_map_.end() : a1out_map_.find(page_id);
+  if (it != a1out_map_.end()) {
+    a1out_.erase(it->second);
+    a1out_map_.erase(it);
+    frame.queue_ = QueueType::AM;
+  }
+  auto &queue = GetQueue(frame.queue_);
+  queue.push_front(frame_id);
+  frame.pos_ = queue.begin();
+}
+
+void TwoQueueReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  auto &frame = frames_[frame_id];
+  if (frame.queue_ == QueueType::NONE || frame.is_evictable_ == set_evictable) {
+    return;
+  }
+  frame.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    num_evictable_++;
+  } else {
+    num_evictable_--;
+  }
+}
+
+void TwoQueueReplacer::Remove(frame_id_t frame_id) {
+  CheckFrameId(frame_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  const auto &frame = frames_[frame_id];
+  if (frame.queue_ == QueueType::NONE) {
+    return;
+  }
+  if (!frame.is_evictable_) {
+    throw Exception(ExceptionType::INVALID, "cannot remove a non-evictable frame");
+  }
+  Untrack(frame_id);
+}
+
+auto TwoQueueReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return num_evictable_;
+}
+
+auto TwoQueueReplacer::GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> candidates;
+  CollectEvictable(PreferA1in() ? a1in_ : am_, max_frames, &candidates);
+  CollectEvictable(PreferA1in() ? am_ : a1in_, max_frames, &candidates);
+  return candidates;
+}
+
+void TwoQueueReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "invalid frame id");
+  }
+}
+
+void TwoQueueReplacer::CollectEvictable(const std::list<frame_id_t> &queue, size_t max_frames,
+                                        std::vector<frame_id_t> *candidates) {
+  for (auto it = queue.rbegin(); it != queue.rend() && candidates->size() < max_frames; it++) {
+    if (frames_[*it].is_evictable_) {
+      candidates->push_back(*it);
+    }
+  }
+}
+
+void TwoQueueReplacer::Untrack(frame_id_t frame_id) {
+  auto &frame = frames_[frame_id];
+  GetQueue(frame.queue_).erase(frame.pos_);
+  if (frame.is_evictable_) {
+    num_evictable_--;
+  }
+  frame = FrameEntry{};
+}
+
+}  // namespace bustub
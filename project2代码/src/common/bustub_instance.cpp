@@ -12,6 +12,7 @@
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
 #include "common/bustub_instance.h"
@@ -31,6 +32,7 @@
 #include "planner/planner.h"
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/async_disk_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/disk/disk_manager_memory.h"
 #include "type/value_factory.h"
@@ -41,11 +43,25 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn) -> std::unique_ptr<Ex
   return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_);
 }
 
-BustubInstance::BustubInstance(const std::string &db_file_name) {
+/**
+ * Create the buffer pool manager of a BusTub instance. With more than one instance, the frames are split evenly
+ * between the shards of a ParallelBufferPoolManager.
+ */
+static auto MakeBufferPoolManager(size_t pool_size, size_t bpm_instances, DiskManager *disk_manager,
+                                  LogManager *log_manager) -> BufferPoolManager * {
+  if (bpm_instances <= 1) {
+    return new BufferPoolManagerInstance(pool_size, disk_manager, LRUK_REPLACER_K, log_manager);
+  }
+  auto pool_size_per_instance = (pool_size + bpm_instances - 1) / bpm_instances;
+  return new ParallelBufferPoolManager(bpm_instances, pool_size_per_instance, disk_manager, LRUK_REPLACER_K,
+                                       log_manager);
+}
+
+BustubInstance::BustubInstance(const std::string &db_file_name, size_t bpm_instances) {
   enable_logging = false;
 
-  // Storage related.
-  disk_manager_ = new DiskManager(db_file_name);
+  // Storage related. The buffer pool keeps many reads and writes in flight when it prefetches, cleans and flushes.
+  disk_manager_ = new AsyncDiskManager(db_file_name);
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
@@ -53,7 +69,7 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    buffer_pool_manager_ = MakeBufferPoolManager(128, bpm_instances, disk_manager_, log_manager_);
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -73,7 +89,7 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
 }
 
-BustubInstance::BustubInstance() {
+BustubInstance::BustubInstance(size_t bpm_instances) {
   enable_logging = false;
 
   // Storage related.
@@ -85,7 +101,7 @@ BustubInstance::BustubInstance() {
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    buffer_pool_manager_ = MakeBufferPoolManager(128, bpm_instances, disk_manager_, log_manager_);
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -146,6 +162,22 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayBufferPoolStats(ResultWriter &writer) {
+  auto stats = buffer_pool_manager_->GetStats();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("stat");
+  writer.WriteHeaderCell("value");
+  writer.EndHeader();
+  for (const auto &[name, value] : stats.ToRows()) {
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(value);
+    writer.EndRow();
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -159,6 +191,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\bpstats: show buffer pool statistics
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -191,6 +224,10 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\bpstats") {
+      CmdDisplayBufferPoolStats(writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
@@ -237,10 +274,22 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
         }
         auto key_schema = Schema::CopySchema(&index_stmt.table_->schema_, col_ids);
 
+        // Without `USING`, the parser asks for its default access method, art.
+        IndexType index_type;
+        if (index_stmt.index_type_ == "hash") {
+          index_type = IndexType::HashTableIndex;
+        } else if (index_stmt.index_type_ == "linear_probe") {
+          index_type = IndexType::LinearProbeHashTableIndex;
+        } else if (index_stmt.index_type_ == "btree" || index_stmt.index_type_ == "art") {
+          index_type = IndexType::BPlusTreeIndex;
+        } else {
+          throw NotImplementedException(fmt::format("unsupported index type {}", index_stmt.index_type_));
+        }
+
         std::unique_lock<std::shared_mutex> l(catalog_lock_);
         auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
             txn, index_stmt.index_name_, index_stmt.table_->table_, index_stmt.table_->schema_, key_schema, col_ids,
-            INTEGER_SIZE, IntegerHashFunctionType{});
+            INTEGER_SIZE, IntegerHashFunctionType{}, index_type);
         l.unlock();
 
         if (info == nullptr) {
@@ -391,6 +440,10 @@ BustubInstance::~BustubInstance() {
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
+  // Write back the pages and sync them along with the space maps, so that the database survives a restart
+  if (buffer_pool_manager_ != nullptr) {
+    buffer_pool_manager_->FlushAllPages();
+  }
   delete execution_engine_;
   delete catalog_;
   delete checkpoint_manager_;
@@ -0,0 +1,184 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.cpp
+//
+// Identification: src/common/util/crc32c.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define BUSTUB_HAVE_SSE42_CRC32C
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** The Castagnoli polynomial, bit-reversed. */
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+/** Bytes per stream in one round of the hardware loop; three streams run side by side. */
+constexpr size_t STREAM_LENGTH = 256;
+
+/** @return the product of a 32x32 matrix over GF(2), given as its columns, and a vector */
+auto MatrixTimes(const uint32_t *matrix, uint32_t vector) -> uint32_t {
+  uint32_t sum = 0;
+  for (; vector != 0; vector >>= 1, matrix++) {
+    if ((vector & 1) != 0) {
+      sum ^= *matrix;
+    }
+  }
+  return sum;
+}
+
+void MatrixSquare(uint32_t *square, const uint32_t *matrix) {
+  for (int n = 0; n < 32; n++) {
+    square[n] = MatrixTimes(matrix, matrix[n]);
+  }
+}
+
+/** The lookup tables, built on first use. */
+struct Crc32cTables {
+  /** Slicing-by-8: slices_[k][b] is the checksum of byte b followed by k zero bytes. */
+  uint32_t slices_[8][256];
+  /** The operator that appends STREAM_LENGTH zero bytes to a checksum, one table per byte of the checksum. */
+  uint32_t shift_[4][256];
+
+  Crc32cTables() {
+    for (uint32_t b = 0; b < 256; b++) {
+      uint32_t crc = b;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+      }
+      slices_[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+      for (int k = 1; k < 8; k++) {
+        slices_[k][b] = (slices_[k - 1][b] >> 8) ^ slices_[0][slices_[k - 1][b] & 0xFF];
+      }
+    }
+
+    // Square the operator for one zero bit until it appends STREAM_LENGTH zero bytes
+    uint32_t odd[32];
+    uint32_t even[32];
+    odd[0] = CRC32C_POLY;
+    for (int n = 1; n < 32; n++) {
+      odd[n] = 1U << (n - 1);
+    }
+    MatrixSquare(even, odd);  // two zero bits
+    MatrixSquare(odd, even);  // four zero bits
+    const uint32_t *op = odd;
+    for (size_t length = STREAM_LENGTH; length != 0;) {
+      MatrixSquare(even, odd);
+      op = even;
+      length >>= 1;
+      if (length == 0) {
+        break;
+      }
+      MatrixSquare(odd, even);
+      op = odd;
+      length >>= 1;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+      for (int k = 0; k < 4; k++) {
+        shift_[k][b] = MatrixTimes(op, b << (8 * k));
+      }
+    }
+  }
+
+  /** @return the raw crc advanced over STREAM_LENGTH zero bytes */
+  auto Shift(uint32_t crc) const -> uint32_t {
+    return shift_[0][crc & 0xFF] ^ shift_[1][(crc >> 8) & 0xFF] ^ shift_[2][(crc >> 16) & 0xFF] ^ shift_[3][crc >> 24];
+  }
+};
+
+auto Tables() -> const Crc32cTables & {
+  static const Crc32cTables tables;
+  return tables;
+}
+
+#ifdef BUSTUB_HAVE_SSE42_CRC32C
+__attribute__((target("sse4.2"))) auto ExtendSse42(uint32_t crc, const char *data, size_t length) -> uint32_t {
+  const auto &tables = Tables();
+  uint64_t crc0 = ~crc;
+  uint64_t word;
+  uint64_t word1;
+  uint64_t word2;
+  // The crc32 instruction has a latency of three cycles but issues every cycle, so checksum three streams at once and
+  // combine them by shifting the earlier ones over the bytes of the later ones.
+  while (length >= 3 * STREAM_LENGTH) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (const char *end = data + STREAM_LENGTH; data < end; data += 8) {
+      std::memcpy(&word, data, 8);
+      std::memcpy(&word1, data + STREAM_LENGTH, 8);
+      std::memcpy(&word2, data + 2 * STREAM_LENGTH, 8);
+      crc0 = _mm_crc32_u64(crc0, word);
+      crc1 = _mm_crc32_u64(crc1, word1);
+      crc2 = _mm_crc32_u64(crc2, word2);
+    }
+    crc0 = tables.Shift(static_cast<uint32_t>(crc0)) ^ crc1;
+    crc0 = tables.Shift(static_cast<uint32_t>(crc0)) ^ crc2;
+    data += 2 * STREAM_LENGTH;
+    length -= 3 * STREAM_LENGTH;
+  }
+  for (; length >= 8; data += 8, length -= 8) {
+    std::memcpy(&word, data, 8);
+    crc0 = _mm_crc32_u64(crc0, word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc0);
+  for (; length > 0; data++, length--) {
+    crc32 = _mm_crc32_u8(crc32, static_cast<uint8_t>(*data));
+  }
+  return ~crc32;
+}
+#endif
+
+}  // namespace
+
+auto Crc32c::ExtendSoftware(uint32_t crc, const char *data, size_t length) -> uint32_t {
+  const auto &slices = Tables().slices_;
+  crc = ~crc;
+  // The words are read little-endian, as on every CPU BusTub runs on
+  for (; length >= 8; data += 8, length -= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, 8);
+    word ^= crc;
+    crc = slices[7][word & 0xFF] ^ slices[6][(word >> 8) & 0xFF] ^ slices[5][(word >> 16) & 0xFF] ^
+          slices[4][(word >> 24) & 0xFF] ^ slices[3][(word >> 32) & 0xFF] ^ slices[2][(word >> 40) & 0xFF] ^
+          slices[1][(word >> 48) & 0xFF] ^ slices[0][word >> 56];
+  }
+  for (; length > 0; data++, length--) {
+    crc = slices[0][(crc ^ static_cast<uint8_t>(*data)) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+auto Crc32c::IsHardwareAccelerated() -> bool {
+#ifdef BUSTUB_HAVE_SSE42_CRC32C
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2") != 0;
+  return has_sse42;
+#else
+  return false;
+#endif
+}
+
+auto Crc32c::Extend(uint32_t crc, const char *data, size_t length) -> uint32_t {
+#ifdef BUSTUB_HAVE_SSE42_CRC32C
+  if (IsHardwareAccelerated()) {
+    return ExtendSse42(crc, data, length);
+  }
+#endif
+  return ExtendSoftware(crc, data, length);
+}
+
+}  // namespace bustub
@@ -10,8 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -26,7 +29,15 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::DiskExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                          const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
+  // New pages are zeroed: a global depth of 0 and a bucket without any pairs.
+  page_id_t bucket_page_id;
+  WritePageGuard dir_guard = NewPageLatched(&directory_page_id_);
+  WritePageGuard bucket_guard = NewPageLatched(&bucket_page_id);
+  bucket_guard.SetDirty();
+  auto *dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+  dir_page->SetPageId(directory_page_id_);
+  dir_page->SetBucketPageId(0, bucket_page_id);
+  dir_page->SetLocalDepth(0, 0);
 }
 
 /*****************************************************************************
@@ -45,23 +56,96 @@ auto HASH_TABLE_TYPE::Hash(KeyType key) -> uint32_t {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t {
-  return 0;
+inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, const HashTableDirectoryPage *dir_page) -> uint32_t {
+  return Hash(key) & dir_page->GetGlobalDepthMask();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t {
-  return 0;
+inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, const HashTableDirectoryPage *dir_page) -> page_id_t {
+  return dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
-  return nullptr;
+  auto *page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  page->SetPageType(PageType::INDEX);
+  return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE * {
-  return nullptr;
+template <class Guard>
+auto HASH_TABLE_TYPE::FetchPageLatched(page_id_t page_id) -> Guard {
+  auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot fetch page");
+  }
+  guard.AsPage<Page>()->SetPageType(PageType::INDEX);
+  if constexpr (std::is_same_v<Guard, WritePageGuard>) {
+    return guard.UpgradeWrite();
+  } else {
+    return guard.UpgradeRead();
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::NewPageLatched(page_id_t *page_id) -> WritePageGuard {
+  auto guard = buffer_pool_manager_->NewPageGuarded(page_id);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
+  }
+  guard.AsPage<Page>()->SetPageType(PageType::INDEX);
+  return guard.UpgradeWrite();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <class Guard>
+auto HASH_TABLE_TYPE::LatchBucket(const KeyType &key) -> Guard {
+  // The directory page stays pinned, and is only latched for the lookups. A splitting thread latches the directory
+  // while it holds the latch of its bucket, so holding the directory latch while waiting for a bucket could deadlock.
+  auto dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id_);
+  auto *page = dir_guard.AsPage<Page>();
+  page->SetPageType(PageType::INDEX);
+  const auto *dir_page = dir_guard.As<HashTableDirectoryPage>();
+
+  page->RLatch();
+  auto bucket_page_id = KeyToPageId(key, dir_page);
+  page->RUnlatch();
+  while (true) {
+    Guard bucket_guard = FetchPageLatched<Guard>(bucket_page_id);
+    page->RLatch();
+    auto current_page_id = KeyToPageId(key, dir_page);
+    page->RUnlatch();
+    if (current_page_id == bucket_page_id) {
+      return bucket_guard;
+    }
+    bucket_page_id = current_page_id;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::SplitBucket(WritePageGuard *bucket_guard, uint32_t bucket_idx, uint32_t local_depth) {
+  // The split image starts as a copy of the bucket. Each pair then stays readable in exactly one of the two, which
+  // leaves tombstones for later inserts instead of moving pairs around.
+  page_id_t image_page_id;
+  WritePageGuard image_guard = NewPageLatched(&image_page_id);
+  std::memcpy(image_guard.GetDataMut(), bucket_guard->GetData(), BUSTUB_PAGE_SIZE);
+  auto *bucket = bucket_guard->AsMut<HASH_TABLE_BUCKET_TYPE>();
+  auto *image = image_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+  uint32_t high_bit = 1U << local_depth;
+  for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE && bucket->IsOccupied(slot); slot++) {
+    if (bucket->IsReadable(slot)) {
+      ((Hash(bucket->KeyAt(slot)) & high_bit) == 0 ? image : bucket)->RemoveAt(slot);
+    }
+  }
+
+  WritePageGuard dir_guard = FetchPageLatched<WritePageGuard>(directory_page_id_);
+  auto *dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+  for (uint32_t i = bucket_idx & (high_bit - 1); i < dir_page->Size(); i += high_bit) {
+    dir_page->IncrLocalDepth(i);
+    if ((i & high_bit) != 0) {
+      dir_page->SetBucketPageId(i, image_page_id);
+    }
+  }
 }
 
 /*****************************************************************************
@@ -69,7 +153,12 @@ auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BU
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  return false;
+  table_latch_.RLock();
+  ReadPageGuard bucket_guard = LatchBucket<ReadPageGuard>(key);
+  auto found = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetValue(key, comparator_, result);
+  bucket_guard.Drop();
+  table_latch_.RUnlock();
+  return found;
 }
 
 /*****************************************************************************
@@ -77,12 +166,72 @@ auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  table_latch_.RLock();
+  while (true) {
+    WritePageGuard bucket_guard = LatchBucket<WritePageGuard>(key);
+    if (!bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->IsFull()) {
+      auto inserted = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>()->Insert(key, value, comparator_);
+      bucket_guard.Drop();
+      table_latch_.RUnlock();
+      return inserted;
+    }
+
+    // Local depth and global depth can only change under the latch of the bucket and table_latch_, respectively.
+    uint32_t bucket_idx;
+    uint32_t local_depth;
+    uint32_t global_depth;
+    {
+      ReadPageGuard dir_guard = FetchPageLatched<ReadPageGuard>(directory_page_id_);
+      const auto *dir_page = dir_guard.As<HashTableDirectoryPage>();
+      bucket_idx = KeyToDirectoryIndex(key, dir_page);
+      local_depth = dir_page->GetLocalDepth(bucket_idx);
+      global_depth = dir_page->GetGlobalDepth();
+    }
+    if (local_depth == global_depth) {
+      break;
+    }
+    SplitBucket(&bucket_guard, bucket_idx, local_depth);
+  }
+  table_latch_.RUnlock();
+  return SplitInsert(transaction, key, value);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  table_latch_.WLock();
+  bool inserted = false;
+  while (true) {
+    WritePageGuard bucket_guard = LatchBucket<WritePageGuard>(key);
+    auto *bucket = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    if (!bucket->IsFull()) {
+      inserted = bucket->Insert(key, value, comparator_);
+      break;
+    }
+    std::vector<ValueType> values;
+    bucket->GetValue(key, comparator_, &values);
+    if (std::find(values.begin(), values.end(), value) != values.end()) {
+      break;
+    }
+
+    uint32_t bucket_idx;
+    uint32_t local_depth;
+    {
+      WritePageGuard dir_guard = FetchPageLatched<WritePageGuard>(directory_page_id_);
+      auto *dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+      bucket_idx = KeyToDirectoryIndex(key, dir_page);
+      local_depth = dir_page->GetLocalDepth(bucket_idx);
+      if (local_depth == dir_page->GetGlobalDepth()) {
+        if (dir_page->Size() == DIRECTORY_ARRAY_SIZE) {
+          LOG_WARN("Hash table directory is full, cannot insert into a full bucket");
+          break;
+        }
+        dir_page->IncrGlobalDepth();
+      }
+    }
+    SplitBucket(&bucket_guard, bucket_idx, local_depth);
+  }
+  table_latch_.WUnlock();
+  return inserted;
 }
 
 /*****************************************************************************
@@ -90,14 +239,65 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  table_latch_.RLock();
+  WritePageGuard bucket_guard = LatchBucket<WritePageGuard>(key);
+  auto *bucket = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+  auto removed = bucket->Remove(key, value, comparator_);
+  auto emptied = removed && bucket->IsEmpty();
+  bucket_guard.Drop();
+  table_latch_.RUnlock();
+
+  if (emptied) {
+    Merge(transaction, key, value);
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  WritePageGuard dir_guard = FetchPageLatched<WritePageGuard>(directory_page_id_);
+  auto *dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+  auto is_empty = [this](page_id_t page_id) {
+    ReadPageGuard guard = FetchPageLatched<ReadPageGuard>(page_id);
+    return guard.As<HASH_TABLE_BUCKET_TYPE>()->IsEmpty();
+  };
+
+  while (true) {
+    auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    auto image_idx = dir_page->GetSplitImageIndex(bucket_idx);
+    auto local_depth = dir_page->GetLocalDepth(bucket_idx);
+    if (local_depth == 0 || dir_page->GetLocalDepth(image_idx) != local_depth) {
+      break;
+    }
+
+    // Inserts may have refilled the bucket since Remove emptied it, while its split image may be empty instead.
+    auto bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    auto image_page_id = dir_page->GetBucketPageId(image_idx);
+    if (!is_empty(bucket_page_id)) {
+      if (!is_empty(image_page_id)) {
+        break;
+      }
+      std::swap(bucket_page_id, image_page_id);
+    }
+
+    auto high_bit = dir_page->GetLocalHighBit(bucket_idx);
+    for (uint32_t i = bucket_idx & (high_bit - 1); i < dir_page->Size(); i += high_bit) {
+      dir_page->SetBucketPageId(i, image_page_id);
+      dir_page->DecrLocalDepth(i);
+    }
+    buffer_pool_manager_->DeletePage(bucket_page_id);
+  }
+
+  while (dir_page->CanShrink()) {
+    dir_page->DecrGlobalDepth();
+  }
+  dir_guard.Drop();
+  table_latch_.WUnlock();
+}
 
 /*****************************************************************************
  * GETGLOBALDEPTH - DO NOT TOUCH
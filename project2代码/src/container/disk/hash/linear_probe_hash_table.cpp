@@ -10,8 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -23,46 +26,372 @@
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                      const KeyComparator &comparator, size_t num_buckets,
-                                      HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+LINEAR_PROBE_HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                   const KeyComparator &comparator, size_t num_buckets,
+                                                   HashFunction<KeyType> hash_fn)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      min_num_buckets_(num_buckets),
+      hash_fn_(std::move(hash_fn)) {
+  WritePageGuard header_guard = NewPageLatched(&header_page_id_);
+  auto *header_page = header_guard.AsMut<HashTableHeaderPage>();
+  header_page->SetPageId(header_page_id_);
+  CreateNewBlockPages(header_page, NumBlocksFor(num_buckets));
+}
 
 /*****************************************************************************
- * SEARCH
+ * HELPERS
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
+template <class Guard>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::FetchPageLatched(page_id_t page_id) -> Guard {
+  auto guard = buffer_pool_manager_->FetchPageBasic(page_id);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot fetch page");
+  }
+  guard.AsPage<Page>()->SetPageType(PageType::INDEX);
+  if constexpr (std::is_same_v<Guard, WritePageGuard>) {
+    return guard.UpgradeWrite();
+  } else {
+    return guard.UpgradeRead();
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::NewPageLatched(page_id_t *page_id) -> WritePageGuard {
+  auto guard = buffer_pool_manager_->NewPageGuarded(page_id);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
+  }
+  guard.AsPage<Page>()->SetPageType(PageType::INDEX);
+  return guard.UpgradeWrite();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <class Guard, class Visitor>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Probe(const HashTableHeaderPage *header_page, const KeyType &key, Visitor &&visit)
+    -> bool {
+  auto num_blocks = header_page->NumBlocks();
+  auto start = hash_fn_.GetHash(key) % header_page->GetSize();
+  auto block_index = start / BLOCK_ARRAY_SIZE;
+  slot_offset_t bucket_ind = start % BLOCK_ARRAY_SIZE;
+  // The walk comes back to the first block in the end, for the slots in front of the one the key hashes to.
+  for (size_t i = 0; i <= num_blocks; i++, block_index = (block_index + 1) % num_blocks, bucket_ind = 0) {
+    Guard guard = FetchPageLatched<Guard>(header_page->GetBlockPageId(block_index));
+    auto *block = [&guard] {
+      if constexpr (std::is_same_v<Guard, WritePageGuard>) {
+        return guard.template AsMut<HASH_TABLE_BLOCK_TYPE>();
+      } else {
+        return guard.template As<HASH_TABLE_BLOCK_TYPE>();
+      }
+    }();
+    auto end = i == num_blocks ? start % BLOCK_ARRAY_SIZE : BLOCK_ARRAY_SIZE;
+    for (; bucket_ind < end; bucket_ind++) {
+      if (visit(block, block_index, bucket_ind)) {
+        return true;
+      }
+      if (!block->IsOccupied(bucket_ind)) {
+        return false;
+      }
+    }
+  }
   return false;
 }
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::InsertInto(const HashTableHeaderPage *header_page, const KeyType &key,
+                                              const ValueType &value, bool check_duplicate) -> bool {
+  while (true) {
+    // The first slot without a pair takes the pair. With check_duplicate, the walk goes on to look for the pair.
+    auto free_block = std::numeric_limits<size_t>::max();
+    slot_offset_t free_ind = 0;
+    auto duplicate = Probe<ReadPageGuard>(
+        header_page, key, [&](const HASH_TABLE_BLOCK_TYPE *block, size_t block_index, slot_offset_t bucket_ind) {
+          if (!block->IsReadable(bucket_ind)) {
+            if (free_block == std::numeric_limits<size_t>::max()) {
+              free_block = block_index;
+              free_ind = bucket_ind;
+            }
+            return false;
+          }
+          return check_duplicate && comparator_(key, block->KeyAt(bucket_ind)) == 0 &&
+                 value == block->ValueAt(bucket_ind);
+        });
+    if (duplicate || free_block == std::numeric_limits<size_t>::max()) {
+      return false;
+    }
+
+    WritePageGuard guard = FetchPageLatched<WritePageGuard>(header_page->GetBlockPageId(free_block));
+    auto *block = guard.AsMut<HASH_TABLE_BLOCK_TYPE>();
+    auto was_occupied = block->IsOccupied(free_ind);
+    if (block->Insert(free_ind, key, value)) {
+      if (!was_occupied) {
+        num_occupied_++;
+      }
+      return true;
+    }
+    // An insert of another key took the slot after the walk.
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::ResizeInsert(const HashTableHeaderPage *header_page, const KeyType &key,
+                                                const ValueType &value) {
+  if (!InsertInto(header_page, key, value, false)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "no room for a migrated pair in the resized hash table");
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::DeleteBlockPages(HashTableHeaderPage *old_header_page) {
+  for (size_t block_index = 0; block_index < old_header_page->NumBlocks(); block_index++) {
+    buffer_pool_manager_->DeletePage(old_header_page->GetBlockPageId(block_index));
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::CreateNewBlockPages(HashTableHeaderPage *header_page, size_t num_blocks) {
+  // New pages are zeroed, i.e. blocks whose slots were never occupied.
+  for (size_t i = 0; i < num_blocks; i++) {
+    page_id_t block_page_id;
+    WritePageGuard block_guard = NewPageLatched(&block_page_id);
+    block_guard.SetDirty();
+    header_page->AddBlockPageId(block_page_id);
+  }
+  header_page->SetSize(header_page->NumBlocks() * BLOCK_ARRAY_SIZE);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::NumBlocksFor(size_t num_buckets) const -> size_t {
+  auto num_blocks = (num_buckets + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE;
+  return std::clamp<size_t>(num_blocks, 1, HashTableHeaderPage::MaxBlocks());
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                            std::vector<ValueType> *result) -> bool {
+  bool found = false;
+  auto collect = [&](const HASH_TABLE_BLOCK_TYPE *block, size_t block_index, slot_offset_t bucket_ind) {
+    if (block->IsReadable(bucket_ind) && comparator_(key, block->KeyAt(bucket_ind)) == 0) {
+      result->push_back(block->ValueAt(bucket_ind));
+      found = true;
+    }
+    return false;
+  };
+
+  table_latch_.RLock();
+  // A pair is either in the old blocks or in the current ones; migrations wait for the table latch.
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    ReadPageGuard old_header_guard = FetchPageLatched<ReadPageGuard>(old_header_page_id_);
+    Probe<ReadPageGuard>(old_header_guard.As<HashTableHeaderPage>(), key, collect);
+  }
+  {
+    ReadPageGuard header_guard = FetchPageLatched<ReadPageGuard>(header_page_id_);
+    Probe<ReadPageGuard>(header_guard.As<HashTableHeaderPage>(), key, collect);
+  }
+  table_latch_.RUnlock();
+  return found;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value)
+    -> bool {
+  auto is_pair = [&](const HASH_TABLE_BLOCK_TYPE *block, size_t block_index, slot_offset_t bucket_ind) {
+    return block->IsReadable(bucket_ind) && comparator_(key, block->KeyAt(bucket_ind)) == 0 &&
+           value == block->ValueAt(bucket_ind);
+  };
+
+  while (true) {
+    bool inserted = false;
+    bool full = false;
+    bool migrating;
+    size_t size;
+    table_latch_.RLock();
+    {
+      std::scoped_lock key_latch(insert_latches_[hash_fn_.GetHash(key) % NUM_INSERT_LATCHES]);
+      migrating = old_header_page_id_ != INVALID_PAGE_ID;
+      bool duplicate = false;
+      if (migrating) {
+        ReadPageGuard old_header_guard = FetchPageLatched<ReadPageGuard>(old_header_page_id_);
+        duplicate = Probe<ReadPageGuard>(old_header_guard.As<HashTableHeaderPage>(), key, is_pair);
+      }
+      ReadPageGuard header_guard = FetchPageLatched<ReadPageGuard>(header_page_id_);
+      const auto *header_page = header_guard.As<HashTableHeaderPage>();
+      size = header_page->GetSize();
+      if (!duplicate) {
+        inserted = InsertInto(header_page, key, value, true);
+        // Unless the pair is a duplicate, no slot was left for it.
+        full = !inserted && !Probe<ReadPageGuard>(header_page, key, is_pair);
+      }
+    }
+    if (inserted) {
+      num_pairs_++;
+    }
+    table_latch_.RUnlock();
+
+    if (full || (num_occupied_ + num_old_pairs_) * 4 > size * 3) {
+      if (Grow(size)) {
+        if (full) {
+          continue;
+        }
+      } else if (full) {
+        LOG_WARN("Linear probe hash table is full, cannot insert");
+      }
+    } else if (migrating) {
+      table_latch_.WLock();
+      MigrateBlocks(MIGRATE_BLOCKS_PER_OP);
+      table_latch_.WUnlock();
+    }
+    return inserted;
+  }
 }
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value)
+    -> bool {
+  auto remove = [&](HASH_TABLE_BLOCK_TYPE *block, size_t block_index, slot_offset_t bucket_ind) {
+    if (block->IsReadable(bucket_ind) && comparator_(key, block->KeyAt(bucket_ind)) == 0 &&
+        value == block->ValueAt(bucket_ind)) {
+      block->Remove(bucket_ind);
+      return true;
+    }
+    return false;
+  };
+
+  bool removed = false;
+  table_latch_.RLock();
+  auto migrating = old_header_page_id_ != INVALID_PAGE_ID;
+  if (migrating) {
+    ReadPageGuard old_header_guard = FetchPageLatched<ReadPageGuard>(old_header_page_id_);
+    removed = Probe<WritePageGuard>(old_header_guard.As<HashTableHeaderPage>(), key, remove);
+    if (removed) {
+      num_old_pairs_--;
+    }
+  }
+  if (!removed) {
+    ReadPageGuard header_guard = FetchPageLatched<ReadPageGuard>(header_page_id_);
+    removed = Probe<WritePageGuard>(header_guard.As<HashTableHeaderPage>(), key, remove);
+  }
+  if (removed) {
+    num_pairs_--;
+  }
+  table_latch_.RUnlock();
+
+  if (migrating) {
+    table_latch_.WLock();
+    MigrateBlocks(MIGRATE_BLOCKS_PER_OP);
+    table_latch_.WUnlock();
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void LINEAR_PROBE_HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  table_latch_.WLock();
+  MigrateBlocks(std::numeric_limits<size_t>::max());
+  StartResize(initial_size);
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::StartResize(size_t initial_size) {
+  page_id_t new_header_page_id;
+  WritePageGuard header_guard = NewPageLatched(&new_header_page_id);
+  auto *header_page = header_guard.AsMut<HashTableHeaderPage>();
+  header_page->SetPageId(new_header_page_id);
+  CreateNewBlockPages(header_page, NumBlocksFor(std::max(2 * initial_size, min_num_buckets_)));
+
+  old_header_page_id_ = header_page_id_;
+  header_page_id_ = new_header_page_id;
+  next_migrated_block_ = 0;
+  num_old_pairs_ = num_pairs_.load();
+  num_occupied_ = 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto LINEAR_PROBE_HASH_TABLE_TYPE::Grow(size_t size) -> bool {
+  table_latch_.WLock();
+  size_t current_size;
+  {
+    ReadPageGuard header_guard = FetchPageLatched<ReadPageGuard>(header_page_id_);
+    current_size = header_guard.As<HashTableHeaderPage>()->GetSize();
+  }
+  if (current_size != size) {
+    table_latch_.WUnlock();
+    return true;
+  }
+
+  // The old pairs were counted as taking up current slots, so that there is room for all of them.
+  MigrateBlocks(std::numeric_limits<size_t>::max());
+  auto grows = NumBlocksFor(std::max(2 * num_pairs_, min_num_buckets_)) * BLOCK_ARRAY_SIZE > size;
+  auto num_tombstones = num_occupied_ - num_pairs_;
+  if (!grows && num_tombstones < num_pairs_) {
+    table_latch_.WUnlock();
+    return false;
+  }
+  StartResize(num_pairs_);
+  table_latch_.WUnlock();
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::MigrateBlocks(size_t max_blocks) {
+  if (old_header_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  ReadPageGuard header_guard = FetchPageLatched<ReadPageGuard>(header_page_id_);
+  const auto *header_page = header_guard.As<HashTableHeaderPage>();
+  WritePageGuard old_header_guard = FetchPageLatched<WritePageGuard>(old_header_page_id_);
+  auto *old_header_page = old_header_guard.AsMut<HashTableHeaderPage>();
+
+  // Migrated pairs leave tombstones, so that the probe sequences of the pairs still to migrate stay intact.
+  for (size_t i = 0; i < max_blocks && next_migrated_block_ < old_header_page->NumBlocks(); i++) {
+    WritePageGuard block_guard =
+        FetchPageLatched<WritePageGuard>(old_header_page->GetBlockPageId(next_migrated_block_++));
+    auto *block = block_guard.AsMut<HASH_TABLE_BLOCK_TYPE>();
+    for (slot_offset_t bucket_ind = 0; bucket_ind < BLOCK_ARRAY_SIZE; bucket_ind++) {
+      if (block->IsReadable(bucket_ind)) {
+        ResizeInsert(header_page, block->KeyAt(bucket_ind), block->ValueAt(bucket_ind));
+        block->Remove(bucket_ind);
+        num_old_pairs_--;
+      }
+    }
+  }
+  if (next_migrated_block_ < old_header_page->NumBlocks()) {
+    return;
+  }
+
+  DeleteBlockPages(old_header_page);
+  old_header_guard.Drop();
+  buffer_pool_manager_->DeletePage(old_header_page_id_);
+  old_header_page_id_ = INVALID_PAGE_ID;
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::GetSize() -> size_t {
-  return 0;
+auto LINEAR_PROBE_HASH_TABLE_TYPE::GetSize() -> size_t {
+  table_latch_.RLock();
+  size_t size;
+  {
+    ReadPageGuard header_guard = FetchPageLatched<ReadPageGuard>(header_page_id_);
+    size = header_guard.As<HashTableHeaderPage>()->GetSize();
+  }
+  table_latch_.RUnlock();
+  return size;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
@@ -12,10 +12,16 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <list>
+#include <new>
 #include <utility>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "container/hash/extendible_hash_table.h"
 #include "storage/page/page.h"
 
@@ -23,19 +29,56 @@ namespace bustub {
 
 template <typename K, typename V>
 ExtendibleHashTable<K, V>::ExtendibleHashTable(size_t bucket_size)
-    : global_depth_(0), bucket_size_(bucket_size), num_buckets_(1) {
-  dir_.push_back(std::make_shared<Bucket>(bucket_size, 0));
+    : global_depth_(0), bucket_size_(bucket_size), num_buckets_(1), dir_(1) {
+  dir_[0].store(new Bucket(bucket_size, 0));
+  num_buckets_at_depth_[0] = 1;
+}
+
+template <typename K, typename V>
+ExtendibleHashTable<K, V>::~ExtendibleHashTable() {
+  // A bucket of local depth d fills every 2^d-th slot of the directory, and exactly one of them is among the first 2^d.
+  // Walking backwards reaches that one last.
+  for (size_t i = dir_.size(); i-- > 0;) {
+    auto *bucket = dir_[i].load();
+    if (i < (static_cast<size_t>(1) << bucket->GetDepth())) {
+      delete bucket;
+    }
+  }
 }
 
 template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::IndexOf(const K &key) -> size_t {
+auto ExtendibleHashTable<K, V>::IndexOf(size_t hash) const -> size_t {
   int mask = (1 << global_depth_) - 1;
-  return std::hash<K>()(key) & mask;
+  return hash & mask;
+}
+
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::LatchBucket(size_t hash, bool exclusive) const -> Bucket * {
+  auto *bucket = dir_[IndexOf(hash)].load();
+  while (true) {
+    if (exclusive) {
+      bucket->GetLatch().lock();
+    } else {
+      bucket->GetLatch().lock_shared();
+    }
+    // Slots are only repointed by a thread holding the latch of the bucket they pointed to, so once the directory
+    // agrees with us, it keeps agreeing until we let go.
+    auto *current = dir_[IndexOf(hash)].load();
+    if (current == bucket) {
+      return bucket;
+    }
+    if (exclusive) {
+      bucket->GetLatch().unlock();
+    } else {
+      bucket->GetLatch().unlock_shared();
+    }
+    bucket = current;
+  }
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetGlobalDepth() const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::shared_lock<std::shared_mutex> lock(dir_latch_);
   return GetGlobalDepthInternal();
 }
 
@@ -46,139 +89,312 @@ auto ExtendibleHashTable<K, V>::GetGlobalDepthInternal() const -> int {
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetLocalDepth(int dir_index) const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::shared_lock<std::shared_mutex> lock(dir_latch_);
   return GetLocalDepthInternal(dir_index);
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetLocalDepthInternal(int dir_index) const -> int {
-  return dir_[dir_index]->GetDepth();
+  auto *bucket = dir_[dir_index].load();
+  std::shared_lock<std::shared_mutex> bucket_lock(bucket->GetLatch());
+  return bucket->GetDepth();
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetNumBuckets() const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
-  return GetNumBucketsInternal();
+  return num_buckets_.load();
 }
 
 template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::GetNumBucketsInternal() const -> int {
-  return num_buckets_;
+auto ExtendibleHashTable<K, V>::GetMemoryUsage() const -> size_t {
+  std::shared_lock<std::shared_mutex> lock(dir_latch_);
+  return sizeof(*this) + dir_.capacity() * sizeof(dir_[0]) + num_buckets_ * Bucket::GetMemoryUsage(bucket_size_);
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::Find(const K &key, V &value) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
-
-  auto index = IndexOf(key);
-  auto target_bucket = dir_[index];
+  auto hash = std::hash<K>()(key);
+  std::shared_lock<std::shared_mutex> lock(dir_latch_);
+  auto *target_bucket = LatchBucket(hash, false);
+  std::shared_lock<std::shared_mutex> bucket_lock(target_bucket->GetLatch(), std::adopt_lock);
 
-  return target_bucket->Find(key, value);
+  return target_bucket->Find(key, hash, value);
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::Remove(const K &key) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
-
-  auto index = IndexOf(key);
-  auto target_bucket = dir_[index];
+  auto hash = std::hash<K>()(key);
+  bool merge;
+  {
+    std::shared_lock<std::shared_mutex> lock(dir_latch_);
+    auto *target_bucket = LatchBucket(hash, true);
+    std::unique_lock<std::shared_mutex> bucket_lock(target_bucket->GetLatch(), std::adopt_lock);
+
+    if (!target_bucket->Remove(key, hash)) {
+      return false;
+    }
+    merge = CanMerge(target_bucket, hash);
+  }
 
-  return target_bucket->Remove(key);
+  if (merge) {
+    std::unique_lock<std::shared_mutex> lock(dir_latch_);
+    MergeBuckets(hash);
+  }
+  return true;
 }
 
 template <typename K, typename V>
 void ExtendibleHashTable<K, V>::Insert(const K &key, const V &value) {
-  std::scoped_lock<std::mutex> lock(latch_);
-
-  while (dir_[IndexOf(key)]->IsFull()) {
-    auto index = IndexOf(key);
-    auto target_bucket = dir_[index];
-
-    if (target_bucket->GetDepth() == GetGlobalDepthInternal()) {
-      global_depth_++;
-      int capacity = dir_.size();
-      dir_.resize(capacity << 1);
-      for (int i = 0; i < capacity; i++) {
-        dir_[i + capacity] = dir_[i];
+  auto hash = std::hash<K>()(key);
+  while (true) {
+    {
+      std::shared_lock<std::shared_mutex> lock(dir_latch_);
+      auto *target_bucket = LatchBucket(hash, true);
+      std::unique_lock<std::shared_mutex> bucket_lock(target_bucket->GetLatch(), std::adopt_lock);
+
+      if (target_bucket->Insert(key, hash, value)) {
+        return;
       }
-    }
-
-    int mask = 1 << target_bucket->GetDepth();
-    auto bucket_0 = std::make_shared<Bucket>(bucket_size_, target_bucket->GetDepth() + 1);
-    auto bucket_1 = std::make_shared<Bucket>(bucket_size_, target_bucket->GetDepth() + 1);
-
-    for (const auto &item : target_bucket->GetItems()) {
-      size_t hash_key = std::hash<K>()(item.first);
-      if ((hash_key & mask) != 0U) {
-        bucket_1->Insert(item.first, item.second);
-      } else {
-        bucket_0->Insert(item.first, item.second);
+      if (target_bucket->GetDepth() < GetGlobalDepthInternal()) {
+        RedistributeBucket(target_bucket, hash);
+        continue;
       }
     }
 
-    num_buckets_++;
-
-    for (size_t i = 0; i < dir_.size(); i++) {
-      if (dir_[i] == target_bucket) {
-        if ((i & mask) != 0U) {
-          dir_[i] = bucket_1;
-        } else {
-          dir_[i] = bucket_0;
-        }
+    // The bucket is full and as deep as the directory, so the directory has to double first. Another thread may have
+    // doubled it or split the bucket while no latch was held, in which case there is nothing to do before retrying.
+    std::unique_lock<std::shared_mutex> lock(dir_latch_);
+    if (dir_[IndexOf(hash)].load()->GetDepth() == GetGlobalDepthInternal()) {
+      std::vector<std::atomic<Bucket *>> dir(dir_.size() << 1);
+      for (size_t i = 0; i < dir.size(); i++) {
+        dir[i].store(dir_[i & (dir_.size() - 1)].load());
       }
+      dir_.swap(dir);
+      global_depth_++;
     }
   }
+}
 
-  auto index = IndexOf(key);
-  auto target_bucket = dir_[index];
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::RedistributeBucket(Bucket *bucket, size_t hash) -> void {
+  auto high_bit = static_cast<size_t>(1) << bucket->GetDepth();
+  auto *image = new Bucket(bucket_size_, bucket->GetDepth() + 1);
+  bucket->Split(image);
+  num_buckets_++;
+  num_buckets_at_depth_[image->GetDepth() - 1]--;
+  num_buckets_at_depth_[image->GetDepth()] += 2;
+
+  // The slots of the bucket are the ones whose low bits match the hash of any of its keys; the upper half of them also
+  // has the new bit set. The image is complete before the first slot points to it.
+  for (size_t i = (hash & (high_bit - 1)) | high_bit; i < dir_.size(); i += high_bit << 1) {
+    dir_[i].store(image);
+  }
+}
 
-  for (auto &item : target_bucket->GetItems()) {
-    if (item.first == key) {
-      item.second = value;
-      return;
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::CanMerge(Bucket *bucket, size_t hash) const -> bool {
+  auto depth = bucket->GetDepth();
+  if (depth == 0 || bucket->GetSize() > bucket_size_ / 2) {
+    return false;
+  }
+  auto *buddy = dir_[IndexOf(hash) ^ (static_cast<size_t>(1) << (depth - 1))].load();
+  if (!buddy->GetLatch().try_lock_shared()) {
+    return false;
+  }
+  auto can_merge = buddy->GetDepth() == depth && bucket->GetSize() + buddy->GetSize() <= bucket_size_ / 2;
+  buddy->GetLatch().unlock_shared();
+  return can_merge;
+}
+
+template <typename K, typename V>
+void ExtendibleHashTable<K, V>::MergeBuckets(size_t hash) {
+  // Another thread may have merged or refilled the buckets since CanMerge(), so check again.
+  auto index = IndexOf(hash);
+  auto *bucket = dir_[index].load();
+  while (bucket->GetDepth() > 0) {
+    auto depth = bucket->GetDepth();
+    auto buddy_index = index ^ (static_cast<size_t>(1) << (depth - 1));
+    auto *buddy = dir_[buddy_index].load();
+    if (buddy->GetDepth() != depth || bucket->GetSize() + buddy->GetSize() > bucket_size_ / 2) {
+      break;
+    }
+    bucket->Merge(buddy);
+    auto stride = static_cast<size_t>(1) << depth;
+    for (size_t i = buddy_index & (stride - 1); i < dir_.size(); i += stride) {
+      dir_[i].store(bucket);
     }
+    delete buddy;
+    num_buckets_--;
+    num_buckets_at_depth_[depth] -= 2;
+    num_buckets_at_depth_[depth - 1]++;
   }
 
-  target_bucket->Insert(key, value);
+  // Doubling is only needed once a bucket as deep as the directory fills up, so leaving one level to spare means that
+  // the directory does not have to double again as soon as the next bucket splits.
+  while (global_depth_ > 0 && num_buckets_at_depth_[global_depth_] == 0 &&
+         num_buckets_at_depth_[global_depth_ - 1] == 0) {
+    std::vector<std::atomic<Bucket *>> dir(dir_.size() >> 1);
+    for (size_t i = 0; i < dir.size(); i++) {
+      dir[i].store(dir_[i].load());
+    }
+    dir_.swap(dir);
+    global_depth_--;
+  }
 }
 
 //===--------------------------------------------------------------------===//
 // Bucket
 //===--------------------------------------------------------------------===//
+/** Round the given size up to a multiple of the given power of two. */
+static auto AlignUp(size_t size, size_t alignment) -> size_t { return (size + alignment - 1) & ~(alignment - 1); }
+
 template <typename K, typename V>
-ExtendibleHashTable<K, V>::Bucket::Bucket(size_t array_size, int depth) : size_(array_size), depth_(depth) {}
+auto ExtendibleHashTable<K, V>::Bucket::Layout(size_t size, size_t *keys_offset, size_t *values_offset) -> size_t {
+  *keys_offset = AlignUp(AlignUp(size, GROUP_SIZE), alignof(K));
+  *values_offset = AlignUp(*keys_offset + size * sizeof(K), alignof(V));
+  return *values_offset + size * sizeof(V);
+}
 
 template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Find(const K &key, V &value) -> bool {
-  return std::any_of(list_.begin(), list_.end(), [&key, &value](const auto &item) {
-    if (item.first == key) {
-      value = item.second;
-      return true;
-    }
-    return false;
-  });
+auto ExtendibleHashTable<K, V>::Bucket::GetMemoryUsage(size_t size) -> size_t {
+  size_t keys_offset;
+  size_t values_offset;
+  return sizeof(Bucket) + AlignUp(Layout(size, &keys_offset, &values_offset), CACHE_LINE_SIZE);
+}
+
+template <typename K, typename V>
+ExtendibleHashTable<K, V>::Bucket::Bucket(size_t array_size, int depth) : size_(array_size), depth_(depth) {
+  size_t keys_offset;
+  size_t values_offset;
+  auto block_size = Layout(array_size, &keys_offset, &values_offset);
+  data_ = ::operator new(block_size, std::align_val_t(CACHE_LINE_SIZE));
+  auto *block = static_cast<char *>(data_);
+  fingerprints_ = reinterpret_cast<uint8_t *>(block);
+  keys_ = reinterpret_cast<K *>(block + keys_offset);
+  values_ = reinterpret_cast<V *>(block + values_offset);
+  std::memset(fingerprints_, 0, keys_offset);
+  for (size_t i = 0; i < array_size; i++) {
+    new (&keys_[i]) K();
+    new (&values_[i]) V();
+  }
+}
+
+template <typename K, typename V>
+ExtendibleHashTable<K, V>::Bucket::~Bucket() {
+  for (size_t i = 0; i < size_; i++) {
+    keys_[i].~K();
+    values_[i].~V();
+  }
+  ::operator delete(data_, std::align_val_t(CACHE_LINE_SIZE));
 }
 
 template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Remove(const K &key) -> bool {
-  return std::any_of(list_.begin(), list_.end(), [&key, this](const auto &item) {
-    if (item.first == key) {
-      this->list_.remove(item);
-      return true;
+auto ExtendibleHashTable<K, V>::Bucket::Fingerprint(size_t hash) -> uint8_t {
+  return static_cast<uint8_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::Bucket::Probe(const K &key, uint8_t fingerprint) const -> size_t {
+#ifdef __SSE2__
+  auto needle = _mm_set1_epi8(static_cast<char>(fingerprint));
+  for (size_t group = 0; group < count_; group += GROUP_SIZE) {
+    auto fingerprints = _mm_load_si128(reinterpret_cast<const __m128i *>(&fingerprints_[group]));
+    auto matches = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(fingerprints, needle)));
+    if (count_ - group < GROUP_SIZE) {
+      matches &= (1U << (count_ - group)) - 1;
     }
+    for (; matches != 0; matches &= matches - 1) {
+      auto slot = group + __builtin_ctz(matches);
+      if (keys_[slot] == key) {
+        return slot;
+      }
+    }
+  }
+#else
+  for (size_t slot = 0; slot < count_; slot++) {
+    if (fingerprints_[slot] == fingerprint && keys_[slot] == key) {
+      return slot;
+    }
+  }
+#endif
+  return count_;
+}
+
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::Bucket::Find(const K &key, size_t hash, V &value) const -> bool {
+  auto slot = Probe(key, Fingerprint(hash));
+  if (slot == count_) {
     return false;
-  });
+  }
+  value = values_[slot];
+  return true;
 }
 
 template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Insert(const K &key, const V &value) -> bool {
-  if (IsFull()) {
+auto ExtendibleHashTable<K, V>::Bucket::Remove(const K &key, size_t hash) -> bool {
+  auto slot = Probe(key, Fingerprint(hash));
+  if (slot == count_) {
     return false;
   }
-  list_.emplace_back(key, value);
+  Erase(slot);
   return true;
 }
 
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::Bucket::Insert(const K &key, size_t hash, const V &value) -> bool {
+  auto fingerprint = Fingerprint(hash);
+  auto slot = Probe(key, fingerprint);
+  if (slot == count_) {
+    if (IsFull()) {
+      return false;
+    }
+    count_++;
+    fingerprints_[slot] = fingerprint;
+    keys_[slot] = key;
+  }
+  values_[slot] = value;
+  return true;
+}
+
+template <typename K, typename V>
+void ExtendibleHashTable<K, V>::Bucket::Split(Bucket *image) {
+  auto high_bit = static_cast<size_t>(1) << depth_;
+  for (size_t slot = 0; slot < count_;) {
+    if ((std::hash<K>()(keys_[slot]) & high_bit) == 0U) {
+      slot++;
+      continue;
+    }
+    auto image_slot = image->count_++;
+    image->fingerprints_[image_slot] = fingerprints_[slot];
+    image->keys_[image_slot] = std::move(keys_[slot]);
+    image->values_[image_slot] = std::move(values_[slot]);
+    Erase(slot);
+  }
+  depth_++;
+}
+
+template <typename K, typename V>
+void ExtendibleHashTable<K, V>::Bucket::Merge(Bucket *buddy) {
+  for (size_t slot = 0; slot < buddy->count_; slot++) {
+    fingerprints_[count_] = buddy->fingerprints_[slot];
+    keys_[count_] = std::move(buddy->keys_[slot]);
+    values_[count_] = std::move(buddy->values_[slot]);
+    count_++;
+  }
+  buddy->count_ = 0;
+  depth_--;
+}
+
+template <typename K, typename V>
+void ExtendibleHashTable<K, V>::Bucket::Erase(size_t slot) {
+  auto last = --count_;
+  if (slot != last) {
+    fingerprints_[slot] = fingerprints_[last];
+    keys_[slot] = std::move(keys_[last]);
+    values_[slot] = std::move(values_[last]);
+  }
+}
+
 template class ExtendibleHashTable<page_id_t, Page *>;
 template class ExtendibleHashTable<Page *, std::list<Page *>::iterator>;
 template class ExtendibleHashTable<int, int>;
@@ -11,12 +11,48 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include "storage/index/b_plus_tree_index.h"
+
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  auto *catalog = exec_ctx_->GetCatalog();
+  index_info_ = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info_->table_name_);
+  rids_.clear();
+  cursor_ = 0;
+
+  if (plan_->pred_key_ != nullptr) {
+    // Point lookup, which every kind of index supports
+    auto key_value = plan_->pred_key_->Evaluate(nullptr, index_info_->key_schema_);
+    Tuple key{std::vector<Value>{key_value}, &index_info_->key_schema_};
+    index_info_->index_->ScanKey(key, &rids_, exec_ctx_->GetTransaction());
+    return;
+  }
 
-void IndexScanExecutor::Init() { throw NotImplementedException("IndexScanExecutor is not implemented"); }
+  // Only a B+ tree keeps its keys in order. The RIDs are collected up front, so no leaf stays latched between calls
+  // to Next().
+  auto *tree = dynamic_cast<BPlusTreeIndexForOneIntegerColumn *>(index_info_->index_.get());
+  if (tree == nullptr) {
+    throw NotImplementedException("an index scan in key order needs a B+ tree index on one integer");
+  }
+  for (auto iter = tree->GetBeginIterator(); !iter.IsEnd(); ++iter) {
+    rids_.push_back((*iter).second);
+  }
+}
 
-auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (cursor_ < rids_.size()) {
+    auto next_rid = rids_[cursor_++];
+    // Skip entries whose tuple has been deleted since
+    if (table_info_->table_->GetTuple(next_rid, tuple, exec_ctx_->GetTransaction())) {
+      *rid = next_rid;
+      return true;
+    }
+  }
+  return false;
+}
 
 }  // namespace bustub
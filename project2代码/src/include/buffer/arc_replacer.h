@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacement_policy.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ArcReplacer implements the Adaptive Replacement Cache policy (Megiddo and Modha, FAST 2003).
+ *
+ * Resident frames are split into T1, frames accessed once since they were loaded, and T2, frames accessed again. Both
+ * are LRU lists. The pages recently evicted from each list are remembered in the ghost lists B1 and B2. A miss on a page
+ * in B1 means T1 was too small, so the target size of T1 grows; a miss on a page in B2 shrinks it. Evict() takes the
+ * least recently used evictable frame of T1 while T1 is above its target, and of T2 otherwise.
+ *
+ * Unlike the original algorithm, the victim is chosen before the page that needs the frame is known, and pinned
+ * frames are skipped. If the preferred list has no evictable frame the other list is used.
+ */
+class ArcReplacer : public ReplacementPolicy {
+ public:
+  /**
+   * @brief Create a new ArcReplacer.
+   * @param num_frames the number of frames the replacer manages
+   */
+  explicit ArcReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ArcReplacer);
+
+  ~ArcReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+  using ReplacementPolicy::RecordAccess;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  /** @return the current target size of T1 */
+  auto GetTargetRecencySize() -> size_t;
+
+ private:
+  enum class ListType { NONE, T1, T2 };
+
+  struct FrameEntry {
+    /** The list holding the frame, NONE if the frame is not tracked. */
+    ListType list_{ListType::NONE};
+    bool is_evictable_{false};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** Position of the frame in its list. */
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  struct GhostEntry {
+    /** True if the ghost is in B2, false if it is in B1. */
+    bool in_b2_;
+    std::list<page_id_t>::iterator pos_;
+  };
+
+  /** @brief Throw if frame_id is not a frame of this replacer. */
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** @return the list a frame's list type refers to */
+  auto GetList(ListType list) -> std::list<frame_id_t> & { return list == ListType::T1 ? t1_ : t2_; }
+
+  /** @return true if the next victim should come from T1 */
+  auto PreferT1() const -> bool { return !t1_.empty() && t1_.size() > target_t1_; }
+
+  /** @brief Append the evictable frames of a list to candidates, least recently used first. */
+  void CollectEvictable(const std::list<frame_id_t> &list, size_t max_frames, std::vector<frame_id_t> *candidates);
+
+  /** @brief Stop tracking a frame. Caller should acquire the latch. */
+  void Untrack(frame_id_t frame_id);
+
+  /** @brief Drop the least recently evicted ghosts until the ghost lists are within their bounds. */
+  void TrimGhosts();
+
+  /** @brief Forget the oldest ghost of a ghost list. */
+  void PopGhost(std::list<page_id_t> *ghosts);
+
+  size_t replacer_size_;
+  /** The adaptive target size of T1, between 0 and replacer_size_. */
+  size_t target_t1_{0};
+  size_t num_evictable_{0};
+  std::mutex latch_;
+
+  std::vector<FrameEntry> frames_;
+  /** Resident frames, most recently used first. */
+  std::list<frame_id_t> t1_;
+  std::list<frame_id_t> t2_;
+  /** Recently evicted pages, most recently evicted first. */
+  std::list<page_id_t> b1_;
+  std::list<page_id_t> b2_;
+  std::unordered_map<page_id_t, GhostEntry> ghosts_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+
+/**
+ * BufferAccessStrategy lets a large sequential operation (a full table scan, a bulk insert, an index build) cycle
+ * through a small private ring of frames instead of pushing the rest of the buffer pool out.
+ *
+ * When a fetch with a strategy misses, the buffer pool first tries to reuse the frame holding the page this strategy
+ * loaded ring_size misses ago. That works if the page is still resident and unpinned. A BULK_READ ring only reuses
+ * clean frames. A BULK_WRITE ring also reuses dirty frames, writing them back first. If the frame can't be reused, a
+ * victim is picked as usual and takes that slot of the ring. Hits through a strategy don't count as accesses for the
+ * replacer, so pages that a scan visits repeatedly don't look hot.
+ *
+ * A strategy is not thread-safe: create one per operation and pass it to every fetch of that operation.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManagerInstance;
+
+ public:
+  enum class Type { BULK_READ, BULK_WRITE };
+
+  /** Default ring size, in frames, of a BULK_READ strategy. */
+  static constexpr size_t BULK_READ_RING_SIZE = 8;
+  /** Default ring size, in frames, of a BULK_WRITE strategy. */
+  static constexpr size_t BULK_WRITE_RING_SIZE = 16;
+
+  /**
+   * Create a new strategy.
+   * @param type the kind of operation using the strategy
+   * @param ring_size number of frames in the ring, 0 for the default of the type
+   */
+  explicit BufferAccessStrategy(Type type, size_t ring_size = 0)
+      : type_(type),
+        ring_(ring_size != 0 ? ring_size : (type == Type::BULK_READ ? BULK_READ_RING_SIZE : BULK_WRITE_RING_SIZE),
+              INVALID_PAGE_ID) {}
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  /** @return the kind of operation using the strategy */
+  auto GetType() const -> Type { return type_; }
+
+  /** @return the number of frames in the ring */
+  auto GetRingSize() const -> size_t { return ring_.size(); }
+
+ private:
+  /** @return the page whose frame should be reused on the next miss, or INVALID_PAGE_ID */
+  auto CurrentPage() const -> page_id_t { return ring_[current_]; }
+
+  /** Record that page_id was loaded into the current slot and move on to the next one. */
+  void Advance(page_id_t page_id) {
+    ring_[current_] = page_id;
+    current_ = (current_ + 1) % ring_.size();
+  }
+
+  Type type_;
+  /** The pages loaded through this strategy, one per ring slot. */
+  std::vector<page_id_t> ring_;
+  size_t current_{0};
+};
+
+}  // namespace bustub
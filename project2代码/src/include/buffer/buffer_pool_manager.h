@@ -16,10 +16,14 @@
 #include <mutex>  // NOLINT
 #include <unordered_map>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/page_access_trace.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -30,6 +34,8 @@ class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows a page in a chain of pages, such as a table heap or the B+ tree leaves. */
+  using next_page_id_fn = page_id_t (*)(Page *page);
 
   BufferPoolManager() = default;
   /**
@@ -84,9 +90,136 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch the requested page, picking the victim frame on a miss according to strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the calling operation
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, BufferAccessStrategy &strategy) -> Page * {
+    return FetchPgWithStrategyImp(page_id, &strategy);
+  }
+
+  /**
+   * Create a new page, picking the frame for it according to strategy.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy of the calling operation
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPage(page_id_t *page_id, BufferAccessStrategy &strategy) -> Page * {
+    return NewPgWithStrategyImp(page_id, &strategy);
+  }
+
+  /**
+   * Fetch the requested page and wrap its pin in a guard, which unpins the page when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the calling operation, or nullptr
+   * @return a guard of the requested page; the guard is empty (!IsValid()) if page_id cannot be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> BasicPageGuard {
+    return {this, FetchPgWithStrategyImp(page_id, strategy)};
+  }
+
+  /**
+   * Fetch the requested page and read latch it. The guard releases the latch and the pin when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the calling operation, or nullptr
+   * @return a read guard of the requested page; the guard is empty if page_id cannot be fetched
+   */
+  auto FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> ReadPageGuard {
+    return FetchPageBasic(page_id, strategy).UpgradeRead();
+  }
+
+  /**
+   * Fetch the requested page and write latch it. The guard releases the latch and the pin when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the calling operation, or nullptr
+   * @return a write guard of the requested page; the guard is empty if page_id cannot be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) -> WritePageGuard {
+    return FetchPageBasic(page_id, strategy).UpgradeWrite();
+  }
+
+  /**
+   * Create a new page and wrap its pin in a guard. The new page is not latched and will be unpinned as dirty only if
+   * it is modified through the guard.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy of the calling operation, or nullptr
+   * @return a guard of the new page; the guard is empty if no new pages could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id, BufferAccessStrategy *strategy = nullptr) -> BasicPageGuard {
+    return {this, NewPgWithStrategyImp(page_id, strategy)};
+  }
+
+  /**
+   * Fetch the child page that an index page points to. With pointer swizzling enabled, the frame the child was found in
+   * is remembered next to the parent's child slot, and a resident child is pinned without a page table lookup.
+   * @param parent the index page that points to page_id, e.g. a B+ tree internal page. It need not be pinned, as a
+   * swip is only a hint.
+   * @param slot the child slot of parent that holds page_id
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchChildPage(Page *parent, int slot, page_id_t page_id) -> Page * {
+    return FetchChildPgImp(parent, slot, page_id);
+  }
+
+  /**
+   * Find the child page that an index page points to through the parent's swip, for an optimistic read without a pin
+   * or a latch. The buffer pool latch is not taken and the access is not counted. The caller must validate the child
+   * with Page::ValidateOptimisticLatch() after reading it, and fall back to FetchChildPage() if this fails.
+   * @param parent the index page that points to page_id; it need not be pinned
+   * @param slot the child slot of parent that holds page_id
+   * @param page_id id of page to be found
+   * @param[out] version the version of the child to validate against
+   * @return nullptr if the child is not resident in the frame its swip points to, otherwise the unpinned child
+   */
+  auto PeekChildPage(Page *parent, int slot, page_id_t page_id, uint64_t *version) -> Page * {
+    return PeekChildPgImp(parent, slot, page_id, version);
+  }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /** @return a snapshot of the buffer pool's counters and frame occupancy */
+  virtual auto GetStats() -> BufferPoolStats = 0;
+
+  /**
+   * Hint that page_id will be fetched soon. The page is read asynchronously into an unpinned frame, if a frame is
+   * available; nothing is guaranteed. The default implementation ignores the hint.
+   * @param page_id id of the page to read ahead
+   */
+  virtual void PrefetchPage(page_id_t page_id) {}
+
+  /**
+   * Look up the page that follows page_id in a chain of pages, if page_id is in the pool. The page is neither read from
+   * disk nor counted as an access, and the lookup gives up rather than wait for a writer of the page. The default
+   * implementation always gives up.
+   * @param page_id id of the page to look at
+   * @param next_page_id reads the id of the next page out of a page
+   * @return the id of the next page, or INVALID_PAGE_ID if it could not be looked up right now
+   */
+  virtual auto PeekNextPageId(page_id_t page_id, next_page_id_fn next_page_id) -> page_id_t { return INVALID_PAGE_ID; }
+
+  /**
+   * Record every page fetch, page creation and page deletion to trace, for replaying against other replacement
+   * policies later. Pass nullptr to stop recording; trace must outlive the recording. The default implementation
+   * records nothing.
+   * @param trace where to record page requests, or nullptr
+   */
+  virtual void SetAccessTrace(PageAccessTrace *trace) {}
+
+  /**
+   * Hint that the pages [first_page_id, first_page_id + num_pages) will be fetched soon.
+   * @param first_page_id id of the first page to read ahead
+   * @param num_pages number of consecutive pages to read ahead
+   */
+  virtual void PrefetchRange(page_id_t first_page_id, size_t num_pages) {
+    for (size_t i = 0; i < num_pages; i++) {
+      PrefetchPage(first_page_id + static_cast<page_id_t>(i));
+    }
+  }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -141,5 +274,47 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Fetch the requested page using an access strategy. The default implementation ignores the strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the calling operation
+   * @return the requested page
+   */
+  virtual auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgImp(page_id);
+  }
+
+  /**
+   * Creates a new page in the buffer pool using an access strategy. The default implementation ignores the strategy.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy of the calling operation
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
+    return NewPgImp(page_id);
+  }
+
+  /**
+   * Fetch the child page that an index page points to. The default implementation does not swizzle.
+   * @param parent the pinned index page that points to page_id
+   * @param slot the child slot of parent that holds page_id
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  virtual auto FetchChildPgImp(Page *parent, int slot, page_id_t page_id) -> Page * { return FetchPgImp(page_id); }
+
+  /**
+   * Find the child page that an index page points to without pinning it. The default implementation does not swizzle,
+   * so it never finds the child.
+   * @param parent the index page that points to page_id
+   * @param slot the child slot of parent that holds page_id
+   * @param page_id id of page to be found
+   * @param[out] version the version of the child to validate against
+   * @return nullptr
+   */
+  virtual auto PeekChildPgImp(Page *parent, int slot, page_id_t page_id, uint64_t *version) -> Page * {
+    return nullptr;
+  }
 };
 }  // namespace bustub
@@ -12,12 +12,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "buffer/lru_k_replacer.h"
+#include "buffer/page_access_trace.h"
+#include "buffer/replacement_policy.h"
+#include "buffer/tiny_lfu.h"
 #include "common/config.h"
 #include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
@@ -37,9 +46,24 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_type the replacement policy
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU_K);
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in the parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_type the replacement policy
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU_K);
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
@@ -49,9 +73,75 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the size (number of frames) of the buffer pool. */
   auto GetPoolSize() -> size_t override { return pool_size_; }
 
+  /** @brief Return a snapshot of the counters of this instance. Frame occupancy is counted under the latch. */
+  auto GetStats() -> BufferPoolStats override;
+
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * @brief Start the background page cleaner. Every page_cleaner_interval it looks at the frames the replacer is about
+   * to evict and writes the dirty ones back, so that a miss rarely has to write before it reads. The dirtier the pool,
+   * the more pages it writes per round; above PAGE_CLEANER_HIGH_WATERMARK it stops sleeping between rounds.
+   */
+  void StartPageCleaner();
+
+  /** @brief Stop and join the page cleaner thread, if it is running. */
+  void StopPageCleaner();
+
+  /** @brief Return the number of pages written back by the page cleaner. */
+  auto GetPagesCleaned() const -> size_t { return pages_cleaned_.load(std::memory_order_relaxed); }
+
+  /** @brief Return the number of evictions that found a victim already cleaned by the page cleaner. */
+  auto GetWritebacksAvoided() const -> size_t { return writebacks_avoided_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Queue an asynchronous read of page_id into an unpinned frame. The read is done by a prefetch thread, started
+   * on the first call. Hints for pages already in the pool, pages that are not allocated, or hints that arrive while
+   * PREFETCH_QUEUE_SIZE reads are already queued are dropped.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPage(page_id_t page_id) override;
+
+  /**
+   * @brief Read the next page id out of a resident page that is not being read in. The frame is pinned for the read,
+   * which is optimistic: it fails if the page is write latched, during or before the read.
+   */
+  auto PeekNextPageId(page_id_t page_id, next_page_id_fn next_page_id) -> page_id_t override;
+
+  /** @brief Record every fetch, new page and deleted page to trace, or stop recording if trace is nullptr. */
+  void SetAccessTrace(PageAccessTrace *trace) override;
+
+  /** @brief Return the number of pages read in by the prefetch thread. */
+  auto GetPagesPrefetched() const -> size_t { return pages_prefetched_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Enable pointer swizzling for FetchChildPage(). Every frame gets SWIP_SLOTS child references, which costs
+   * SWIP_SLOTS * sizeof(frame_id_t) bytes per frame. Call this before the buffer pool is used concurrently.
+   */
+  void EnableSwizzling();
+
+  /** @brief Return the number of FetchChildPage() calls that found the child through a swip. */
+  auto GetSwizzledFetches() const -> size_t { return swizzled_fetches_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Enable the TinyLFU admission filter. A miss that has to evict may only take the replacer's victim if the
+   * missing page was requested more often recently than the victim. A page that loses goes to a probation area of
+   * pool_size / PROBATION_DIVISOR frames instead, and takes the frame of the oldest page on probation. That page is
+   * only spared if by now it was requested more often than the replacer's victim; it then leaves probation for good.
+   * Fetches with an access strategy, new pages and prefetches are always admitted. Call this before the buffer pool is
+   * used concurrently.
+   */
+  void EnableAdmissionFilter();
+
+  /** @brief Return the number of misses that the admission filter sent to the probation area. */
+  auto GetAdmissionsRejected() const -> size_t { return admissions_rejected_.load(std::memory_order_relaxed); }
+
+  /** @brief Return the fraction of frames that hold a dirty page. */
+  auto GetDirtyRatio() const -> double {
+    return static_cast<double>(dirty_frames_.load(std::memory_order_relaxed)) / static_cast<double>(pool_size_);
+  }
+
  protected:
   /**
    * TODO(P1): Add implementation
@@ -113,6 +203,9 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * Use the DiskManager::WritePage() method to flush a page to disk, REGARDLESS of the dirty flag.
    * Unset the dirty flag of the page after flushing.
    *
+   * The page is pinned and copied under its read latch, and the copy is written with latch_ released. The caller must
+   * not hold the page's write latch.
+   *
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
@@ -121,10 +214,34 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Flush all the pages in the buffer pool to disk.
+   * @brief Flush all the pages in the buffer pool to disk, IO_BATCH_SIZE pages at a time, and sync the disk so that they
+   * are durable. Like FlushPgImp(), every page is written from a copy taken under its read latch, so the caller must not
+   * hold the write latch of any page.
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * @brief Fetch a page like FetchPgImp(), but on a miss reuse a frame from the strategy's ring when possible. A hit
+   * does not count as an access for the replacer.
+   */
+  auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /** @brief Create a new page like NewPgImp(), reusing a frame from the strategy's ring when possible. */
+  auto NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Fetch a child page like FetchPgImp(), but try the swip in the parent's slot first. A swip that still points
+   * to a frame holding page_id pins that frame without a page table lookup; otherwise the swip is refreshed after a
+   * regular fetch.
+   */
+  auto FetchChildPgImp(Page *parent, int slot, page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Find a child page through the swip in the parent's slot, without taking latch_ or pinning the child. The
+   * swip is only followed if the frame it points to holds page_id and is not being loaded or write latched.
+   */
+  auto PeekChildPgImp(Page *parent, int slot, page_id_t page_id, uint64_t *version) -> Page * override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -132,8 +249,8 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * page is pinned and cannot be deleted, return false immediately.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
-   * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
-   * imitate freeing the page on the disk.
+   * back to the free list. Also, reset the page's memory and metadata. Finally, call DeallocatePage() to free the page
+   * on disk. A page that is not in the buffer pool is freed on disk too, once its write-back, if any, has finished.
    *
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
@@ -142,8 +259,10 @@ class BufferPoolManagerInstance : public BufferPoolManager {
 
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
-  /** The next page id to be allocated  */
-  std::atomic<page_id_t> next_page_id_ = 0;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
   /** Bucket size for the extendible hash table */
   const size_t bucket_size_ = 4;
 
@@ -156,25 +275,235 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** Page table for keeping track of buffer pool pages. */
   ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
   /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
+  std::unique_ptr<ReplacementPolicy> replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch protects the page table, the free list, the page metadata and the I/O bookkeeping below. It is not held
+   * during disk I/O on a miss; the frame being loaded is pinned and flagged in io_in_progress_ instead.
+   */
   std::mutex latch_;
+  /** io_in_progress_[i] is true while frame i is writing back its old page or reading in its new one. */
+  std::vector<bool> io_in_progress_;
+  /** Per-frame condition variables, signalled when the I/O on that frame completes. Waiters hold latch_. */
+  std::condition_variable *frame_cv_;
+  /** Evicted pages whose write-back is still in flight, mapped to the frame doing the write. */
+  std::unordered_map<page_id_t, frame_id_t> writeback_pages_;
+
+  /** The page cleaner looks at the next victims up to this fraction of the pool, and writes at most that many pages
+   * per round. */
+  static constexpr double PAGE_CLEANER_LOOKAHEAD = 0.25;
+  /** Above this dirty ratio the page cleaner runs at full speed. */
+  static constexpr double PAGE_CLEANER_HIGH_WATERMARK = 0.5;
+  /** Number of frames holding a dirty page. Written under latch_, read without it. */
+  std::atomic<size_t> dirty_frames_{0};
+  /** cleaned_[i] is true if the page in frame i was written back by the page cleaner and is still clean. */
+  std::vector<bool> cleaned_;
+  /** Statistics exposed by the page cleaner. */
+  std::atomic<size_t> pages_cleaned_{0};
+  std::atomic<size_t> writebacks_avoided_{0};
+  std::atomic<bool> enable_page_cleaner_{false};
+  std::thread *page_cleaner_thread_{nullptr};
+
+  /** Child references per frame; enough for an internal page with 4-byte keys. */
+  static constexpr size_t SWIP_SLOTS = BUSTUB_PAGE_SIZE / (sizeof(int32_t) + sizeof(page_id_t));
+  /** Backing storage of the swips_ of every frame, null unless swizzling is enabled. */
+  std::unique_ptr<std::atomic<frame_id_t>[]> swips_;
+  std::atomic<size_t> swizzled_fetches_{0};
+
+  /** Request counters reported by GetStats(). Most are bumped under latch_, but all are read without it. */
+  std::atomic<size_t> fetches_{0};
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+  std::atomic<size_t> new_pages_{0};
+  std::atomic<size_t> failed_requests_{0};
+  std::atomic<size_t> evictions_{0};
+  std::atomic<size_t> dirty_writebacks_{0};
+
+  /** The probation area of the admission filter is this fraction of the pool, but at least one frame. */
+  static constexpr size_t PROBATION_DIVISOR = 32;
+  /** Admission filter, null unless enabled. It and the probation bookkeeping below are protected by latch_. */
+  std::unique_ptr<TinyLfu> admission_filter_;
+  size_t probation_size_{0};
+  /** Pages read in against the advice of the admission filter, oldest first. */
+  std::deque<page_id_t> probation_;
+  /** on_probation_[i] is true while frame i holds a page from probation_. */
+  std::vector<bool> on_probation_;
+  std::atomic<size_t> admissions_rejected_{0};
+
+  /** Where page requests are recorded, or nullptr. Protected by latch_. */
+  PageAccessTrace *trace_{nullptr};
+
+  /** Maximum number of queued prefetch requests. */
+  static constexpr size_t PREFETCH_QUEUE_SIZE = 64;
+  /** The most page reads or writes handed to the disk manager in one batch by the prefetcher, the page cleaner and
+   * FlushAllPages(). */
+  static constexpr size_t IO_BATCH_SIZE = 64;
+  /** Protects the prefetch queue and the prefetch thread pointer. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::deque<page_id_t> prefetch_queue_;
+  std::atomic<size_t> pages_prefetched_{0};
+  bool enable_prefetcher_{false};
+  std::thread *prefetch_thread_{nullptr};
+
+  /**
+   * @brief Pick a frame for a new page. With a strategy, the frame in the strategy's current ring slot is reused if
+   * possible. Otherwise the frame comes from the free list first and from the replacer second. The victim's page table
+   * entry is removed; a dirty victim is recorded in writeback_pages_ and must be written back by LoadFrame(). Caller
+   * should acquire the latch before calling this function.
+   * @param[out] frame_id id of the frame that is now free to hold a page
+   * @param[out] victim_page_id id of the dirty page still held by the frame, INVALID_PAGE_ID if there is none
+   * @param strategy the access strategy of the caller, or nullptr
+   * @return false if every frame is pinned, true otherwise
+   */
+  auto AcquireFrame(frame_id_t *frame_id, page_id_t *victim_page_id, BufferAccessStrategy *strategy = nullptr)
+      -> bool;
+
+  /**
+   * @brief Take the frame of the page in the strategy's current ring slot out of the replacer, if that page is still
+   * resident and can be replaced. Caller should acquire the latch before calling this function.
+   * @param[out] frame_id the frame to reuse
+   * @param strategy the access strategy of the caller
+   * @return true if the frame can be reused
+   */
+  auto AcquireRingFrame(frame_id_t *frame_id, BufferAccessStrategy *strategy) -> bool;
+
+  /**
+   * @brief Ask the admission filter whether page_id may evict the replacer's next victim. Always true if the filter is
+   * disabled or no eviction is needed. Caller should acquire the latch before calling this function.
+   * @param page_id the missing page
+   * @param[out] rival_page_id the page held by the replacer's next victim, set if page_id is rejected
+   */
+  auto AdmitPage(page_id_t page_id, page_id_t *rival_page_id) -> bool;
+
+  /**
+   * @brief Take the frame of the oldest page on probation out of the replacer, if the probation area is full and that
+   * page can be replaced. Pages on the way that are pinned, or that were requested more often than the rival, leave
+   * probation and keep their frame. Caller should acquire the latch before calling this function.
+   * @param rival_page_id the page held by the replacer's next victim
+   * @param[out] frame_id the frame to reuse
+   * @param[out] victim_page_id id of the dirty page still held by the frame, INVALID_PAGE_ID if there is none
+   * @return true if a frame was found
+   */
+  auto AcquireProbationFrame(page_id_t rival_page_id, frame_id_t *frame_id, page_id_t *victim_page_id) -> bool;
+
+  /**
+   * @brief Drop the page held by a frame that was taken out of the replacer. See AcquireFrame(). Caller should acquire
+   * the latch before calling this function.
+   */
+  void EvictFrame(frame_id_t frame_id, page_id_t *victim_page_id);
+
+  /**
+   * @brief Fetch a page like FetchPgWithStrategyImp(). Caller should acquire the latch before calling this function;
+   * it is released during disk I/O.
+   */
+  auto FetchPageLocked(std::unique_lock<std::mutex> *lock, page_id_t page_id, BufferAccessStrategy *strategy)
+      -> Page *;
+
+  /**
+   * @brief Pin a frame that holds a page and wait until its I/O is done. Caller should acquire the latch before calling
+   * this function.
+   */
+  void PinResidentFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id, BufferAccessStrategy *strategy);
+
+  /** @brief Record a page request to the access trace, if any. Caller should acquire the latch. */
+  void TraceAccess(PageAccessTrace::EventType type, page_id_t page_id);
+
+  /** @brief Unswizzle all child references of a frame, because its page is leaving it. */
+  void ResetSwips(frame_id_t frame_id);
+
+  /**
+   * @brief Map page_id to frame_id, pin the frame and mark it as I/O in progress. Caller should acquire the latch
+   * before calling this function.
+   */
+  void InstallPage(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Write back the victim of a frame installed by InstallPage() and fill the frame with its new page, then clear
+   * the I/O in progress flag and wake up waiters. The latch is released during disk I/O.
+   * @param lock the caller's lock on latch_, held on entry and on return
+   * @param frame_id the frame to load
+   * @param victim_page_id the dirty page to write back first, or INVALID_PAGE_ID
+   * @param read_page true to read the page from disk, false to zero the frame for a new page
+   */
+  void LoadFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id, page_id_t victim_page_id, bool read_page);
 
   /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Set the dirty flag of the page in a frame and keep dirty_frames_ up to date. Caller should acquire the latch
+   * before calling this function.
+   */
+  void SetDirty(frame_id_t frame_id, bool is_dirty);
+
+  /** @brief Main loop of the prefetch thread. */
+  void RunPrefetcher();
+
+  /** @brief Stop and join the prefetch thread, if it is running. */
+  void StopPrefetcher();
+
+  /**
+   * @brief Read the pages into free or evicted frames and leave them unpinned. The dirty victims are written back in one
+   * batch and the pages read in another. Pages already in the pool are skipped, and so are the rest once no frame is
+   * available.
+   */
+  void LoadPrefetchedPages(const std::vector<page_id_t> &page_ids);
+
+  /** @brief Main loop of the page cleaner thread. */
+  void RunPageCleaner();
+
+  /**
+   * @brief Write back the pages of frames pinned by PinForWriteBack() for the page cleaner, each copied under its read
+   * latch, and count them as cleaned.
+   * @param lock the caller's lock on latch_, held on entry and on return
+   * @param frame_ids the frames to clean
+   */
+  void CleanFrames(std::unique_lock<std::mutex> *lock, const std::vector<frame_id_t> &frame_ids);
+
+  /**
+   * @brief Pin a frame whose page is about to be written back and clear its dirty flag. Caller should acquire the latch
+   * before calling this function.
+   */
+  void PinForWriteBack(frame_id_t frame_id);
+
+  /**
+   * @brief Write back the pages of frames pinned by PinForWriteBack() in one batch, then unpin them. Each page is copied
+   * under its read latch, so that what is checksummed and written is a consistent page. latch_ is not held during the
+   * copies or the writes.
+   * @param lock the caller's lock on latch_, held on entry and on return
+   * @param frame_ids the frames to write back
+   */
+  void WriteBackFrames(std::unique_lock<std::mutex> *lock, const std::vector<frame_id_t> &frame_ids);
+
+  /**
+   * @brief Allocate a page on disk, reusing a free page congruent to instance_index_ if there is one. Caller should
+   * acquire the latch before calling this function.
+   *
+   * A reader that looked up a page id just before the page was deleted may have loaded the freed page back into the
+   * pool. A reused id must not be mapped to a second frame, so a stale copy that nobody has pinned is discarded, and an
+   * id whose stale copy is pinned or still being written back is skipped and stays free.
    * @return the id of the allocated page
    */
   auto AllocatePage() -> page_id_t;
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Drop the page of an unpinned frame without writing it back, and return the frame to the free list. Caller
+   * should acquire the latch before calling this function.
+   */
+  void DiscardFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
+   * validate input data and ensure that a parallel BPM is routing requests to the correct BPI.
+   * @param page_id the id of the page to validate
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
+  /**
+   * @brief Deallocate a page on disk, so that it can be reused. Caller should acquire the latch before calling this
+   * function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   // TODO(student): You may add additional private members and helper functions
 };
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * BufferPoolStats is a snapshot of the counters of a buffer pool, returned by BufferPoolManager::GetStats().
+ *
+ * The counters are relaxed atomics that are read one at a time, so a snapshot taken while other threads use the pool
+ * is not a consistent cut: hits_ + misses_ may lag behind fetches_ by the requests that are still in flight. The frame
+ * counts at the end are taken under the buffer pool latch and are consistent with each other.
+ */
+struct BufferPoolStats {
+  /** Number of frames. */
+  size_t pool_size_{0};
+  /** Requests for an existing page, through any of the Fetch* methods. */
+  size_t fetches_{0};
+  /** Fetches that found the page in the pool. */
+  size_t hits_{0};
+  /** Fetches that had to read the page from disk. */
+  size_t misses_{0};
+  /** Pages created by NewPage(). */
+  size_t new_pages_{0};
+  /** Fetches and new pages that returned nullptr because every frame was pinned. */
+  size_t failed_requests_{0};
+  /** Pages dropped from their frame to make room for another page. */
+  size_t evictions_{0};
+  /** Evicted pages that were dirty and had to be written back by the evicting thread. */
+  size_t dirty_writebacks_{0};
+  /** Pages written back by the page cleaner. */
+  size_t pages_cleaned_{0};
+  /** Evictions that found their victim already written back by the page cleaner. */
+  size_t writebacks_avoided_{0};
+  /** Pages read in by the prefetch thread. */
+  size_t pages_prefetched_{0};
+  /** Fetches that found the child through a swip. */
+  size_t swizzled_fetches_{0};
+  /** Misses that the admission filter sent to the probation area instead of evicting the replacer's victim. */
+  size_t admissions_rejected_{0};
+  /** Frames that hold no page. */
+  size_t free_frames_{0};
+  /** Frames whose page is pinned. */
+  size_t pinned_frames_{0};
+  /** Frames whose page is dirty. */
+  size_t dirty_frames_{0};
+  /** Bytes held by the page table, see ExtendibleHashTable::GetMemoryUsage(). */
+  size_t page_table_bytes_{0};
+  /** resident_pages_[t] is the number of frames that hold a page of PageType t. */
+  std::array<size_t, NUM_PAGE_TYPES> resident_pages_{};
+
+  /** @return the fraction of fetches that found their page in the pool, 0 if nothing was fetched yet */
+  auto HitRatio() const -> double;
+
+  /** Add the counters of another buffer pool, e.g. another instance of a parallel buffer pool. */
+  auto operator+=(const BufferPoolStats &other) -> BufferPoolStats &;
+
+  /** @return every statistic as a (name, value) pair, in a fixed order */
+  auto ToRows() const -> std::vector<std::pair<std::string, std::string>>;
+
+  /** @return the statistics, one "name: value" line each */
+  auto ToString() const -> std::string;
+};
+
+}  // namespace bustub
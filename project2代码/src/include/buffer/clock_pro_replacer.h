@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.h
+//
+// Identification: src/include/buffer/clock_pro_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacement_policy.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ClockProReplacer implements CLOCK-Pro (Jiang, Chen and Zhang, USENIX ATC 2005), which approximates LIRS with clock
+ * hands instead of a stack.
+ *
+ * Every resident frame is hot or cold and has a reference bit, set on each access. A newly loaded page is cold and in
+ * its test period. The cold hand sweeps the frames: an unreferenced cold frame is evicted, and if it was in its test
+ * period its page is remembered as a non-resident test page. A referenced cold frame in its test period has shown a
+ * short reuse distance and turns hot; otherwise it starts a new test period. A page that is loaded again while it is a
+ * non-resident test page turns hot right away. The hot hand demotes unreferenced hot frames to cold whenever there are
+ * more hot frames than the cold target leaves room for, and ends the test periods it passes.
+ *
+ * The cold target adapts: it grows when a non-resident test page comes back, and shrinks when a test period ends
+ * without one. It starts at a quarter of the frames and stays between 1 and the number of frames minus 1.
+ *
+ * Here the clock is the array of frames, so a page keeps the clock position of its frame instead of moving to the
+ * head, and the non-resident test pages live in a FIFO of at most as many pages as there are frames.
+ */
+class ClockProReplacer : public ReplacementPolicy {
+ public:
+  /**
+   * @brief Create a new ClockProReplacer.
+   * @param num_frames the number of frames the replacer manages
+   */
+  explicit ClockProReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ClockProReplacer);
+
+  ~ClockProReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+  using ReplacementPolicy::RecordAccess;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  /** @return the current target number of cold frames */
+  auto GetColdTarget() -> size_t;
+
+ private:
+  struct FrameEntry {
+    bool is_tracked_{false};
+    bool is_evictable_{false};
+    bool is_hot_{false};
+    bool referenced_{false};
+    bool in_test_{false};
+    page_id_t page_id_{INVALID_PAGE_ID};
+  };
+
+  /** @brief Throw if frame_id is not a frame of this replacer. */
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /**
+   * @brief Move the cold hand by one frame. Caller should acquire the latch.
+   * @param[out] frame_id the evicted frame, if any
+   * @return true if the frame under the hand was evicted
+   */
+  auto RunHandCold(frame_id_t *frame_id) -> bool;
+
+  /** @brief Move the hot hand by one frame. Caller should acquire the latch. */
+  void RunHandHot();
+
+  /** @brief Turn a tracked frame hot or cold and keep the counters up to date. Caller should acquire the latch. */
+  void SetHot(frame_id_t frame_id, bool is_hot);
+
+  /** @brief Stop tracking a frame. Caller should acquire the latch. */
+  void Untrack(frame_id_t frame_id);
+
+  /** @brief Remember a page whose frame was evicted during its test period. Caller should acquire the latch. */
+  void AddTestPage(page_id_t page_id);
+
+  void ShrinkColdTarget() { cold_target_ = cold_target_ > 1 ? cold_target_ - 1 : 1; }
+
+  size_t replacer_size_;
+  size_t cold_target_;
+  size_t num_hot_{0};
+  size_t num_evictable_{0};
+  /** Number of tracked frames that are cold and evictable, the only frames the cold hand can evict. */
+  size_t num_cold_evictable_{0};
+  size_t hand_cold_{0};
+  size_t hand_hot_{0};
+  std::mutex latch_;
+
+  std::vector<FrameEntry> frames_;
+  /** Non-resident pages in their test period, most recently evicted first. */
+  std::list<page_id_t> test_pages_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> test_page_map_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_clock_replacer.h
+//
+// Identification: src/include/buffer/concurrent_clock_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "buffer/replacement_policy.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ConcurrentClockReplacer implements the CLOCK policy without a latch. Every frame has one atomic state byte holding a
+ * tracked bit, an evictable bit and a reference bit, and every state change is a single compare-and-swap on it.
+ *
+ * An access sets the reference bit, and does not even write to the state if the bit is already set, so the hit path of
+ * a buffer pool only loads a byte that is mostly shared in every core's cache. Evict() moves the shared clock hand
+ * with an atomic increment, so concurrent evictions look at different frames. A referenced frame under the hand gets a
+ * second chance: its bit is cleared and the hand moves on. An unreferenced evictable frame is claimed by swapping its
+ * state to untracked; if another thread changed the frame in the meantime, the swap fails and the hand moves on.
+ */
+class ConcurrentClockReplacer : public ReplacementPolicy {
+ public:
+  /**
+   * @brief Create a new ConcurrentClockReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit ConcurrentClockReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ConcurrentClockReplacer);
+
+  ~ConcurrentClockReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+  using ReplacementPolicy::RecordAccess;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
+
+ private:
+  static constexpr uint8_t TRACKED = 1;
+  static constexpr uint8_t EVICTABLE = 2;
+  static constexpr uint8_t REFERENCED = 4;
+
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  const size_t replacer_size_;
+  /** state_[i] is a combination of TRACKED, EVICTABLE and REFERENCED; 0 for a frame that is not tracked. */
+  std::unique_ptr<std::atomic<uint8_t>[]> state_;
+  /** Frames handed to Evict() so far. The clock hand is this count modulo the number of frames. */
+  std::atomic<size_t> hand_{0};
+  std::atomic<size_t> num_evictable_{0};
+};
+
+}  // namespace bustub
@@ -12,12 +12,12 @@
 
 #pragma once
 
-#include <limits>
-#include <list>
+#include <map>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "buffer/replacement_policy.h"
 #include "common/config.h"
 #include "common/macros.h"
 
@@ -33,8 +33,11 @@ namespace bustub {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * The replacer keeps the last k access timestamps of every frame, and an ordered index of the evictable frames only.
+ * Evict() takes the first frame of the index, so it costs O(log n) no matter how many frames are pinned.
  */
-class LRUKReplacer {
+class LRUKReplacer : public ReplacementPolicy {
  public:
   /**
    *
@@ -52,7 +55,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
    * TODO(P1): Add implementation
@@ -70,7 +73,7 @@ class LRUKReplacer {
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
@@ -82,8 +85,10 @@ class LRUKReplacer {
    * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
    *
    * @param frame_id id of frame that received a new access.
+   * @param page_id ignored, LRU-K keeps no history of evicted pages
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+  using ReplacementPolicy::RecordAccess;
 
   /**
    * TODO(P1): Add implementation
@@ -102,7 +107,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -121,7 +126,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -130,26 +135,54 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  /**
+   * @brief Return up to max_frames evictable frames, in the order Evict() would pick them. Nothing is evicted; this is
+   * used by the page cleaner to look ahead at upcoming victims.
+   *
+   * @param max_frames the maximum number of frames to return
+   * @return the next frames to be evicted, first victim first
+   */
+  auto GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  [[maybe_unused]] size_t current_timestamp_{0};
-  size_t curr_size_{0};
-  size_t replacer_size_;
-  size_t k_;
-  std::mutex latch_;
+  /**
+   * Position of an evictable frame in the eviction order: frames with +inf backward k-distance come first, and within
+   * each group the frame whose oldest remembered access is the earliest. For a frame with k accesses that access is
+   * the k-th most recent one, so this is the largest backward k-distance first. Timestamps are unique, so are keys.
+   */
+  using EvictionKey = std::pair<bool, size_t>;
+
+  struct FrameEntry {
+    /** Number of accesses since the frame was last evicted or removed; 0 if the frame is not tracked. */
+    size_t access_count_{0};
+    bool is_evictable_{false};
+  };
 
-  std::unordered_map<frame_id_t, size_t> access_count_;
+  /** @brief Throw if frame_id is not a frame of this replacer. */
+  void CheckFrameId(frame_id_t frame_id) const;
 
-  std::list<frame_id_t> history_list_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> history_map_;
+  /** @brief Return the eviction order of a tracked frame. Caller should acquire the latch. */
+  auto GetEvictionKey(frame_id_t frame_id) const -> EvictionKey;
 
-  std::list<frame_id_t> cache_list_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> cache_map_;
+  /** @brief Stop tracking a frame that is in evictable_. Caller should acquire the latch. */
+  void RemoveEvictable(frame_id_t frame_id);
+
+  size_t current_timestamp_{0};
+  size_t replacer_size_;
+  size_t k_;
+  std::mutex latch_;
 
-  std::unordered_map<frame_id_t, bool> is_evictable_;
+  /** frames_[i] is the state of frame i. */
+  std::vector<FrameEntry> frames_;
+  /**
+   * The last k access timestamps of every frame: frame i owns slots [i * k, (i + 1) * k), written round robin, so
+   * access number n of the frame goes to slot n % k.
+   */
+  std::vector<size_t> history_;
+  /** The evictable frames, in the order Evict() picks them. */
+  std::map<EvictionKey, frame_id_t> evictable_;
 };
 
 }  // namespace bustub
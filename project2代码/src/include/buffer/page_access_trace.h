@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_access_trace.h
+//
+// Identification: src/include/buffer/page_access_trace.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <iostream>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageAccessTrace records the page requests a buffer pool serves, so that they can be replayed against other
+ * replacement policies offline. Every event is one line of text, "F <page_id>" for a fetch, "N <page_id>" for a new page
+ * and "D <page_id>" for a deleted page. A trace may be shared by all instances of a parallel buffer pool.
+ */
+class PageAccessTrace {
+ public:
+  enum class EventType : char { FETCH = 'F', NEW = 'N', DELETE = 'D' };
+
+  struct Event {
+    EventType type_;
+    page_id_t page_id_;
+  };
+
+  /**
+   * @brief Create a trace that writes to out. The stream must outlive the trace.
+   * @param out the stream to write events to
+   */
+  explicit PageAccessTrace(std::ostream *out) : out_(out) {}
+
+  DISALLOW_COPY_AND_MOVE(PageAccessTrace);
+
+  /** @brief Append an event to the trace. Thread-safe. */
+  void Record(EventType type, page_id_t page_id);
+
+  /**
+   * @brief Read back a trace written by Record(). Reading stops at the first malformed line.
+   * @param in the stream to read from
+   * @return the events, in the order they were recorded
+   */
+  static auto Read(std::istream *in) -> std::vector<Event>;
+
+ private:
+  std::mutex latch_;
+  std::ostream *out_;
+};
+
+}  // namespace bustub
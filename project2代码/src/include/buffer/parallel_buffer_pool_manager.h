@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/config.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool into several BufferPoolManagerInstances, each with its own latch.
+ * A page id is always owned by instance `page_id % num_instances`, so operations on pages that live in different
+ * instances never contend with each other.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager shared by all instances
+   * @param replacer_k the lookback constant k for the LRU-K replacer of each instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of each instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU_K);
+
+  /**
+   * @brief Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override = default;
+
+  /** @brief Return the total size (number of frames) of all buffer pool instances. */
+  auto GetPoolSize() -> size_t override { return num_instances_ * pool_size_; }
+
+  /** @brief Return the sum of the statistics of all instances. */
+  auto GetStats() -> BufferPoolStats override;
+
+  /** @brief Return the number of BufferPoolManagerInstances. */
+  auto GetNumInstances() const -> size_t { return num_instances_; }
+
+  /**
+   * @brief Return the BufferPoolManagerInstance responsible for handling the given page id.
+   * @param page_id id of the page
+   * @return the instance that owns page_id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * @brief Forward the prefetch hint to the instance that owns the page.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPage(page_id_t page_id) override;
+
+  /** @brief Ask the instance that owns page_id for the page that follows it. */
+  auto PeekNextPageId(page_id_t page_id, next_page_id_fn next_page_id) -> page_id_t override;
+
+  /** @brief Record the page requests of every instance to the same trace. */
+  void SetAccessTrace(PageAccessTrace *trace) override;
+
+  /** @brief Start the page cleaner of every instance. */
+  void StartPageCleaner();
+
+  /** @brief Stop the page cleaner of every instance. */
+  void StopPageCleaner();
+
+  /** @brief Enable pointer swizzling in every instance. A child is swizzled by the instance that owns it. */
+  void EnableSwizzling();
+
+  /** @brief Enable the admission filter of every instance. Each instance keeps its own sketch and probation area. */
+  void EnableAdmissionFilter();
+
+ protected:
+  /**
+   * @brief Fetch the requested page from the instance that owns it.
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Unpin the target page from the instance that owns it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page is not in the page table or its pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page to disk through the instance that owns it.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Create a new page. Instances are tried round robin, starting from a different instance on every call so
+   * that allocations spread evenly. Every instance allocates page ids from its own stripe, so no global lock is
+   * needed.
+   * @param[out] page_id id of created page
+   * @return nullptr if no instance could create a new page, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * @brief Delete a page from the instance that owns it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the pages of every instance to disk.
+   */
+  void FlushAllPgsImp() override;
+
+  /**
+   * @brief Fetch the requested page from the instance that owns it, using an access strategy. A ring slot can only be
+   * reused by a miss in the instance that owns the page in it.
+   */
+  auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /** @brief Create a new page like NewPgImp(), using an access strategy. */
+  auto NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /** @brief Fetch a child page through the instance that owns it, which checks and refreshes the parent's swip. */
+  auto FetchChildPgImp(Page *parent, int slot, page_id_t page_id) -> Page * override;
+
+  /** @brief Find a child page without a pin through the instance that owns it. */
+  auto PeekChildPgImp(Page *parent, int slot, page_id_t page_id, uint64_t *version) -> Page * override;
+
+ private:
+  /** Number of BufferPoolManagerInstances. */
+  const size_t num_instances_;
+  /** Number of frames in each instance. */
+  const size_t pool_size_;
+  /** The instance NewPgImp() starts probing from on its next call. */
+  std::atomic<size_t> next_instance_{0};
+  /** The shards of the buffer pool. Instance i owns every page id p with p % num_instances_ == i. */
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> instances_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead.h
+//
+// Identification: src/include/buffer/read_ahead.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * ReadAheadDetector watches a scan move along a chain of pages and, once the scan has followed the chain for a few
+ * steps, asks the buffer pool to prefetch the pages ahead of it. The pages ahead are found through the chain itself:
+ * the scan reports the next page id of every page it reads, and the detector walks further with PeekNextPageId() on
+ * the pages that are already in the pool, so page ids need not be contiguous. The walk stops at a page that is not in
+ * the pool yet, so on a cold scan it only gets a page or two ahead. While every step of the run has gone to the page
+ * id after the last one, the detector guesses that the chain goes on that way past where the walk stopped, and
+ * prefetches the ids that follow. A step that breaks the pattern drops the guesses, which the pool evicts like any
+ * page that is not fetched, and starts the window over from the chain. The prefetch window starts small and doubles
+ * every time it is refilled, up to READ_AHEAD_MAX_WINDOW pages; a scattered chain only fills it as far as its pages
+ * are in the pool. A step that leaves the chain resets the detector.
+ *
+ * TableIterator uses it on the table heap's next-page chain and IndexIterator on the B+ tree leaf chain.
+ */
+class ReadAheadDetector {
+ public:
+  /** Number of consecutive steps along the chain before the first prefetch is issued. */
+  static constexpr size_t READ_AHEAD_TRIGGER = 2;
+  /** Size of the first prefetch window. */
+  static constexpr size_t READ_AHEAD_MIN_WINDOW = 4;
+  /** Upper bound of the prefetch window. */
+  static constexpr size_t READ_AHEAD_MAX_WINDOW = 32;
+
+  /**
+   * @param bpm the buffer pool to prefetch into, or nullptr to never prefetch
+   * @param next_page_id reads the id of the next page in the chain out of a page
+   */
+  ReadAheadDetector(BufferPoolManager *bpm, BufferPoolManager::next_page_id_fn next_page_id)
+      : bpm_(bpm), next_page_id_(next_page_id) {}
+
+  /**
+   * Report that the scan has moved on to page_id. May issue PrefetchPage() calls on the buffer pool.
+   * @param page_id id of the page the scan is now reading
+   * @param next_page_id id of the page that follows page_id in the chain, as read by the scan
+   */
+  void OnPageAccess(page_id_t page_id, page_id_t next_page_id);
+
+ private:
+  BufferPoolManager *bpm_;
+  BufferPoolManager::next_page_id_fn next_page_id_;
+  /** The next page id reported by the previous call, where the scan goes if it stays on the chain. */
+  page_id_t expected_page_id_{INVALID_PAGE_ID};
+  /** Number of steps along the chain seen in a row. */
+  size_t run_length_{0};
+  /** Size of the current prefetch window. */
+  size_t window_{READ_AHEAD_MIN_WINDOW};
+  /** Last page prefetched so far, the page to walk on from. */
+  page_id_t frontier_{INVALID_PAGE_ID};
+  /** Number of prefetched pages the scan has not reached yet. */
+  size_t ahead_{0};
+  /** Whether the last refill reached the full window, so the next one doubles it. */
+  bool filled_{false};
+  /** Whether every step of the run went to the page id after the one before. */
+  bool contiguous_{false};
+  /** How many of the prefetched pages ahead, the last ones, were guessed rather than found in the chain. */
+  size_t guessed_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacement_policy.h
+//
+// Identification: src/include/buffer/replacement_policy.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** The replacement policies a BufferPoolManagerInstance can be constructed with. */
+enum class ReplacerType { LRU_K, ARC, TWO_Q, CLOCK_PRO, CLOCK };
+
+/**
+ * ReplacementPolicy is the interface between a BufferPoolManagerInstance and its replacer. The buffer pool reports every
+ * access to a frame and every pin state change, and asks for a victim when it needs a frame.
+ *
+ * A frame is tracked from its first RecordAccess() until it is evicted or removed. The page id passed to the first
+ * access of a frame names the page it holds, so that policies which remember recently evicted pages (ARC, 2Q,
+ * CLOCK-Pro) can recognize the page when it comes back. Later accesses may pass INVALID_PAGE_ID.
+ *
+ * All methods are thread-safe.
+ */
+class ReplacementPolicy {
+ public:
+  ReplacementPolicy() = default;
+  virtual ~ReplacementPolicy() = default;
+
+  /**
+   * Find a victim among the evictable frames, stop tracking it and return it.
+   * @param[out] frame_id the evicted frame
+   * @return false if no frame is evictable
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * Record an access to a frame. Starts tracking the frame, non-evictable, if it is not tracked yet.
+   * @param frame_id the accessed frame; throws OUT_OF_RANGE if it is not a frame of this replacer
+   * @param page_id the page held by the frame, or INVALID_PAGE_ID if the caller does not know it
+   */
+  virtual void RecordAccess(frame_id_t frame_id, page_id_t page_id) = 0;
+
+  /** Record an access to a frame whose page is of no interest to the policy. */
+  void RecordAccess(frame_id_t frame_id) { RecordAccess(frame_id, INVALID_PAGE_ID); }
+
+  /**
+   * Mark a tracked frame as evictable or not. Does nothing for a frame that is not tracked.
+   * @param frame_id the frame; throws OUT_OF_RANGE if it is not a frame of this replacer
+   * @param set_evictable whether the frame may be evicted
+   */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /**
+   * Stop tracking a frame without evicting it, e.g. because its page was deleted. The page is forgotten, not remembered
+   * as recently evicted. Does nothing for a frame that is not tracked; throws for a frame that is not evictable.
+   * @param frame_id the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @return the number of evictable frames */
+  virtual auto Size() -> size_t = 0;
+
+  /**
+   * Return up to max_frames evictable frames, in roughly the order Evict() would pick them. Nothing is evicted and no
+   * policy state changes; the page cleaner uses this to look ahead at upcoming victims.
+   * @param max_frames the maximum number of frames to return
+   * @return the next frames to be evicted, first victim first
+   */
+  virtual auto GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> = 0;
+};
+
+/**
+ * Create a replacer.
+ * @param type the replacement policy
+ * @param num_frames the number of frames it manages
+ * @param k the lookback constant of LRU-K; ignored by the other policies
+ */
+auto MakeReplacementPolicy(ReplacerType type, size_t num_frames, size_t k) -> std::unique_ptr<ReplacementPolicy>;
+
+/** @return the name of a replacement policy, e.g. "lru-k" */
+auto ReplacerTypeToString(ReplacerType type) -> std::string;
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tiny_lfu.h
+//
+// Identification: src/include/buffer/tiny_lfu.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TinyLfu estimates how often each page was requested recently, so that a buffer pool can refuse to let a page that is
+ * rarely used push out one that is used often.
+ *
+ * The frequencies live in a count-min sketch: DEPTH rows of small saturating counters, each row indexed by its own hash
+ * of the page id. An estimate is the smallest of a page's counters. Only the smallest counters are incremented
+ * (conservative update), which keeps collisions from inflating the estimates of cold pages. After every sample_size
+ * requests all counters are halved, so that the sketch follows the recent workload rather than the whole history.
+ *
+ * TinyLfu is not thread-safe; the buffer pool only uses it under its latch.
+ */
+class TinyLfu {
+ public:
+  /**
+   * @brief Create a sketch sized for a buffer pool.
+   * @param num_frames number of frames of the buffer pool; the sketch ages after 10 * num_frames requests, but no
+   * sooner than after 10 * MIN_SAMPLE_FRAMES
+   */
+  explicit TinyLfu(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TinyLfu);
+
+  /** @brief Count a request for page_id. */
+  void RecordAccess(page_id_t page_id);
+
+  /** @return the estimated number of recent requests for page_id, at most MAX_COUNT */
+  auto Estimate(page_id_t page_id) const -> uint32_t;
+
+  /**
+   * @brief Decide whether a page that is not resident should replace a victim.
+   * @param candidate the page that would be read in
+   * @param victim the page that would be evicted for it
+   * @return true if the candidate was requested more often than the victim
+   */
+  auto Admit(page_id_t candidate, page_id_t victim) const -> bool { return Estimate(candidate) > Estimate(victim); }
+
+  /** @return the number of requests between two agings */
+  auto GetSampleSize() const -> size_t { return sample_size_; }
+
+ private:
+  static constexpr size_t DEPTH = 4;
+  /** A tiny pool still gets a sample long enough to tell hot pages from cold ones. */
+  static constexpr size_t MIN_SAMPLE_FRAMES = 16;
+  /** Counters saturate here. A page requested this often in a sample period is hot enough. */
+  static constexpr uint8_t MAX_COUNT = 15;
+
+  /** @return the index of page_id's counter in the given row */
+  auto Index(page_id_t page_id, size_t row) const -> size_t;
+
+  /** @brief Halve every counter and the number of requests in the current sample. */
+  void Age();
+
+  /** Counters per row, a power of two. */
+  size_t width_;
+  size_t sample_size_;
+  /** Requests counted since the last aging. */
+  size_t additions_{0};
+  /** DEPTH rows of width_ counters each. */
+  std::vector<uint8_t> counters_;
+};
+
+}  // namespace bustub
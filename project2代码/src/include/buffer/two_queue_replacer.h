@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.h
+//
+// Identification: src/include/buffer/two_queue_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacement_policy.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TwoQueueReplacer implements the full version of the 2Q policy (Johnson and Shasha, VLDB 1994).
+ *
+ * A newly loaded page enters A1in, a FIFO queue; hits on it there change nothing, so a burst of accesses right after a
+ * miss does not make a page look hot. Pages evicted from A1in are remembered in the ghost queue A1out. A page that is
+ * loaded again while it is in A1out has proven to be reused and goes to Am, an LRU list. Evict() takes from A1in while it
+ * holds more than a quarter of the frames, and from Am otherwise; pinned frames are skipped, and if the preferred queue
+ * has no evictable frame the other one is used. A1out remembers as many pages as half the frames.
+ */
+class TwoQueueReplacer : public ReplacementPolicy {
+ public:
+  /**
+   * @brief Create a new TwoQueueReplacer.
+   * @param num_frames the number of frames the replacer manages
+   */
+  explicit TwoQueueReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TwoQueueReplacer);
+
+  ~TwoQueueReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+  using ReplacementPolicy::RecordAccess;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
+
+ private:
+  enum class QueueType { NONE, A1IN, AM };
+
+  struct FrameEntry {
+    /** The queue holding the frame, NONE if the frame is not tracked. */
+    QueueType queue_{QueueType::NONE};
+    bool is_evictable_{false};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** Position of the frame in its queue. */
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** @brief Throw if frame_id is not a frame of this replacer. */
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /** @return the queue a frame's queue type refers to */
+  auto GetQueue(QueueType queue) -> std::list<frame_id_t> & { return queue == QueueType::A1IN ? a1in_ : am_; }
+
+  /** @return true if the next victim should come from A1in */
+  auto PreferA1in() const -> bool { return a1in_.size() > a1in_size_ || am_.empty(); }
+
+  /** @brief Append the evictable frames of a queue to candidates, next victim first. */
+  void CollectEvictable(const std::list<frame_id_t> &queue, size_t max_frames, std::vector<frame_id_t> *candidates);
+
+  /** @brief Stop tracking a frame. Caller should acquire the latch. */
+  void Untrack(frame_id_t frame_id);
+
+  size_t replacer_size_;
+  /** Kin: A1in is preferred for eviction while it holds more frames than this. */
+  size_t a1in_size_;
+  /** Kout: the number of pages A1out remembers. */
+  size_t a1out_size_;
+  size_t num_evictable_{0};
+  std::mutex latch_;
+
+  std::vector<FrameEntry> frames_;
+  /** Frames in the order they were loaded, newest first. */
+  std::list<frame_id_t> a1in_;
+  /** Frames whose page was reloaded from A1out, most recently used first. */
+  std::list<frame_id_t> am_;
+  /** Pages evicted from A1in, most recently evicted first. */
+  std::list<page_id_t> a1out_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> a1out_map_;
+};
+
+}  // namespace bustub
@@ -211,9 +211,18 @@ class BustubInstance {
   auto MakeExecutorContext(Transaction *txn) -> std::unique_ptr<ExecutorContext>;
 
  public:
-  explicit BustubInstance(const std::string &db_file_name);
+  /**
+   * Create a BusTub instance backed by the given database file.
+   * @param db_file_name the database file
+   * @param bpm_instances number of buffer pool shards; more than one selects a ParallelBufferPoolManager
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t bpm_instances = 1);
 
-  BustubInstance();
+  /**
+   * Create an in-memory BusTub instance.
+   * @param bpm_instances number of buffer pool shards; more than one selects a ParallelBufferPoolManager
+   */
+  explicit BustubInstance(size_t bpm_instances = 1);
 
   ~BustubInstance();
 
@@ -269,6 +278,7 @@ class BustubInstance {
  private:
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
+  void CmdDisplayBufferPoolStats(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
   std::unordered_map<std::string, std::string> session_variables_;
@@ -21,6 +21,9 @@ namespace bustub {
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
 extern std::chrono::milliseconds cycle_detection_interval;
 
+/** The buffer pool page cleaner wakes up every PAGE_CLEANER_INTERVAL milliseconds unless the pool is very dirty. */
+extern std::chrono::milliseconds page_cleaner_interval;
+
 /** True if logging should be enabled, false otherwise. */
 extern std::atomic<bool> enable_logging;
 
@@ -28,6 +31,7 @@ extern std::atomic<bool> enable_logging;
 extern std::chrono::duration<int64_t> log_timeout;
 
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
+static constexpr int INVALID_FRAME_ID = -1;                                          // invalid frame id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
@@ -36,6 +40,7 @@ static constexpr int BUFFER_POOL_SIZE = 10;
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int CACHE_LINE_SIZE = 64;  // size of a CPU cache line in byte
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -0,0 +1,40 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.h
+//
+// Identification: src/include/common/util/crc32c.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Crc32c computes the CRC-32C (Castagnoli) checksum, the one used by iSCSI, ext4 and btrfs. On x86-64 CPUs with SSE4.2
+ * it uses the crc32 instruction on three interleaved streams; elsewhere it falls back to a slicing-by-8 table lookup.
+ * The choice is made once, at run time.
+ */
+class Crc32c {
+ public:
+  /** @return the checksum of length bytes of data */
+  static auto Value(const char *data, size_t length) -> uint32_t { return Extend(0, data, length); }
+
+  /** @return the checksum of the bytes whose checksum is crc followed by length bytes of data */
+  static auto Extend(uint32_t crc, const char *data, size_t length) -> uint32_t;
+
+  /** @return Extend() computed with the software fallback, whatever the CPU */
+  static auto ExtendSoftware(uint32_t crc, const char *data, size_t length) -> uint32_t;
+
+  /** @return true if Extend() uses the crc32 instruction */
+  static auto IsHardwareAccelerated() -> bool;
+};
+
+}  // namespace bustub
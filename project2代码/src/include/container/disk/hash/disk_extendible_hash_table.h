@@ -30,6 +30,12 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * The table is latched at three levels. Every operation holds table_latch_ in shared mode and the page latch of the one
+ * bucket its key maps to, in shared mode for GetValue() and exclusively for Insert() and Remove(). The directory page
+ * is only latched for as long as it takes to look up or to repoint an entry. A full bucket whose local depth is below
+ * the global depth is therefore split under its own latch while other buckets stay in use; only doubling the directory
+ * and merging buckets take table_latch_ exclusively.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class DiskExtendibleHashTable {
@@ -110,7 +116,7 @@ class DiskExtendibleHashTable {
    * @param dir_page to use for lookup of global depth
    * @return the directory index
    */
-  auto KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t;
+  auto KeyToDirectoryIndex(KeyType key, const HashTableDirectoryPage *dir_page) -> uint32_t;
 
   /**
    * Get the bucket page_id corresponding to a key.
@@ -119,7 +125,7 @@ class DiskExtendibleHashTable {
    * @param dir_page a pointer to the hash table's directory page
    * @return the bucket page_id corresponding to the input key
    */
-  auto KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t;
+  auto KeyToPageId(KeyType key, const HashTableDirectoryPage *dir_page) -> page_id_t;
 
   /**
    * Fetches the directory page from the buffer pool manager.
@@ -129,15 +135,49 @@ class DiskExtendibleHashTable {
   auto FetchDirectoryPage() -> HashTableDirectoryPage *;
 
   /**
-   * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
+   * Fetches a page of the table from the buffer pool manager and latches it.
    *
-   * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
+   * @tparam Guard ReadPageGuard or WritePageGuard
+   * @param page_id the page_id to fetch
+   * @return a guard over the latched page
    */
-  auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
+  template <class Guard>
+  auto FetchPageLatched(page_id_t page_id) -> Guard;
 
   /**
-   * Performs insertion with an optional bucket splitting.
+   * Creates a new page for the table and latches it exclusively.
+   *
+   * @param[out] page_id the page_id of the new page
+   * @return a guard over the latched page
+   */
+  auto NewPageLatched(page_id_t *page_id) -> WritePageGuard;
+
+  /**
+   * Latches the bucket page that a key maps to. A split may move the key to another bucket between reading the
+   * directory and latching the bucket, so the directory is read again once the latch is held, until both agree.
+   * The caller holds table_latch_.
+   *
+   * @tparam Guard ReadPageGuard or WritePageGuard
+   * @param key the key for lookup
+   * @return a guard over the latched bucket page
+   */
+  template <class Guard>
+  auto LatchBucket(const KeyType &key) -> Guard;
+
+  /**
+   * Splits a full bucket whose local depth is below the global depth. The bucket keeps the pairs whose hash has the
+   * new local depth bit cleared, the others move to a new bucket, and the directory entries of the upper half are
+   * repointed to the new bucket. The caller holds table_latch_ and the latch of the bucket exclusively.
+   *
+   * @param bucket_guard the guard of the bucket page
+   * @param bucket_idx a directory index that maps to the bucket
+   * @param local_depth the local depth of the bucket before the split
+   */
+  void SplitBucket(WritePageGuard *bucket_guard, uint32_t bucket_idx, uint32_t local_depth);
+
+  /**
+   * Performs insertion with an optional bucket splitting. Called by Insert when the bucket is full and as deep as the
+   * directory; holds table_latch_ exclusively to double the directory.
    *
    * @param transaction a pointer to the current transaction
    * @param key the key to insert
@@ -151,10 +191,13 @@ class DiskExtendibleHashTable {
    * if Remove makes a bucket empty.
    *
    * There are three conditions under which we skip the merge:
-   * 1. The bucket is no longer empty.
+   * 1. Neither the bucket nor its split image is empty.
    * 2. The bucket has local depth 0.
    * 3. The bucket's local depth doesn't match its split image's local depth.
    *
+   * Merges cascade for as long as the merged bucket or its new split image is empty, and the directory is halved for
+   * as long as every local depth is below the global depth.
+   *
    * @param transaction a pointer to the current transaction
    * @param key the key that was removed
    * @param value the value that was removed
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
@@ -21,15 +24,29 @@
 #include "container/hash/hash_function.h"
 #include "storage/page/hash_table_block_page.h"
 #include "storage/page/hash_table_header_page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
-#define HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
+#define LINEAR_PROBE_HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
 
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * The slots of the table are spread over block pages, whose page ids are kept in slot order on a header page. A key is
+ * looked for from the slot its hash points to, onwards and around the end, up to the first slot that was never
+ * occupied. Removes leave tombstones, which keep those probe sequences intact and are reused by later inserts.
+ *
+ * Once more than three quarters of the slots are taken, by pairs or tombstones, the table is resized to twice the
+ * number of pairs it holds. A resize only allocates a new header and new blocks. The old blocks stay in place and are
+ * migrated a few at a time by the inserts and removes that follow, while lookups probe both the old and the new
+ * blocks, so no operation ever waits for more than a few blocks to be rehashed.
+ *
+ * Every operation holds table_latch_ in shared mode and the page latch of one block at a time. Starting a resize and
+ * migrating blocks take table_latch_ exclusively. Inserts of the same key are serialized by a striped latch, so that
+ * two threads cannot both find a pair missing and both insert it.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable {
@@ -39,7 +56,8 @@ class LinearProbeHashTable {
    *
    * @param buffer_pool_manager buffer pool manager to be used
    * @param comparator comparator for keys
-   * @param num_buckets initial number of buckets contained by this hash table
+   * @param num_buckets initial number of buckets contained by this hash table, rounded up to whole blocks; the table
+   * is never resized below it
    * @param hash_fn the hash function
    */
   explicit LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
@@ -50,7 +68,7 @@ class LinearProbeHashTable {
    * @param transaction the current transaction
    * @param key the key to create
    * @param value the value to be associated with the key
-   * @return true if insert succeeded, false otherwise
+   * @return true if insert succeeded, false if the pair is in the table already or the table is full
    */
   auto Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool;
 
@@ -73,32 +91,98 @@ class LinearProbeHashTable {
   auto GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Resizes the table to at least twice the initial size provided. A resize that is still migrating is completed
+   * first; the new one is migrated by the operations that follow.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
 
   /**
    * Gets the size of the hash table
-   * @return current size of the hash table
+   * @return current size of the hash table, i.e. the number of buckets of its current blocks
    */
   auto GetSize() -> size_t;
 
  private:
-  auto GetHeaderPage() -> HashTableHeaderPage *;
-  auto GetBlockPage(page_id_t block_page_id) -> HASH_TABLE_BLOCK_TYPE *;
-  void ResizeInsert(HashTableHeaderPage *header_page, const KeyType &key, const ValueType &value);
+  /** The number of old blocks that every insert and remove migrates while a resize is in progress. */
+  static constexpr size_t MIGRATE_BLOCKS_PER_OP = 2;
+  /** The number of latches that serialize inserts of the same key. */
+  static constexpr size_t NUM_INSERT_LATCHES = 64;
+
+  template <class Guard>
+  auto FetchPageLatched(page_id_t page_id) -> Guard;
+  auto NewPageLatched(page_id_t *page_id) -> WritePageGuard;
+
+  /**
+   * Walks the probe sequence of the key through the blocks of the given header: from the slot the key hashes to, on and
+   * around the end, up to and including the first slot that was never occupied. Each block is latched as Guard says
+   * while its slots are visited, one block at a time.
+   *
+   * @param visit called as visit(block, block_index, bucket_ind) on every slot of the walk; returning true stops it
+   * @return true if visit stopped the walk
+   */
+  template <class Guard, class Visitor>
+  auto Probe(const HashTableHeaderPage *header_page, const KeyType &key, Visitor &&visit) -> bool;
+
+  /**
+   * Inserts the pair into the first slot of its probe sequence that holds no pair, unless check_duplicate is set and
+   * the pair turns up on the way.
+   *
+   * @return true if inserted, false if the pair is there already or every slot holds a pair
+   */
+  auto InsertInto(const HashTableHeaderPage *header_page, const KeyType &key, const ValueType &value,
+                  bool check_duplicate) -> bool;
+
+  /** Inserts a pair of an old block into the current blocks, which have room for every pair of the old ones. */
+  void ResizeInsert(const HashTableHeaderPage *header_page, const KeyType &key, const ValueType &value);
+
   void DeleteBlockPages(HashTableHeaderPage *old_header_page);
   void CreateNewBlockPages(HashTableHeaderPage *header_page, size_t num_blocks);
-  auto GetValueLatchFree(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
+
+  /** @return the number of blocks for the given number of buckets */
+  auto NumBlocksFor(size_t num_buckets) const -> size_t;
+
+  /**
+   * Moves the pairs of up to max_blocks old blocks to the current ones, and drops the old blocks and their header once
+   * all of them are migrated. The caller holds table_latch_ exclusively.
+   */
+  void MigrateBlocks(size_t max_blocks);
+
+  /**
+   * Replaces the current blocks with blocks for at least twice the given number of buckets, and makes the current
+   * blocks the old ones. The caller holds table_latch_ exclusively, and no migration is in progress.
+   */
+  void StartResize(size_t initial_size);
+
+  /**
+   * Resizes a table that got too full, unless another thread did already.
+   *
+   * @param size the size of the table that got too full
+   * @return false if the table cannot get any bigger and has too few tombstones to be worth rebuilding
+   */
+  auto Grow(size_t size) -> bool;
 
   // member variable
   page_id_t header_page_id_;
+  /** The header of the old blocks while they are migrated to the blocks of header_page_id_, or INVALID_PAGE_ID. */
+  page_id_t old_header_page_id_{INVALID_PAGE_ID};
+  /** The first old block that is still to be migrated. */
+  size_t next_migrated_block_{0};
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  /** The smallest number of buckets the table is resized to. */
+  size_t min_num_buckets_;
+
+  /** The number of current slots that hold a pair or a tombstone. */
+  std::atomic<size_t> num_occupied_{0};
+  /** The number of pairs in the current and the old blocks. */
+  std::atomic<size_t> num_pairs_{0};
+  /** The number of pairs in the old blocks; they count as taking up current slots already. */
+  std::atomic<size_t> num_old_pairs_{0};
 
   // Readers includes inserts and removes, writer is only resize
   ReaderWriterLatch table_latch_;
+  std::array<std::mutex, NUM_INSERT_LATCHES> insert_latches_;
 
   // Hash function
   HashFunction<KeyType> hash_fn_;
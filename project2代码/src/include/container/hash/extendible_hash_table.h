@@ -17,18 +17,36 @@
 
 #pragma once
 
-#include <list>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <utility>
 #include <vector>
 
+#include "common/config.h"
+#include "common/macros.h"
 #include "container/hash/hash_table.h"
 
 namespace bustub {
 
 /**
  * ExtendibleHashTable implements a hash table using the extendible hashing algorithm.
+ *
+ * The table is latched at two levels. Every operation holds the directory latch in shared mode and the latch of the
+ * one bucket its key maps to, in shared mode for Find() and exclusively for Insert() and Remove(). Lookups therefore
+ * never block each other, and writers only block the operations on their own bucket. A bucket that has to split while
+ * its local depth is below the global depth is split in place under its own latch: its upper half moves to a new
+ * bucket, and the directory slots of that half are repointed one atomic store at a time. Only doubling the directory
+ * takes the directory latch exclusively.
+ *
+ * The table also shrinks. A bucket that a removal leaves at most half full together with its buddy is merged into it,
+ * and the directory is halved once no bucket is within one level of the global depth. Both take the directory latch
+ * exclusively. The gaps between the thresholds for growing and for shrinking keep a table that hovers around one size
+ * from splitting and merging, or doubling and halving, over and over.
+ *
  * @tparam K key type
  * @tparam V value type
  */
@@ -44,6 +62,11 @@ class ExtendibleHashTable : public HashTable<K, V> {
    */
   explicit ExtendibleHashTable(size_t bucket_size);
 
+  DISALLOW_COPY_AND_MOVE(ExtendibleHashTable);
+
+  /** @brief Destroy the table and every bucket in it. */
+  ~ExtendibleHashTable() override;
+
   /**
    * @brief Get the global depth of the directory.
    * @return The global depth of the directory.
@@ -63,13 +86,20 @@ class ExtendibleHashTable : public HashTable<K, V> {
    */
   auto GetNumBuckets() const -> int;
 
+  /**
+   * @brief Get the memory held by the table: the table itself, the directory and every bucket, without the overhead of
+   * the allocator.
+   * @return The memory footprint of the table in bytes.
+   */
+  auto GetMemoryUsage() const -> size_t;
+
   /**
    *
    * TODO(P1): Add implementation
    *
    * @brief Find the value associated with the given key.
    *
-   * Use IndexOf(key) to find the directory index the key hashes to.
+   * Use IndexOf(hash) to find the directory index the key hashes to.
    *
    * @param key The key to be searched.
    * @param[out] value The value associated with the key.
@@ -99,7 +129,8 @@ class ExtendibleHashTable : public HashTable<K, V> {
    * TODO(P1): Add implementation
    *
    * @brief Given the key, remove the corresponding key-value pair in the hash table.
-   * Shrink & Combination is not required for this project
+   * If the bucket and its buddy are at most half full together, merge them, and halve the directory if it has become
+   * two levels deeper than any bucket.
    * @param key The key to be deleted.
    * @return True if the key exists, false otherwise.
    */
@@ -107,95 +138,180 @@ class ExtendibleHashTable : public HashTable<K, V> {
 
   /**
    * Bucket class for each hash table bucket that the directory points to.
+   *
+   * The kv pairs of a bucket are packed at the front of two flat arrays, one of keys and one of values, next to an
+   * array with an 8-bit fingerprint of the hash of every key. A lookup compares the fingerprints first, sixteen at a
+   * time where SSE2 is available, and only compares the keys whose fingerprint matches. The three arrays share one
+   * block that starts on a cache line, so a small bucket fits in a single line, and no operation allocates except for
+   * creating a bucket.
    */
   class Bucket {
    public:
     explicit Bucket(size_t size, int depth = 0);
 
+    DISALLOW_COPY_AND_MOVE(Bucket);
+
+    ~Bucket();
+
     /** @brief Check if a bucket is full. */
-    inline auto IsFull() const -> bool { return list_.size() == size_; }
+    inline auto IsFull() const -> bool { return count_ == size_; }
 
     /** @brief Get the local depth of the bucket. */
     inline auto GetDepth() const -> int { return depth_; }
 
-    /** @brief Increment the local depth of a bucket. */
-    inline void IncrementDepth() { depth_++; }
+    /** @brief Get the number of kv pairs in the bucket. */
+    inline auto GetSize() const -> size_t { return count_; }
+
+    /** @brief Get the memory held by a bucket of the given size, including its arrays. */
+    static auto GetMemoryUsage(size_t size) -> size_t;
 
-    inline auto GetItems() -> std::list<std::pair<K, V>> & { return list_; }
+    /** @brief Get the latch that guards the items and the local depth of the bucket. */
+    inline auto GetLatch() const -> std::shared_mutex & { return latch_; }
 
     /**
-     *
-     * TODO(P1): Add implementation
-     *
      * @brief Find the value associated with the given key in the bucket.
      * @param key The key to be searched.
+     * @param hash The hash of the key.
      * @param[out] value The value associated with the key.
      * @return True if the key is found, false otherwise.
      */
-    auto Find(const K &key, V &value) -> bool;
+    auto Find(const K &key, size_t hash, V &value) const -> bool;
 
     /**
-     *
-     * TODO(P1): Add implementation
-     *
-     * @brief Given the key, remove the corresponding key-value pair in the bucket.
+     * @brief Given the key, remove the corresponding key-value pair in the bucket. The last pair takes its place.
      * @param key The key to be deleted.
+     * @param hash The hash of the key.
      * @return True if the key exists, false otherwise.
      */
-    auto Remove(const K &key) -> bool;
+    auto Remove(const K &key, size_t hash) -> bool;
 
     /**
-     *
-     * TODO(P1): Add implementation
-     *
      * @brief Insert the given key-value pair into the bucket.
      *      1. If a key already exists, the value should be updated.
      *      2. If the bucket is full, do nothing and return false.
      * @param key The key to be inserted.
+     * @param hash The hash of the key.
      * @param value The value to be inserted.
-     * @return True if the key-value pair is inserted, false otherwise.
+     * @return True if the key-value pair is inserted or updated, false otherwise.
+     */
+    auto Insert(const K &key, size_t hash, const V &value) -> bool;
+
+    /**
+     * @brief Increment the local depth of the bucket and move the kv pairs whose hash has the new bit set to the given
+     * empty bucket, which already has the new local depth. The remaining pairs are compacted in place.
+     * @param image The bucket that takes over the upper half.
+     */
+    void Split(Bucket *image);
+
+    /**
+     * @brief Move every kv pair of the given buddy, which has the same local depth, into this bucket and decrement the
+     * local depth. The pairs of both must fit into this bucket.
+     * @param buddy The bucket that differs from this one in the highest bit of the local depth only.
      */
-    auto Insert(const K &key, const V &value) -> bool;
+    void Merge(Bucket *buddy);
 
    private:
-    // TODO(student): You may add additional private members and helper functions
+    /** The number of fingerprints compared at once. */
+    static constexpr size_t GROUP_SIZE = 16;
+
+    /**
+     * @brief Lay out the arrays of a bucket of the given size in one block.
+     * @param size The size of the bucket.
+     * @param[out] keys_offset The offset of the keys in the block; the fingerprints start at 0.
+     * @param[out] values_offset The offset of the values in the block.
+     * @return The size of the block.
+     */
+    static auto Layout(size_t size, size_t *keys_offset, size_t *values_offset) -> size_t;
+
+    /** @brief The fingerprint of a hash. Its bits are mixed, as the low bits of the hash are the same in the bucket. */
+    static auto Fingerprint(size_t hash) -> uint8_t;
+
+    /** @return The slot of the given key, or count_ if it is not in the bucket. */
+    auto Probe(const K &key, uint8_t fingerprint) const -> size_t;
+
+    /** @brief Move the last kv pair into the given slot and forget the last slot. */
+    void Erase(size_t slot);
+
     size_t size_;
+    size_t count_{0};
     int depth_;
-    std::list<std::pair<K, V>> list_;
+    /** The block holding the three arrays below. */
+    void *data_;
+    /** Sized to whole groups, so that the last group can be loaded at once. Slots from count_ on are garbage. */
+    uint8_t *fingerprints_;
+    K *keys_;
+    V *values_;
+    mutable std::shared_mutex latch_;
   };
 
  private:
   // TODO(student): You may add additional private members and helper functions and remove the ones
   // you don't need.
 
-  int global_depth_;    // The global depth of the directory
-  size_t bucket_size_;  // The size of a bucket
-  int num_buckets_;     // The number of buckets in the hash table
-  mutable std::mutex latch_;
-  std::vector<std::shared_ptr<Bucket>> dir_;  // The directory of the hash table
+  /** The deepest a directory can get: one level per bit of a hash. */
+  static constexpr int MAX_DEPTH = 8 * sizeof(size_t);
 
-  // The following functions are completely optional, you can delete them if you have your own ideas.
+  int global_depth_;                // The global depth of the directory
+  size_t bucket_size_;              // The size of a bucket
+  std::atomic<int> num_buckets_;    // The number of buckets in the hash table
+  /** num_buckets_at_depth_[d] is the number of buckets of local depth d. */
+  std::array<std::atomic<int>, MAX_DEPTH + 1> num_buckets_at_depth_{};
+  mutable std::shared_mutex dir_latch_;
+  /**
+   * The directory of the hash table. Its size only changes under an exclusive dir_latch_, but a slot may be repointed
+   * under a shared dir_latch_ by the thread that splits the bucket it points to. The table owns every bucket.
+   */
+  std::vector<std::atomic<Bucket *>> dir_;
 
   /**
-   * @brief Redistribute the kv pairs in a full bucket.
+   * @brief Split a full bucket whose local depth is below the global depth. The bucket keeps the kv pairs of its lower
+   * half, the ones of its upper half move to a new bucket, and the directory slots of the upper half are repointed.
+   * The caller holds dir_latch_ in shared mode and the latch of the bucket exclusively.
    * @param bucket The bucket to be redistributed.
+   * @param hash The hash of a key that maps to the bucket.
    */
-  auto RedistributeBucket(std::shared_ptr<Bucket> bucket) -> void;
+  auto RedistributeBucket(Bucket *bucket, size_t hash) -> void;
 
-  /*****************************************************************
-   * Must acquire latch_ first before calling the below functions. *
-   *****************************************************************/
+  /**
+   * @brief Check whether the bucket and its buddy are at most half full together, so that the directory latch is only
+   * taken exclusively for merges that will happen. The caller holds dir_latch_ in shared mode and the latch of the
+   * bucket exclusively; the buddy is skipped rather than waited for if it is latched exclusively.
+   * @param bucket The bucket a kv pair was just removed from.
+   * @param hash The hash of a key that maps to the bucket.
+   * @return True if the bucket can be merged with its buddy.
+   */
+  auto CanMerge(Bucket *bucket, size_t hash) const -> bool;
+
+  /**
+   * @brief Merge the bucket that the given hash maps to with its buddy for as long as the two are at most half full
+   * together, then halve the directory for as long as no bucket is within one level of the global depth. The caller
+   * holds dir_latch_ exclusively.
+   * @param hash The hash of a key that maps to the bucket.
+   */
+  void MergeBuckets(size_t hash);
+
+  /*********************************************************************
+   * Must acquire dir_latch_ first before calling the below functions. *
+   *********************************************************************/
+
+  /**
+   * @brief Latch the bucket that the given key maps to. A split may move the key to another bucket between reading the
+   * directory and acquiring the latch, so the directory is read again once the latch is held, until both agree.
+   * @param hash The hash of the key.
+   * @param exclusive Whether to acquire the bucket latch in exclusive or in shared mode.
+   * @return The latched bucket; the caller releases its latch.
+   */
+  auto LatchBucket(size_t hash, bool exclusive) const -> Bucket *;
 
   /**
-   * @brief For the given key, return the entry index in the directory where the key hashes to.
-   * @param key The key to be hashed.
+   * @brief For the given hash of a key, return the entry index in the directory where the key hashes to.
+   * @param hash The hash of the key.
    * @return The entry index in the directory.
    */
-  auto IndexOf(const K &key) -> size_t;
+  auto IndexOf(size_t hash) const -> size_t;
 
   auto GetGlobalDepthInternal() const -> int;
   auto GetLocalDepthInternal(int dir_index) const -> int;
-  auto GetNumBucketsInternal() const -> int;
 };
 
 }  // namespace bustub
\ No newline at end of file
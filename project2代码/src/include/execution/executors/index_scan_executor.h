@@ -23,7 +23,8 @@
 namespace bustub {
 
 /**
- * IndexScanExecutor executes an index scan over a table.
+ * IndexScanExecutor executes an index scan over a table: either a point lookup of the plan's key in any kind of index,
+ * or a scan of a B+ tree index in key order.
  */
 
 class IndexScanExecutor : public AbstractExecutor {
@@ -44,5 +45,13 @@ class IndexScanExecutor : public AbstractExecutor {
  private:
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  /** The index to scan. */
+  const IndexInfo *index_info_{nullptr};
+  /** The table the index points into. */
+  const TableInfo *table_info_{nullptr};
+  /** The RIDs the index returned, in the order of the scan. */
+  std::vector<RID> rids_;
+  /** Position of the next RID to emit. */
+  size_t cursor_{0};
 };
 }  // namespace bustub
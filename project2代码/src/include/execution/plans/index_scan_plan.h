@@ -21,17 +21,19 @@
 
 namespace bustub {
 /**
- * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
+ * IndexScanPlanNode identifies a table that should be scanned through an index, either in key order or for the tuples
+ * with one key.
  */
 class IndexScanPlanNode : public AbstractPlanNode {
  public:
   /**
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
-   * @param table_oid the identifier of table to be scanned
+   * @param index_oid the identifier of the index to scan
+   * @param pred_key the key to look up, or nullptr to scan the whole index in key order
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid)
-      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid) {}
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, AbstractExpressionRef pred_key = nullptr)
+      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid), pred_key_(std::move(pred_key)) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
@@ -43,11 +45,17 @@ class IndexScanPlanNode : public AbstractPlanNode {
   /** The table whose tuples should be scanned. */
   index_oid_t index_oid_;
 
+  /** For a point lookup, a constant expression that evaluates to the key; nullptr for a scan in key order. */
+  AbstractExpressionRef pred_key_;
+
   // Add anything you want here for index lookup
 
  protected:
   auto PlanNodeToString() const -> std::string override {
-    return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    if (pred_key_ == nullptr) {
+      return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    }
+    return fmt::format("IndexScan {{ index_oid={}, pred_key={} }}", index_oid_, pred_key_);
   }
 };
 
@@ -85,6 +85,13 @@ class Optimizer {
    */
   auto OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief optimize a filter over a seq scan as an index point lookup if one of the conjuncts of the filter is
+   * `<column> = <constant>` and there's an index on that column. A hash index is preferred over a B+ tree. The other
+   * conjuncts stay in a filter above the index scan.
+   */
+  auto OptimizeSeqScanAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /** @brief check if the index can be matched */
   auto MatchIndex(const std::string &table_name, uint32_t index_key_idx)
       -> std::optional<std::tuple<index_oid_t, std::string>>;
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.h
+//
+// Identification: src/include/storage/disk/async_disk_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/** The default number of page I/Os an AsyncDiskManager keeps in flight. */
+static constexpr size_t ASYNC_IO_QUEUE_DEPTH = 64;
+
+/** How an AsyncDiskManager performs its I/O. */
+enum class AsyncIoEngine { IO_URING, THREAD_POOL };
+
+/**
+ * AsyncDiskManager performs the requests given to Schedule() in the background, so that a thread can keep many page
+ * I/Os in flight and wait for them all at once.
+ *
+ * It submits every batch to an io_uring with a single system call when the kernel supports it, and reaps completions on
+ * a dedicated thread. Otherwise a pool of worker threads performs the requests with pread() and pwrite(), one request
+ * per worker at a time. Either way at most queue_depth requests are in flight; Schedule() blocks until the requests it
+ * is given fit. The synchronous ReadPage() and WritePage() bypass the queue.
+ *
+ * The caller owns the order of its requests: two requests for the same page must not be in flight at the same time.
+ * All requests must have completed before ShutDown().
+ */
+class AsyncDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new asynchronous disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param queue_depth the maximum number of requests in flight
+   * @param use_io_uring whether to try io_uring before falling back to the thread pool
+   */
+  explicit AsyncDiskManager(const std::string &db_file, size_t queue_depth = ASYNC_IO_QUEUE_DEPTH,
+                            bool use_io_uring = true);
+
+  /** Waits for the requests in flight and stops the background threads. */
+  ~AsyncDiskManager() override;
+
+  void Schedule(std::vector<DiskRequest> *requests) override;
+
+  /** @return the engine that performs the I/O */
+  auto GetEngine() const -> AsyncIoEngine;
+
+  /** @return the maximum number of requests in flight */
+  auto GetQueueDepth() const -> size_t { return queue_depth_; }
+
+ private:
+  /** A minimal io_uring on top of the raw system calls, defined in the source file. */
+  class IoUring;
+
+  /**
+   * @brief Submit the requests to the ring. If the kernel refuses them, the requests it did not take are done
+   * synchronously.
+   */
+  void ScheduleIoUring(std::vector<DiskRequest> *requests);
+
+  /** @brief Main loop of the thread that reaps the completions of the ring. */
+  void RunCompletions();
+
+  /** @brief Main loop of a worker thread of the pool. */
+  void RunWorker();
+
+  /**
+   * @brief Finish a request of the ring whose I/O transferred the given number of bytes, or failed with -errno, verify
+   * the page if it was read, and set its promise. A short transfer, which happens at the end of the file, is completed
+   * synchronously, and so is a request that transferred nothing.
+   */
+  void Complete(DiskRequest *request, int result);
+
+  const size_t queue_depth_;
+  std::unique_ptr<IoUring> ring_;
+
+  /** Protects the submission side of the ring, the request queue of the pool and the in-flight count. */
+  std::mutex latch_;
+  /** Signaled when requests complete, so that Schedule() can submit more. */
+  std::condition_variable slot_cv_;
+  /** Signaled when requests are queued for the pool. */
+  std::condition_variable queue_cv_;
+  size_t num_in_flight_{0};
+  bool stopping_{false};
+  std::thread completion_thread_;
+  /** Requests waiting for a worker of the pool. */
+  std::deque<DiskRequest> queue_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace bustub
@@ -13,51 +13,154 @@
 #pragma once
 
 #include <atomic>
+#include <bitset>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
 
 #include "common/config.h"
+#include "common/macros.h"
 
 namespace bustub {
 
+/**
+ * DiskRequest is a page read or write handed to DiskManager::Schedule(). Its promise is set to true once the page has
+ * been read into or written from data_, and to false if the I/O failed. An AsyncDiskManager also sets it to false when
+ * a page read fails verification.
+ */
+struct DiskRequest {
+  /** True for a write, false for a read. */
+  bool is_write_;
+  /** The page to write, or the buffer to read into. It must stay valid until the request completes. */
+  char *data_;
+  page_id_t page_id_;
+  std::promise<bool> callback_;
+};
+
+/** How DiskManager verifies the checksums of the pages it reads. */
+enum class ChecksumMode {
+  /** Checksums are neither taken nor verified. Entering the mode drops the checksums taken so far, which the pages
+   * written while it lasts would no longer match. */
+  OFF,
+  /** Every page read is verified. */
+  VERIFY_ON_READ,
+  /** Reads are not verified; a scrubber thread verifies the allocated pages in the background instead. */
+  BACKGROUND_SCRUB,
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional pread() and pwrite() calls on one file descriptor. There is no shared
+ * file cursor and no latch around them, so the buffer pool threads read and write different pages concurrently. A
+ * written page is handed to the operating system but is not durable until the next SyncDatabase().
+ *
+ * File offsets are 64 bits wide, so the file can hold every page id. A write past the end of the file extends it with
+ * fallocate() by a whole chunk, as large as the file but between DB_GROWTH_MIN_BYTES and DB_GROWTH_MAX_BYTES, rather
+ * than a page at a time. A write far past the end leaves a hole before its page. ShutDown() trims the unused tail of the
+ * last chunk.
+ *
+ * The file is laid out in extents of PAGES_PER_EXTENT pages. Each extent starts with a header of EXTENT_HEADER_PAGES
+ * pages, so the page with id p lives at PageOffset(p) rather than at p * BUSTUB_PAGE_SIZE. The first is a control page,
+ * described below; that of extent 0 also starts with FILE_MAGIC and FORMAT_VERSION, which the constructor checks. The
+ * second is a space map, a bitmap of which of its pages are allocated. The space maps are read
+ * when the file is opened and kept in memory along with the free page ids below the high-water mark, in one list per
+ * buffer pool instance; AllocatePage() hands out the lowest free id of the instance before growing the file.
+ *
+ * The rest of the header holds the CRC-32C checksum of every page of the extent, taken by WritePage(). Depending on the
+ * ChecksumMode, reads or a background scrubber verify it, so that a page corrupted on disk is not read back unnoticed.
+ * A page that fails verification is logged and counted, and is reported by GetCorruptPages() until it is written again.
+ * Its data is still returned, but an AsyncDiskManager read of it completes with false.
+ *
+ * The space maps and the checksums that changed are written by SyncDatabase(), so they are as durable as the pages
+ * written before the sync. A page written since may reach the disk before or after its checksum does, or be torn by a
+ * crash, so its checksum on disk tells nothing after a crash. The control page says whether that can be the case: the
+ * first write after a sync that changes a checksum of the extent marks the extent unsynced, and syncs that mark before
+ * the page is written. Later writes to the extent find it marked and write right away. SyncDatabase() clears the mark of
+ * the extents whose checksums it made durable and that have no write in flight. When the file is opened, the checksums
+ * of the extents still marked are dropped: their pages are not verified until they are written again, rather than
+ * reported corrupt for a write the crash cut short.
  */
 class DiskManager {
  public:
   /**
-   * Creates a new disk manager that writes to the specified database file.
+   * Creates a new disk manager that writes to the specified database file. A new file is stamped with the file format;
+   * an existing one must have the same format, or else it is rejected rather than read with the wrong layout.
    * @param db_file the file name of the database file to write to
+   * @throws Exception if the file cannot be opened, or it is not a database file of this format
    */
   explicit DiskManager(const std::string &db_file);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  DISALLOW_COPY_AND_MOVE(DiskManager);
+
+  /** Stops the scrubber, and syncs and closes the database file if ShutDown() has not. */
+  virtual ~DiskManager();
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager: trim the database file to its last written page, sync it and close all the file
+   * resources.
    */
   void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Write a page to the database file. The page and its checksum are durable after the next SyncDatabase(). The data
+   * must not change until the call returns.
    * @param page_id id of the page
    * @param page_data raw page data
    */
   virtual void WritePage(page_id_t page_id, const char *page_data);
 
   /**
-   * Read a page from the database file.
+   * Read a page from the database file, and verify it with VERIFY_ON_READ. The part of a page beyond the end of the file
+   * reads as zeros.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Make every page written so far durable.
+   */
+  virtual void SyncDatabase();
+
+  /**
+   * Perform a batch of page reads and writes. Here they are done one after the other before returning; an
+   * AsyncDiskManager submits them together and returns right away. The requests of a batch may complete in any order,
+   * so a batch must not contain two requests for the same page.
+   * @param requests the requests, which are moved from
+   */
+  virtual void Schedule(std::vector<DiskRequest> *requests);
+
+  /**
+   * Schedule a read of a single page.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the returned future is ready
+   * @return a future that becomes true once the page is read, false if the read failed
+   */
+  auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<bool>;
+
+  /**
+   * Schedule a write of a single page.
+   * @param page_id id of the page
+   * @param page_data raw page data, which must stay valid and unchanged until the returned future is ready
+   * @return a future that becomes true once the page is written, false if the write failed
+   */
+  auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<bool>;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -72,7 +175,7 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  auto ReadLog(char *log_data, int size, int offset) -> bool;
+  auto ReadLog(char *log_data, int size, int64_t offset) -> bool;
 
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
@@ -83,6 +186,79 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of syncs of the database file */
+  auto GetNumSyncs() const -> int;
+
+  /** @return the number of syncs that marked extents unsynced before a page write, which are not counted as syncs */
+  auto GetNumChecksumBarriers() const -> int { return num_checksum_barriers_.load(std::memory_order_relaxed); }
+
+  /**
+   * Allocate a page: the lowest free page id congruent to instance_index modulo num_instances, or else the first such id
+   * at or past the high-water mark. The ids skipped on the way become free pages. Each instance takes its free ids from
+   * a list of its own, so instances only contend for the space map bit they flip and when they grow the file.
+   * @param num_instances number of buffer pool instances that share the file
+   * @param instance_index index of the instance that allocates the page
+   * @return the id of the allocated page
+   */
+  auto AllocatePage(uint32_t num_instances = 1, uint32_t instance_index = 0) -> page_id_t;
+
+  /**
+   * Return a page to the free space so that it is reused. Deallocating a page that is not allocated does nothing.
+   * @param page_id id of the page, which must no longer be read or written
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return true if the page is allocated */
+  auto IsAllocated(page_id_t page_id) -> bool;
+
+  /** @return one past the highest allocated page id */
+  auto GetHighWaterMark() -> page_id_t;
+
+  /** @return the number of free pages below the high-water mark */
+  auto GetNumFreePages() -> size_t;
+
+  /**
+   * Lower the high-water mark below the trailing free pages and truncate the database file after the last allocated
+   * page. It runs concurrently with reads and writes of allocated pages.
+   * @return the number of bytes the file shrank by
+   */
+  auto ShrinkFile() -> int64_t;
+
+  /**
+   * Choose how page checksums are verified. The scrubber thread is started or stopped as needed.
+   * @param mode the new mode
+   */
+  void SetChecksumMode(ChecksumMode mode);
+
+  /** @return how page checksums are verified */
+  auto GetChecksumMode() const -> ChecksumMode { return checksum_mode_.load(std::memory_order_relaxed); }
+
+  /**
+   * Read a page from the database file and verify its checksum, whatever the ChecksumMode.
+   * @param page_id id of the page
+   * @return false if the page failed verification
+   */
+  auto VerifyPage(page_id_t page_id) -> bool;
+
+  /** @return the pages that failed verification and were not written since, in order */
+  auto GetCorruptPages() -> std::vector<page_id_t>;
+
+  /** @return the number of times a page failed verification */
+  auto GetNumChecksumFailures() const -> int { return num_checksum_failures_.load(std::memory_order_relaxed); }
+
+  /** @return the number of pages verified by the scrubber */
+  auto GetNumPagesScrubbed() const -> size_t { return pages_scrubbed_.load(std::memory_order_relaxed); }
+
+  /** @return the checksum of a page, which is never 0: 0 stands for a page without a checksum */
+  static auto PageChecksum(const char *page_data) -> uint32_t;
+
+  /** @return the offset of a page in the database file */
+  static auto PageOffset(page_id_t page_id) -> int64_t {
+    const int64_t extent = page_id / PAGES_PER_EXTENT;
+    return (extent * (PAGES_PER_EXTENT + EXTENT_HEADER_PAGES) + EXTENT_HEADER_PAGES + page_id % PAGES_PER_EXTENT) *
+           BUSTUB_PAGE_SIZE;
+  }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -93,19 +269,219 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
-  auto GetFileSize(const std::string &file_name) -> int;
+  /** Number of pages tracked by the bitmap of one space map page. */
+  static constexpr int64_t PAGES_PER_EXTENT = BUSTUB_PAGE_SIZE * 8;
+  /** Number of pages that hold the checksums of the pages of an extent. */
+  static constexpr int64_t CHECKSUM_PAGES_PER_EXTENT = PAGES_PER_EXTENT * sizeof(uint32_t) / BUSTUB_PAGE_SIZE;
+  /** Number of pages in front of the pages of an extent: its control page, its space map and its checksums. */
+  static constexpr int64_t EXTENT_HEADER_PAGES = 2 + CHECKSUM_PAGES_PER_EXTENT;
+  /** The header pages of an extent, in order. */
+  static constexpr size_t CONTROL_PAGE = 0;
+  static constexpr size_t SPACE_MAP_PAGE = 1;
+  static constexpr size_t FIRST_CHECKSUM_PAGE = 2;
+
+  /** What the control page of extent 0 starts with, so that the file is not taken for anything else. */
+  static constexpr char FILE_MAGIC[8] = {'B', 'U', 'S', 'T', 'U', 'B', 'D', 'B'};
+  /**
+   * The version of the file layout. Version 1 put page p at p * BUSTUB_PAGE_SIZE, version 2 added the space maps and
+   * the checksums in front of every extent, and version 3 the control page. Only versions from 3 on are marked.
+   */
+  static constexpr uint32_t FORMAT_VERSION = 3;
+
+  /** The scrubber verifies this many pages, then sleeps for SCRUB_INTERVAL. */
+  static constexpr size_t SCRUB_BATCH_SIZE = 64;
+  static constexpr std::chrono::milliseconds SCRUB_INTERVAL{10};
+
+  /** The start of the control page of an extent. */
+  struct ExtentControl {
+    /** FILE_MAGIC in extent 0, zero in the others. */
+    char magic_[sizeof(FILE_MAGIC)];
+    /** FORMAT_VERSION in extent 0, zero in the others. */
+    uint32_t format_version_;
+    /** Nonzero while pages of the extent may have been written after their checksums were last synced. */
+    uint32_t unsynced_;
+  };
+
+  /** The header of an extent, as kept in memory. */
+  struct ExtentHeader {
+    ExtentHeader()
+        : control_(std::make_unique<char[]>(BUSTUB_PAGE_SIZE)),
+          space_map_(std::make_unique<char[]>(BUSTUB_PAGE_SIZE)),
+          checksums_(std::make_unique<uint32_t[]>(PAGES_PER_EXTENT)) {}
+
+    /** @return the data of header page i: the control page, the space map, then the checksums */
+    auto Page(size_t i) -> char * {
+      if (i == CONTROL_PAGE) {
+        return control_.get();
+      }
+      if (i == SPACE_MAP_PAGE) {
+        return space_map_.get();
+      }
+      return reinterpret_cast<char *>(&checksums_[(i - FIRST_CHECKSUM_PAGE) * BUSTUB_PAGE_SIZE / sizeof(uint32_t)]);
+    }
+
+    auto Control() -> ExtentControl * { return reinterpret_cast<ExtentControl *>(control_.get()); }
+
+    std::unique_ptr<char[]> control_;
+    /** Bitmap of the allocated pages of the extent. */
+    std::unique_ptr<char[]> space_map_;
+    /** The checksum of every page of the extent, 0 if it was never written. */
+    std::unique_ptr<uint32_t[]> checksums_;
+    /** The header pages that changed since they were last written. */
+    std::bitset<EXTENT_HEADER_PAGES> dirty_;
+    /** True once the control page on disk marks the extent unsynced, so that its pages may be written right away. */
+    bool marked_{false};
+    /** The sequence number of the last change to a checksum of the extent. */
+    uint64_t checksum_seq_{0};
+    /** The number of writes of pages of the extent that are in flight. */
+    int writes_in_flight_{0};
+  };
+
+  /** The free page ids of one buffer pool instance, all congruent to its index modulo the number of instances. */
+  struct FreeList {
+    std::mutex latch_;
+    std::set<page_id_t> pages_;
+  };
+
+  /** @return the header page that holds the checksum of the page in the given slot of its extent */
+  static auto ChecksumPage(int64_t slot) -> size_t {
+    return FIRST_CHECKSUM_PAGE + static_cast<size_t>(slot) * sizeof(uint32_t) / BUSTUB_PAGE_SIZE;
+  }
+
+  /** The least and the most the database file grows by at a time. */
+  static constexpr int64_t DB_GROWTH_MIN_BYTES = 1 << 20;
+  static constexpr int64_t DB_GROWTH_MAX_BYTES = 64 << 20;
+
+  /** @return the size of the file in bytes, or -1 if it does not exist */
+  auto GetFileSize(const std::string &file_name) -> int64_t;
+
+  /**
+   * Get ready to write the page at the given offset: extend the file by a chunk if the page lies past its end.
+   * @param offset offset of the page in the database file
+   */
+  void PreparePageWrite(int64_t offset);
+
+  /** Write a page-sized block at the given offset of the database file. @return false on an I/O error */
+  auto WriteBlock(int64_t offset, const char *data) -> bool;
+
+  /** Read a page-sized block at the given offset of the database file; what lies past its end reads as zeros. */
+  void ReadBlock(int64_t offset, char *data);
+
+  /** @return the offset of header page i of an extent in the database file */
+  static auto HeaderOffset(size_t extent, size_t i) -> int64_t {
+    return (static_cast<int64_t>(extent) * (PAGES_PER_EXTENT + EXTENT_HEADER_PAGES) + static_cast<int64_t>(i)) *
+           BUSTUB_PAGE_SIZE;
+  }
+
+  /** Read the extent headers of the database file and rebuild the high-water mark and the free pages from them. */
+  void LoadExtentHeaders();
+
+  /** Stamp a new database file with the file format, or check that an existing one has it. */
+  void CheckFormat();
+
+  /** @return the header of the extent of a page, created if needed. Caller should hold space_latch_. */
+  auto GetExtentHeader(page_id_t page_id) -> ExtentHeader &;
+
+  /** Spread the free pages over one free list per instance, unless they already are. */
+  void SplitFreeLists(uint32_t num_instances);
+
+  /** Add a page to the free list of its instance. Caller should hold free_lists_latch_ and space_latch_. */
+  void AddFreePage(page_id_t page_id);
+
+  /** Mark a page allocated or free in its space map. Caller should hold space_latch_. */
+  void SetAllocated(page_id_t page_id, bool allocated);
+
+  /** @return true if the page is marked allocated in its space map. Caller should hold space_latch_. */
+  auto IsAllocatedLocked(page_id_t page_id) -> bool;
+
+  /**
+   * Remember the checksum of a page that is about to be written, and count the write as in flight until
+   * FinishPageWrite(). Does nothing with checksums off.
+   * @return false if the extent of the page must be marked unsynced with MarkUnsynced() before the write starts
+   */
+  auto BeginPageWrite(page_id_t page_id, const char *page_data) -> bool;
+
+  /**
+   * Write the extent headers that changed, sync the database file, and clear the marks of the extents that are synced
+   * now. Caller should hold sync_latch_.
+   */
+  void SyncLocked();
+
+  /** Mark the extents of the given pages unsynced on disk, and sync the marks. */
+  void MarkUnsynced(const std::vector<page_id_t> &page_ids);
+
+  /** Mark the given extents unsynced on disk, and sync the marks. Caller should hold sync_latch_. */
+  void MarkUnsyncedLocked(const std::vector<size_t> &extents);
+
+  /** Drop every checksum, when checksums are turned off. */
+  void DropChecksums();
+
+  /** Count a write started by BeginPageWrite() as done. */
+  void FinishPageWrite(page_id_t page_id);
+
+  /** @return the checksum last recorded for a page, 0 if there is none or if a write of the page is in flight */
+  auto GetChecksum(page_id_t page_id) -> uint32_t;
+
+  /**
+   * Verify a page just read if the mode is VERIFY_ON_READ, and record it as corrupt if it fails.
+   * @return false if the page failed verification
+   */
+  auto VerifyRead(page_id_t page_id, const char *page_data) -> bool;
+
+  /** Log, count and record a page that failed verification. */
+  void RecordChecksumFailure(page_id_t page_id);
+
+  /** Main loop of the scrubber thread. */
+  void RunScrubber();
+
+  /** Stop and join the scrubber thread, if it is running. */
+  void StopScrubber();
+
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file, -1 if it is not open
+  int db_fd_{-1};
   std::string file_name_;
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_syncs_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+  // the size the db file has been extended to, and the end of its last written page
+  std::atomic<int64_t> db_file_size_{0};
+  std::atomic<int64_t> db_data_size_{0};
+  // serializes extending the db file
+  std::mutex db_growth_latch_;
+  // false once fallocate() turns out not to be supported
+  bool preallocate_{true};
+  // held shared to use the free lists, and exclusive to split the free pages into a different number of lists. Taken
+  // before space_latch_, which is taken before the latch of a free list.
+  std::shared_mutex free_lists_latch_;
+  std::vector<std::unique_ptr<FreeList>> free_lists_;
+  // protects the extent headers, the high-water mark, the corrupt pages and the writes in flight
+  std::mutex space_latch_;
+  std::vector<ExtentHeader> extents_;
+  page_id_t high_water_mark_{0};
+  std::set<page_id_t> corrupt_pages_;
+  // the number of writes in flight of each page, which has a checksum its data on disk may not match yet
+  std::unordered_map<page_id_t, int> pages_being_written_;
+  // the total of pages_being_written_, which is only read without the latch to skip FinishPageWrite() for a write that
+  // BeginPageWrite() did not count
+  std::atomic<size_t> num_writes_in_flight_{0};
+  // the sequence number of the last checksum recorded
+  uint64_t checksum_seq_{0};
+  // serializes syncs and the marking of extents unsynced
+  std::mutex sync_latch_;
+  std::atomic<int> num_checksum_barriers_{0};
+  std::atomic<ChecksumMode> checksum_mode_{ChecksumMode::VERIFY_ON_READ};
+  std::atomic<int> num_checksum_failures_{0};
+  std::atomic<size_t> pages_scrubbed_{0};
+  // the scrubber thread runs while scrubbing_ is set, protected by scrubber_latch_
+  std::mutex scrubber_latch_;
+  std::condition_variable scrubber_cv_;
+  bool scrubbing_{false};
+  std::thread scrubber_thread_;
 };
 
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
@@ -18,6 +19,7 @@
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/page_guard.h"
 
 #include "common/rwlatch.h"
 
@@ -88,11 +90,47 @@ class BPlusTree {
    * @param transaction 事务指针
    * @param leftMost 是否查找最左侧叶节点
    * @param rightMost 是否查找最右侧叶节点
-   * @return 包含该键的叶节点页面
+   * @return 包含该键的叶节点页面；SEARCH返回已加读锁的叶节点，树为空时返回nullptr。SEARCH不需要持有root_page_id_latch_，
+   * 其他操作须持有其写锁
    */
   auto FindLeaf(const KeyType &key, Operation operation, Transaction *transaction = nullptr, bool leftMost = false,
                 bool rightMost = false) -> Page *;
   
+  /**
+   * @brief 以乐观锁耦合的方式查找叶节点：不获取任何锁，也不固定缓冲池中能通过swip找到的页面
+   * 每个节点先复制出来并校验版本号，再读取副本，因此即使页面在读取期间被修改或被换出也不会读到越界的数据。
+   * 根节点通过root_version_校验，不需要持有root_page_id_latch_
+   * @param key 查找的键
+   * @param leftMost 是否查找最左侧叶节点
+   * @param rightMost 是否查找最右侧叶节点
+   * @param[out] leaf_copy 若非空，叶节点的已校验副本写入其中（须能容纳一个页面），返回的叶节点不被固定；
+   * 若为空，返回的叶节点已固定但未加锁
+   * @param[out] leaf_page 叶节点页面，树为空时为nullptr
+   * @param[out] leaf_version 叶节点的版本号，在原页面上读取叶节点后须用它校验
+   * @return 若途中校验失败则返回false，调用者须从根节点重试
+   */
+  auto FindLeafOptimistic(const KeyType &key, bool leftMost, bool rightMost, char *leaf_copy, Page **leaf_page,
+                          uint64_t *leaf_version) -> bool;
+
+  /**
+   * @brief 为乐观读取找到一个节点：先尝试不固定地通过父节点的swip（根节点则通过root_frame_）找到它，
+   * 否则从缓冲池获取并保持固定，直到找到它的子节点，以免获取子节点时把它换出。之后的校验会发现页框被重用的情况
+   * @param parent 父节点页面，查找根节点时为nullptr
+   * @param slot 子节点在父节点中的位置
+   * @param page_id 节点的页面ID
+   * @param[out] version 节点的版本号
+   * @param[out] pinned 节点是否是从缓冲池获取的，若是则调用者须取消固定
+   * @return 节点页面；获取失败时返回nullptr
+   */
+  auto FindNodeOptimistic(Page *parent, int slot, page_id_t page_id, uint64_t *version, bool *pinned) -> Page *;
+
+  /**
+   * @brief 复制节点中正在使用的部分；无论页面内容如何，都不会读到页面之外
+   * @param page 节点页面
+   * @param[out] copy 副本，须能容纳一个页面
+   */
+  static void CopyNode(Page *page, char *copy);
+
   /**
    * @brief 从队列中释放锁
    * @param transaction 事务指针
@@ -136,10 +174,10 @@ class BPlusTree {
   /**
    * @brief 分裂节点
    * @param node 待分裂节点
-   * @return 分裂出的新节点
+   * @return 分裂出的新节点的页面保护，新节点在其析构时被取消固定
    */
   template <typename N>
-  auto Split(N *node) -> N *;
+  auto Split(N *node) -> BasicPageGuard;
 
   /**
    * @brief 节点合并或重分配
@@ -181,15 +219,26 @@ class BPlusTree {
    * @return 是否需要删除旧根节点
    */
   auto AdjustRoot(BPlusTreePage *node) -> bool;
+
+  /**
+   * @brief 开始修改root_page_id_，调用者须持有root_page_id_latch_的写锁
+   * 在EndRootChange()之前乐观读取者无法开始，之前开始的读取者校验失败
+   */
+  void BeginRootChange();
+
+  /** @brief 结束修改root_page_id_ */
+  void EndRootChange();
   
   // 成员变量
   std::string index_name_;                             // 索引名称
-  page_id_t root_page_id_;                             // 根页面ID
+  std::atomic<page_id_t> root_page_id_;                // 根页面ID，乐观读取者不持锁读取
   BufferPoolManager *buffer_pool_manager_;             // 缓冲池管理器
   KeyComparator comparator_;                           // 键比较器
   int leaf_max_size_;                                  // 叶节点最大大小
   int internal_max_size_;                              // 内部节点最大大小
   ReaderWriterLatch root_page_id_latch_;               // 根页面ID读写锁
+  std::atomic<uint64_t> root_version_{0};              // 根页面ID的版本号，修改期间为奇数
+  std::atomic<Page *> root_frame_{nullptr};            // 上次找到根节点的页框，只是提示，使用前须检查
 };
 
 }  // namespace bustub
\ No newline at end of file
@@ -13,6 +13,7 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include "buffer/read_ahead.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -39,11 +40,16 @@ class IndexIterator {
   auto operator!=(const IndexIterator &itr) const -> bool;
 
  private:
+  /** Reads the next leaf's page id out of a leaf page, for the read-ahead to follow the leaf chain. */
+  static auto NextLeafPageId(Page *page) -> page_id_t;
+
   // add your own private member variables here
   BufferPoolManager *buffer_pool_manager_;
   Page *page_;
   LeafPage *leaf_ = nullptr;
   int index_ = 0;
+  /** Prefetches the leaves ahead of the scan once it follows the leaf chain. */
+  ReadAheadDetector read_ahead_;
 };
 
 }  // namespace bustub
@@ -57,21 +57,22 @@ class HashTableBlockPage {
 
   /**
    * Attempts to insert a key and value into an index in the block.
-   * The insert is thread safe. It uses compare and swap to claim the index,
-   * and then writes the key and value into the index, and then marks the
-   * index as readable.
+   * The index may be brand new or a tombstone. The key and value are written
+   * before the index is marked as readable, so a reader that does not hold
+   * the page latch never sees a half written pair. Writers must hold the
+   * write latch of the page.
    *
    * @param bucket_ind index to write the key and value to
    * @param key key to insert
    * @param value value to insert
    * @return If the value is inserted successfully, it returns true. If the
-   * index is marked as occupied before the key and value can be inserted,
-   * Insert returns false.
+   * index already holds a readable pair, Insert returns false.
    */
   auto Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) -> bool;
 
   /**
-   * Removes a key and value at index.
+   * Removes a key and value at index. The index stays occupied as a tombstone,
+   * so that probe sequences running through it are not cut short.
    *
    * @param bucket_ind ind to remove the value
    */
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -33,6 +34,11 @@ namespace bustub {
  *  The above format omits the space required for the occupied_ and
  *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
  *
+ * Every slot also has a one byte fingerprint of its key, kept in an array of its own. GetValue, Insert and Remove
+ * compare the fingerprints of 32 slots at a time with AVX2, or 16 with SSE2, mask out the slots that are not
+ * readable, and only run the comparator on the slots whose fingerprint matches. Builds for other targets compare
+ * the fingerprints one at a time. The fingerprint is hashed from the bytes of the key, like HashFunction does, so
+ * keys that the comparator considers equal must have the same bytes.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBucketPage {
@@ -45,7 +51,7 @@ class HashTableBucketPage {
    *
    * @return true if at least one key matched
    */
-  auto GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool;
+  auto GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) const -> bool;
 
   /**
    * Attempts to insert a key and value in the bucket.  Uses the occupied_
@@ -58,7 +64,7 @@ class HashTableBucketPage {
   auto Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool;
 
   /**
-   * Removes a key and value.
+   * Removes a key and value. Its slot becomes a tombstone, which a later Insert may reuse.
    *
    * @return true if removed, false if not found
    */
@@ -81,7 +87,7 @@ class HashTableBucketPage {
   auto ValueAt(uint32_t bucket_idx) const -> ValueType;
 
   /**
-   * Remove the KV pair at bucket_idx
+   * Remove the KV pair at bucket_idx. Its slot becomes a tombstone.
    */
   void RemoveAt(uint32_t bucket_idx);
 
@@ -120,17 +126,17 @@ class HashTableBucketPage {
   /**
    * @return the number of readable elements, i.e. current size
    */
-  auto NumReadable() -> uint32_t;
+  auto NumReadable() const -> uint32_t;
 
   /**
    * @return whether the bucket is full
    */
-  auto IsFull() -> bool;
+  auto IsFull() const -> bool;
 
   /**
    * @return whether the bucket is empty
    */
-  auto IsEmpty() -> bool;
+  auto IsEmpty() const -> bool;
 
   /**
    * Prints the bucket's occupancy information
@@ -138,10 +144,23 @@ class HashTableBucketPage {
   void PrintBucket();
 
  private:
+  /** @return the fingerprint of the given key */
+  static auto Fingerprint(const KeyType &key) -> uint8_t;
+
+  /**
+   * Calls visit(bucket_idx) on every readable slot whose fingerprint matches, in slot order, until it returns true.
+   *
+   * @return true if visit returned true
+   */
+  template <typename Visitor>
+  auto ProbeFingerprint(uint8_t fingerprint, Visitor &&visit) const -> bool;
+
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
   char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
   char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  // The fingerprint of the key in each slot; meaningless unless the slot is readable.
+  uint8_t fingerprints_[BUCKET_ARRAY_SIZE];
   // Flexible array member for page data.
   MappingType array_[1];
 };
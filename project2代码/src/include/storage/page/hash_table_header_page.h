@@ -26,15 +26,17 @@ namespace bustub {
  *
  * Header Page for linear probing hash table.
  *
- * Header format (size in byte, 16 bytes in total):
+ * Header format (size in byte, 32 bytes in total with the padding that aligns the size_t fields):
  * -------------------------------------------------------------
- * | LSN (4) | Size (4) | PageId(4) | NextBlockIndex(4)
+ * | LSN (4) | Size (8) | PageId(4) | NextBlockIndex(8)
  * -------------------------------------------------------------
+ *
+ * The page ids of the blocks follow the header, in slot order, and fill up the rest of the page.
  */
 class HashTableHeaderPage {
  public:
   /**
-   * @return the number of buckets in the hash table;
+   * @return the number of buckets in the hash table, i.e. the number of slots in all of its blocks
    */
   auto GetSize() const -> size_t;
 
@@ -82,20 +84,25 @@ class HashTableHeaderPage {
    * @param index the index of the block
    * @return the page_id for the block.
    */
-  auto GetBlockPageId(size_t index) -> page_id_t;
+  auto GetBlockPageId(size_t index) const -> page_id_t;
 
   /**
    * @return the number of blocks currently stored in the header page
    */
-  auto NumBlocks() -> size_t;
+  auto NumBlocks() const -> size_t;
+
+  /**
+   * @return the number of block page ids that fit into a header page
+   */
+  static auto MaxBlocks() -> size_t;
 
  private:
-  __attribute__((unused)) lsn_t lsn_;
-  __attribute__((unused)) size_t size_;
-  __attribute__((unused)) page_id_t page_id_;
-  __attribute__((unused)) size_t next_ind_;
+  lsn_t lsn_;
+  size_t size_;
+  page_id_t page_id_;
+  size_t next_ind_;
   // Flexible array member for page data.
-  __attribute__((unused)) page_id_t block_page_ids_[1];
+  page_id_t block_page_ids_[1];
 };
 
 }  // namespace bustub
@@ -12,14 +12,23 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <thread>  // NOLINT
 
 #include "common/config.h"
 #include "common/rwlatch.h"
 
 namespace bustub {
 
+/** What kind of page a frame holds, as declared by the access method that uses it. Only used for statistics. */
+enum class PageType : uint8_t { UNKNOWN = 0, HEADER, TABLE, INDEX };
+
+/** Number of PageType values. */
+static constexpr size_t NUM_PAGE_TYPES = 4;
+
 /**
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
@@ -40,7 +49,7 @@ class Page {
   inline auto GetData() -> char * { return data_; }
 
   /** @return the page id of this page */
-  inline auto GetPageId() -> page_id_t { return page_id_; }
+  inline auto GetPageId() -> page_id_t { return page_id_.load(std::memory_order_relaxed); }
 
   /** @return the pin count of this page */
   inline auto GetPinCount() -> int { return pin_count_; }
@@ -48,11 +57,31 @@ class Page {
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline auto IsDirty() -> bool { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
-
-  /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  /** @return the kind of page in this frame, UNKNOWN if no access method has declared it since the page was loaded */
+  inline auto GetPageType() const -> PageType { return page_type_.load(std::memory_order_relaxed); }
+
+  /**
+   * Declare the kind of page in this frame. Cheap enough to call on every fetch: the frame is only written when the
+   * type changes.
+   */
+  inline void SetPageType(PageType page_type) {
+    if (page_type_.load(std::memory_order_relaxed) != page_type) {
+      page_type_.store(page_type, std::memory_order_relaxed);
+    }
+  }
+
+  /** Acquire the page write latch. The version turns odd, so that optimistic readers of the page fail to validate. */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /** Release the page write latch. The version turns even again. */
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +89,41 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read of the page. Unlike RLatch(), this writes no shared memory. The reader must call
+   * ValidateOptimisticLatch() after reading, and throw away what it read if that fails. Waits while a writer holds the
+   * write latch.
+   * @return the version to validate against
+   */
+  inline auto OptimisticLatch() -> uint64_t {
+    uint64_t version;
+    while (((version = version_.load(std::memory_order_acquire)) & 1) != 0) {
+      std::this_thread::yield();
+    }
+    return version;
+  }
+
+  /**
+   * Start an optimistic read of a frame that is not pinned, e.g. one found through a swip. Unlike OptimisticLatch(), it
+   * fails instead of waiting while the page is write latched or the frame is being loaded, and it fails if the frame
+   * does not hold page_id. The buffer pool changes the version whenever it puts another page into the frame, so
+   * ValidateOptimisticLatch() also fails if the frame was reused during the read. A reader must not trust anything it
+   * read, not even a size to index with, until it has validated.
+   * @param page_id the page the reader is looking for
+   * @param[out] version the version to validate against
+   * @return false if the read cannot start
+   */
+  inline auto OptimisticLatchFrame(page_id_t page_id, uint64_t *version) -> bool {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0 && page_id_.load(std::memory_order_relaxed) == page_id;
+  }
+
+  /** @return true if the page has not been write latched since OptimisticLatch() returned version */
+  inline auto ValidateOptimisticLatch(uint64_t version) -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -78,16 +142,43 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
 
+  /**
+   * Mark the frame as changing pages, like a write latch does for a change of the page. Only called on an unpinned
+   * frame, which nobody can write latch.
+   */
+  inline void BeginFrameChange() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /** Mark the frame as holding its new page. */
+  inline void EndFrameChange() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
   /** The actual data that is stored within a page. */
   char data_[BUSTUB_PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
+  /** The ID of this page. Atomic, since OptimisticLatchFrame() reads it without a pin while the frame may change. */
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
   /** The pin count of this page. */
   int pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
+  /** The kind of page in this frame. Reset whenever a new page is loaded into the frame. */
+  std::atomic<PageType> page_type_{PageType::UNKNOWN};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /**
+   * Bumped on every write latch and unlatch, and whenever the frame changes pages. Odd while the write latch is held
+   * and while the frame is being loaded.
+   */
+  std::atomic<uint64_t> version_{0};
+  /**
+   * Swizzled child references of an index page, null unless the buffer pool has swizzling enabled. swips_[i] is the
+   * frame that held the child in slot i the last time it was fetched through FetchChildPage(), in the buffer pool
+   * instance that owns that child. A swip is only a hint and is checked against the child's page id before use.
+   */
+  std::atomic<frame_id_t> *swips_{nullptr};
 };
 
 }  // namespace bustub
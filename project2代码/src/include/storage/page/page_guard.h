@@ -0,0 +1,258 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns one pin on a buffer pool page and unpins it when it goes out of scope. It does not hold the page
+ * latch. Guards are move-only, so a pin can be handed over to another guard but never duplicated or leaked.
+ *
+ * The guard remembers whether the page was modified through it: AsMut() and friends mark it dirty, and the dirty flag
+ * is passed to UnpinPage() when the guard is dropped.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * @brief Take over a pin on page that the caller already holds.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned page, or nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  /** @brief Move constructor. The moved-from guard becomes empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** @brief Move assignment. Drops the page currently guarded by this guard, then takes over the pin of that. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  /** @brief Unpin the page, if this guard still holds one. */
+  ~BasicPageGuard();
+
+  /** @brief Unpin the page now instead of at the end of the scope. Dropping an empty guard does nothing. */
+  void Drop();
+
+  /**
+   * @brief Read latch the page and hand the pin over to a ReadPageGuard, without unpinning and refetching it.
+   * This guard is empty afterwards. Upgrading an empty guard gives an empty guard.
+   */
+  auto UpgradeRead() -> ReadPageGuard;
+
+  /**
+   * @brief Write latch the page and hand the pin over to a WritePageGuard, without unpinning and refetching it.
+   * This guard is empty afterwards. Upgrading an empty guard gives an empty guard.
+   */
+  auto UpgradeWrite() -> WritePageGuard;
+
+  /** @return true if the guard holds a page, false if the fetch failed or the guard was dropped or moved from */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  auto PageId() -> page_id_t { return page_->GetPageId(); }
+
+  /** @return the read-only data of the guarded page */
+  auto GetData() -> const char * { return page_->GetData(); }
+
+  /** @return the data of the guarded page; the page will be unpinned as dirty */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** @return the data of the guarded page, interpreted as T (e.g. a B+ tree node) */
+  template <class T>
+  auto As() -> const T * {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @return the data of the guarded page, interpreted as T; the page will be unpinned as dirty */
+  template <class T>
+  auto AsMut() -> T * {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+  /**
+   * @return the guarded page as T, for page types that are views over Page itself (e.g. TablePage). The page is not
+   * marked dirty; call SetDirty() if it is modified.
+   */
+  template <class T>
+  auto AsPage() -> T * {
+    static_assert(std::is_base_of_v<Page, T>, "AsPage() is for subclasses of Page, use As() for page data");
+    return static_cast<T *>(page_);
+  }
+
+  /** @return the guarded page as T, like AsPage(); the page will be unpinned as dirty */
+  template <class T>
+  auto AsPageMut() -> T * {
+    is_dirty_ = true;
+    return AsPage<T>();
+  }
+
+  /** @brief Unpin the page as dirty. For callers that only find out after the fact whether they modified the page. */
+  void SetDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns one pin and the read latch on a page. It releases the latch and then the pin when it goes out of
+ * scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * @brief Take over a pin and a read latch on page that the caller already holds.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned and read latched page, or nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+
+  /** @brief Move constructor. The moved-from guard becomes empty. */
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** @brief Move assignment. Drops the page currently guarded by this guard, then takes over the page of that. */
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  /** @brief Release the read latch and the pin, if this guard still holds a page. */
+  ~ReadPageGuard();
+
+  /** @brief Release the read latch and the pin now instead of at the end of the scope. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  /** @return the read-only data of the guarded page */
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  /** @return the data of the guarded page, interpreted as T */
+  template <class T>
+  auto As() -> const T * {
+    return guard_.As<T>();
+  }
+
+  /** @return the guarded page as T, for page types that are views over Page itself (e.g. TablePage) */
+  template <class T>
+  auto AsPage() -> T * {
+    return guard_.AsPage<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns one pin and the write latch on a page. It releases the latch and then the pin when it goes out
+ * of scope.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * @brief Take over a pin and a write latch on page that the caller already holds.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned and write latched page, or nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+
+  /** @brief Move constructor. The moved-from guard becomes empty. */
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** @brief Move assignment. Drops the page currently guarded by this guard, then takes over the page of that. */
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  /** @brief Release the write latch and the pin, if this guard still holds a page. */
+  ~WritePageGuard();
+
+  /** @brief Release the write latch and the pin now instead of at the end of the scope. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  /** @return the read-only data of the guarded page */
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  /** @return the data of the guarded page; the page will be unpinned as dirty */
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  /** @return the data of the guarded page, interpreted as T */
+  template <class T>
+  auto As() -> const T * {
+    return guard_.As<T>();
+  }
+
+  /** @return the data of the guarded page, interpreted as T; the page will be unpinned as dirty */
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+  /** @return the guarded page as T, for page types that are views over Page itself. The page is not marked dirty. */
+  template <class T>
+  auto AsPage() -> T * {
+    return guard_.AsPage<T>();
+  }
+
+  /** @return the guarded page as T, like AsPage(); the page will be unpinned as dirty */
+  template <class T>
+  auto AsPageMut() -> T * {
+    return guard_.AsPageMut<T>();
+  }
+
+  /** @brief Unpin the page as dirty. */
+  void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
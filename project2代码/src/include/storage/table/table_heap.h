@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -52,12 +54,16 @@ class TableHeap {
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   *
+   * With an access strategy the insert is treated as part of a bulk load: it starts looking for free space at the last
+   * page of the heap instead of the first one, and goes through the strategy's ring of frames.
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
+   * @param strategy the buffer access strategy of a bulk load, or nullptr
    * @return true iff the insert is successful
    */
-  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
+  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> bool;
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -95,12 +101,19 @@ class TableHeap {
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
+   * @param acquire_read_lock whether to read latch the page
+   * @param strategy the buffer access strategy of a scan, or nullptr
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true) -> bool;
+  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true,
+                BufferAccessStrategy *strategy = nullptr) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy the buffer access strategy of the scan, or nullptr. It must outlive the iterator.
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
@@ -113,6 +126,8 @@ class TableHeap {
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** A page at or before the end of the page chain, where bulk inserts start looking for space. */
+  std::atomic<page_id_t> last_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
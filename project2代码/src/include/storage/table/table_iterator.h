@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/read_ahead.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,10 +30,20 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  /**
+   * @param table_heap the table to iterate over
+   * @param rid the first tuple
+   * @param txn the transaction performing the scan
+   * @param strategy the buffer access strategy of the scan, or nullptr
+   */
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        read_ahead_(other.read_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -54,6 +65,8 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    read_ahead_ = other.read_ahead_;
     return *this;
   }
 
@@ -61,6 +74,10 @@ class TableIterator {
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The buffer access strategy of the scan, not owned. */
+  BufferAccessStrategy *strategy_;
+  /** Prefetches the pages ahead of the scan once it follows the heap's page chain. */
+  ReadAheadDetector read_ahead_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,94 @@
+#include <memory>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "common/macros.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+static void SplitConjuncts(const AbstractExpressionRef &expr, std::vector<AbstractExpressionRef> *conjuncts) {
+  if (const auto *logic_expr = dynamic_cast<const LogicExpression *>(expr.get());
+      logic_expr != nullptr && logic_expr->logic_type_ == LogicType::And) {
+    SplitConjuncts(logic_expr->GetChildAt(0), conjuncts);
+    SplitConjuncts(logic_expr->GetChildAt(1), conjuncts);
+    return;
+  }
+  conjuncts->push_back(expr);
+}
+
+auto Optimizer::OptimizeSeqScanAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeSeqScanAsIndexScan(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() == PlanType::Filter) {
+    const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*optimized_plan);
+    BUSTUB_ENSURE(filter_plan.children_.size() == 1, "Filter with multiple children?? Impossible!");
+    const auto &child_plan = filter_plan.children_[0];
+    if (child_plan->GetType() != PlanType::SeqScan) {
+      return optimized_plan;
+    }
+    const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*child_plan);
+
+    std::vector<AbstractExpressionRef> conjuncts;
+    SplitConjuncts(filter_plan.GetPredicate(), &conjuncts);
+    for (auto conjunct = conjuncts.begin(); conjunct != conjuncts.end(); ++conjunct) {
+      // Conjunct is in form of <column_expr> = <constant_expr>, either way round
+      const auto *expr = dynamic_cast<const ComparisonExpression *>(conjunct->get());
+      if (expr == nullptr || expr->comp_type_ != ComparisonType::Equal) {
+        continue;
+      }
+      const auto *column_expr = dynamic_cast<const ColumnValueExpression *>(expr->GetChildAt(0).get());
+      auto key_expr = expr->GetChildAt(1);
+      if (column_expr == nullptr) {
+        column_expr = dynamic_cast<const ColumnValueExpression *>(expr->GetChildAt(1).get());
+        key_expr = expr->GetChildAt(0);
+      }
+      if (column_expr == nullptr || dynamic_cast<const ConstantValueExpression *>(key_expr.get()) == nullptr ||
+          key_expr->GetReturnType() != column_expr->GetReturnType()) {
+        continue;
+      }
+
+      // Match an index on exactly that column, preferring a hash index
+      const IndexInfo *index = nullptr;
+      const auto key_attrs = std::vector{column_expr->GetColIdx()};
+      for (const auto *index_info : catalog_.GetTableIndexes(seq_scan.table_name_)) {
+        if (key_attrs == index_info->index_->GetKeyAttrs() &&
+            (index == nullptr || index_info->index_type_ != IndexType::BPlusTreeIndex)) {
+          index = index_info;
+        }
+      }
+      if (index == nullptr) {
+        continue;
+      }
+
+      AbstractPlanNodeRef index_scan =
+          std::make_shared<IndexScanPlanNode>(seq_scan.output_schema_, index->index_oid_, std::move(key_expr));
+      conjuncts.erase(conjunct);
+      if (conjuncts.empty()) {
+        return index_scan;
+      }
+      // The other conjuncts still filter the tuples that the index returns
+      auto predicate = conjuncts[0];
+      for (size_t i = 1; i < conjuncts.size(); i++) {
+        predicate = std::make_shared<LogicExpression>(predicate, conjuncts[i], LogicType::And);
+      }
+      return std::make_shared<FilterPlanNode>(filter_plan.output_schema_, std::move(predicate), std::move(index_scan));
+    }
+  }
+
+  return optimized_plan;
+}
+
+}  // namespace bustub
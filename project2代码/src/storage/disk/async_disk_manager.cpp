@@ -0,0 +1,423 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.cpp
+//
+// Identification: src/storage/disk/async_disk_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_manager.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BUSTUB_HAVE_IO_URING
+#endif
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+/**
+ * The submission and completion queues of an io_uring, mapped into our address space. Entries are prepared under the
+ * latch of the disk manager, while completions are popped by the completion thread only.
+ */
+class AsyncDiskManager::IoUring {
+ public:
+  /** @return a ring with room for at least the given number of entries, or nullptr if the kernel lacks io_uring */
+  static auto Create(unsigned entries) -> std::unique_ptr<IoUring> {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd < 0) {
+      return nullptr;
+    }
+    // IORING_OP_READ and IORING_OP_WRITE came with Linux 5.6, as did this feature flag
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      close(ring_fd);
+      return nullptr;
+    }
+    auto ring = std::unique_ptr<IoUring>(new IoUring(ring_fd));
+    if (!ring->Map(params)) {
+      return nullptr;
+    }
+    return ring;
+  }
+
+  DISALLOW_COPY_AND_MOVE(IoUring);
+
+  ~IoUring() {
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    close(ring_fd_);
+  }
+
+  /** @brief Queue an entry for the next Enter(). The caller makes sure that the submission queue has room. */
+  void Prepare(uint8_t opcode, int fd, char *buf, unsigned len, off_t offset, uint64_t user_data) {
+    auto tail = *sq_tail_;
+    auto index = tail & *sq_mask_;
+    auto *sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    // The kernel reads the entry once it sees the new tail
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  /**
+   * @brief Submit the given number of prepared entries, and wait until at least min_complete completions are there.
+   * @return false if the kernel refused
+   */
+  auto Enter(unsigned to_submit, unsigned min_complete) -> bool {
+    while (true) {
+      auto flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0U;
+      auto rc = syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0);
+      if (rc >= 0) {
+        to_submit -= std::min<unsigned>(to_submit, static_cast<unsigned>(rc));
+        if (to_submit == 0) {
+          return true;
+        }
+        continue;
+      }
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+        return false;
+      }
+    }
+  }
+
+  /**
+   * @brief Take back the prepared entries that the kernel has not taken, which are the ones prepared last.
+   * @return the number of entries taken back
+   */
+  auto Withdraw() -> unsigned {
+    auto head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    auto count = *sq_tail_ - head;
+    __atomic_store_n(sq_tail_, head, __ATOMIC_RELEASE);
+    return count;
+  }
+
+  /** @brief Pop the oldest completion, if there is one. */
+  auto PopCompletion(uint64_t *user_data, int *result) -> bool {
+    auto head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    const auto &cqe = cqes_[head & *cq_mask_];
+    *user_data = cqe.user_data;
+    *result = cqe.res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+ private:
+  explicit IoUring(int ring_fd) : ring_fd_(ring_fd) {}
+
+  auto Map(const io_uring_params &params) -> bool {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // Since Linux 5.4 both rings live in one mapping
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                  IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    auto *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    auto *sq = static_cast<char *>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  int ring_fd_;
+  void *sq_ring_{MAP_FAILED};
+  void *cq_ring_{MAP_FAILED};
+  size_t sq_ring_size_{0};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{static_cast<io_uring_sqe *>(MAP_FAILED)};
+  size_t sqes_size_{0};
+  unsigned *sq_head_{nullptr};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+};
+
+#else
+
+/** Without the io_uring header there is no ring, and the disk manager always uses its thread pool. */
+class AsyncDiskManager::IoUring {
+ public:
+  static auto Create(unsigned entries) -> std::unique_ptr<IoUring> { return nullptr; }
+  void Prepare(uint8_t opcode, int fd, char *buf, unsigned len, off_t offset, uint64_t user_data) {}
+  auto Enter(unsigned to_submit, unsigned min_complete) -> bool { return false; }
+  auto Withdraw() -> unsigned { return 0; }
+  auto PopCompletion(uint64_t *user_data, int *result) -> bool { return false; }
+};
+
+#endif
+
+AsyncDiskManager::AsyncDiskManager(const std::string &db_file, size_t queue_depth, bool use_io_uring)
+    : DiskManager(db_file), queue_depth_(std::max<size_t>(1, queue_depth)) {
+  if (use_io_uring) {
+    ring_ = IoUring::Create(static_cast<unsigned>(queue_depth_));
+  }
+  if (ring_ != nullptr) {
+    completion_thread_ = std::thread(&AsyncDiskManager::RunCompletions, this);
+    return;
+  }
+  for (size_t i = 0; i < queue_depth_; i++) {
+    workers_.emplace_back(&AsyncDiskManager::RunWorker, this);
+  }
+}
+
+AsyncDiskManager::~AsyncDiskManager() {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    slot_cv_.wait(lock, [&] { return num_in_flight_ == 0; });
+    stopping_ = true;
+    if (ring_ != nullptr) {
+      // A no-op with no request attached tells the completion thread to stop
+#ifdef BUSTUB_HAVE_IO_URING
+      ring_->Prepare(IORING_OP_NOP, -1, nullptr, 0, 0, 0);
+#endif
+      if (!ring_->Enter(1, 0)) {
+        LOG_DEBUG("could not stop the io_uring completion thread");
+      }
+    }
+  }
+  queue_cv_.notify_all();
+  if (completion_thread_.joinable()) {
+    completion_thread_.join();
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+auto AsyncDiskManager::GetEngine() const -> AsyncIoEngine {
+  return ring_ != nullptr ? AsyncIoEngine::IO_URING : AsyncIoEngine::THREAD_POOL;
+}
+
+void AsyncDiskManager::Schedule(std::vector<DiskRequest> *requests) {
+  // Checksum the pages and extend the file before any of the writes is issued, outside the latch. The extents that are
+  // not marked unsynced yet are marked with one sync for the whole batch.
+  std::vector<page_id_t> unmarked;
+  for (const auto &request : *requests) {
+    if (request.is_write_) {
+      if (!BeginPageWrite(request.page_id_, request.data_)) {
+        unmarked.push_back(request.page_id_);
+      }
+      PreparePageWrite(PageOffset(request.page_id_));
+    }
+  }
+  if (!unmarked.empty()) {
+    MarkUnsynced(unmarked);
+  }
+
+  if (ring_ != nullptr) {
+    ScheduleIoUring(requests);
+    return;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  for (auto &request : *requests) {
+    slot_cv_.wait(lock, [&] { return num_in_flight_ < queue_depth_; });
+    num_in_flight_++;
+    queue_.push_back(std::move(request));
+    queue_cv_.notify_one();
+  }
+}
+
+void AsyncDiskManager::ScheduleIoUring(std::vector<DiskRequest> *requests) {
+#ifdef BUSTUB_HAVE_IO_URING
+  std::unique_lock<std::mutex> lock(latch_);
+  std::vector<DiskRequest *> prepared;
+  // If the kernel refuses the entries, the ones it did not take are taken back and left in prepared
+  auto submit = [&] {
+    if (ring_->Enter(static_cast<unsigned>(prepared.size()), 0)) {
+      prepared.clear();
+      return true;
+    }
+    auto num_withdrawn = ring_->Withdraw();
+    prepared.erase(prepared.begin(), prepared.end() - static_cast<std::ptrdiff_t>(num_withdrawn));
+    num_in_flight_ -= num_withdrawn;
+    slot_cv_.notify_all();
+    return false;
+  };
+  size_t next = 0;
+  bool submitted = true;
+  for (; next < requests->size(); next++) {
+    if (num_in_flight_ == queue_depth_) {
+      // Submit what we have so far, then wait for a slot
+      if (!prepared.empty()) {
+        submitted = submit();
+        if (!submitted) {
+          break;
+        }
+      }
+      slot_cv_.wait(lock, [&] { return num_in_flight_ < queue_depth_; });
+    }
+    auto &request = (*requests)[next];
+    if (request.is_write_) {
+      num_writes_.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto *in_flight = new DiskRequest(std::move(request));
+    ring_->Prepare(in_flight->is_write_ ? IORING_OP_WRITE : IORING_OP_READ, db_fd_, in_flight->data_,
+                   BUSTUB_PAGE_SIZE, PageOffset(in_flight->page_id_), reinterpret_cast<uint64_t>(in_flight));
+    num_in_flight_++;
+    prepared.push_back(in_flight);
+  }
+  if (submitted && !prepared.empty()) {
+    submitted = submit();
+  }
+  lock.unlock();
+  if (submitted) {
+    return;
+  }
+
+  // Do the requests the kernel did not take, and the ones not prepared yet, synchronously. Complete() finishes a
+  // request that transferred nothing that way.
+  for (auto *request : prepared) {
+    Complete(request, 0);
+    delete request;
+  }
+  for (; next < requests->size(); next++) {
+    auto &request = (*requests)[next];
+    if (request.is_write_) {
+      num_writes_.fetch_add(1, std::memory_order_relaxed);
+    }
+    Complete(&request, 0);
+  }
+#endif
+}
+
+void AsyncDiskManager::RunCompletions() {
+  while (true) {
+    if (!ring_->Enter(0, 1)) {
+      return;
+    }
+    uint64_t user_data;
+    int result;
+    size_t completed = 0;
+    bool stop = false;
+    while (ring_->PopCompletion(&user_data, &result)) {
+      if (user_data == 0) {
+        stop = true;
+        continue;
+      }
+      auto *request = reinterpret_cast<DiskRequest *>(user_data);
+      Complete(request, result);
+      delete request;
+      completed++;
+    }
+    if (completed > 0) {
+      std::scoped_lock<std::mutex> lock(latch_);
+      num_in_flight_ -= completed;
+      slot_cv_.notify_all();
+    }
+    if (stop) {
+      return;
+    }
+  }
+}
+
+void AsyncDiskManager::RunWorker() {
+  while (true) {
+    DiskRequest request;
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      queue_cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      request = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    bool ok = true;
+    if (request.is_write_) {
+      num_writes_.fetch_add(1, std::memory_order_relaxed);
+      ok = WriteBlock(PageOffset(request.page_id_), request.data_);
+      FinishPageWrite(request.page_id_);
+    } else {
+      ReadBlock(PageOffset(request.page_id_), request.data_);
+      ok = VerifyRead(request.page_id_, request.data_);
+    }
+    request.callback_.set_value(ok);
+    std::scoped_lock<std::mutex> lock(latch_);
+    num_in_flight_--;
+    slot_cv_.notify_all();
+  }
+}
+
+void AsyncDiskManager::Complete(DiskRequest *request, int result) {
+  bool ok = result >= 0;
+  if (!ok) {
+    LOG_DEBUG("I/O error on page %d: %s", request->page_id_, strerror(-result));
+  } else if (result < BUSTUB_PAGE_SIZE) {
+    // The page ends past the end of the file, or the kernel transferred part of it: finish it like a synchronous call
+    if (request->is_write_) {
+      ok = WriteBlock(PageOffset(request->page_id_), request->data_);
+    } else {
+      ReadBlock(PageOffset(request->page_id_), request->data_);
+    }
+  }
+  if (request->is_write_) {
+    FinishPageWrite(request->page_id_);
+  }
+  request->callback_.set_value(ok && (request->is_write_ || VerifyRead(request->page_id_, request->data_)));
+}
+
+}  // namespace bustub
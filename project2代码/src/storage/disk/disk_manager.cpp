@@ -10,16 +10,20 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
-#include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
@@ -49,27 +53,38 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
-    }
+  // open or create the db file
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
   }
+  db_file_size_ = db_data_size_ = GetFileSize(file_name_);
+  LoadExtentHeaders();
+  CheckFormat();
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  StopScrubber();
+  if (db_fd_ >= 0) {
+    // The space maps that changed since the last sync would be lost otherwise
+    SyncDatabase();
+    close(db_fd_);
+  }
+}
+
 /**
- * Close all file streams
+ * Sync the db file and close all file resources
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  StopScrubber();
+  if (db_fd_ >= 0) {
+    if (db_data_size_ < db_file_size_ && ftruncate(db_fd_, db_data_size_) != 0) {
+      LOG_DEBUG("I/O error while trimming the db file: %s", strerror(errno));
+    }
+    SyncDatabase();
+    close(db_fd_);
+    db_fd_ = -1;
   }
   log_io_.close();
 }
@@ -78,50 +93,609 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
-  // set write cursor to offset
-  num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
-    return;
+  auto offset = PageOffset(page_id);
+  num_writes_.fetch_add(1, std::memory_order_relaxed);
+  if (!BeginPageWrite(page_id, page_data)) {
+    MarkUnsynced({page_id});
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  PreparePageWrite(offset);
+  WriteBlock(offset, page_data);
+  FinishPageWrite(page_id);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
+  ReadBlock(PageOffset(page_id), page_data);
+  VerifyRead(page_id, page_data);
+}
+
+auto DiskManager::WriteBlock(int64_t offset, const char *data) -> bool {
+  // pwrite() may write less than asked for, or be interrupted by a signal before writing anything
+  size_t written = 0;
+  while (written < BUSTUB_PAGE_SIZE) {
+    auto rc = pwrite(db_fd_, data + written, BUSTUB_PAGE_SIZE - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing: %s", strerror(errno));
+      return false;
+    }
+    written += rc;
+  }
+  return true;
+}
+
+void DiskManager::ReadBlock(int64_t offset, char *page_data) {
+  size_t read_count = 0;
+  while (read_count < BUSTUB_PAGE_SIZE) {
+    auto rc = pread(db_fd_, page_data + read_count, BUSTUB_PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      LOG_DEBUG("I/O error while reading: %s", strerror(errno));
       return;
     }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+    if (rc == 0) {
+      // the file ends before the page does, e.g. a page that was allocated but never written
+      break;
     }
+    read_count += rc;
+  }
+  if (read_count < BUSTUB_PAGE_SIZE) {
+    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
   }
 }
 
+/**
+ * Extend the db file by a chunk, starting at the page, if the page lies past its end
+ */
+void DiskManager::PreparePageWrite(int64_t offset) {
+  const int64_t end = offset + BUSTUB_PAGE_SIZE;
+  auto data_size = db_data_size_.load(std::memory_order_relaxed);
+  while (data_size < end && !db_data_size_.compare_exchange_weak(data_size, end, std::memory_order_relaxed)) {
+  }
+  if (end <= db_file_size_.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  std::scoped_lock growth_lock(db_growth_latch_);
+  auto file_size = db_file_size_.load(std::memory_order_relaxed);
+  if (end <= file_size) {
+    return;
+  }
+  // Grow by the size of the file so far, so that small files stay small and large ones grow in large steps. A write far
+  // past the end leaves a hole and starts the smallest chunk at the page.
+  auto chunk =
+      offset > file_size ? DB_GROWTH_MIN_BYTES : std::clamp(file_size, DB_GROWTH_MIN_BYTES, DB_GROWTH_MAX_BYTES);
+#ifdef __linux__
+  if (preallocate_ && fallocate(db_fd_, 0, offset, chunk) != 0) {
+    // pwrite() grows the file a page at a time instead
+    LOG_DEBUG("can't preallocate the db file: %s", strerror(errno));
+    preallocate_ = false;
+  }
+#else
+  preallocate_ = false;
+#endif
+  db_file_size_.store(preallocate_ ? offset + chunk : end, std::memory_order_release);
+}
+
+/**
+ * Force the pages written so far to stable storage
+ */
+void DiskManager::SyncDatabase() {
+  if (db_fd_ < 0) {
+    return;
+  }
+  num_syncs_.fetch_add(1, std::memory_order_relaxed);
+  std::scoped_lock sync_lock(sync_latch_);
+  SyncLocked();
+}
+
+void DiskManager::SyncLocked() {
+  uint64_t seq;
+  bool written = true;
+  {
+    // The headers are written under the latch, so that none of them is older on disk than a ShrinkFile() that follows
+    std::scoped_lock space_lock(space_latch_);
+    seq = checksum_seq_;
+    for (size_t extent = 0; extent < extents_.size(); extent++) {
+      auto &header = extents_[extent];
+      for (size_t i = 0; header.dirty_.any() && i < EXTENT_HEADER_PAGES; i++) {
+        if (header.dirty_[i]) {
+          auto offset = HeaderOffset(extent, i);
+          PreparePageWrite(offset);
+          header.dirty_[i] = !WriteBlock(offset, header.Page(i));
+          written = written && !header.dirty_[i];
+        }
+      }
+    }
+  }
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing: %s", strerror(errno));
+    written = false;
+  }
+  if (!written) {
+    return;
+  }
+
+  // The checksums up to seq and the pages written before them are on disk now. An extent whose checksums have not
+  // changed since, with no write in flight, matches its pages. Clearing its mark needs no sync: until the clear reaches
+  // the disk, a crash only drops checksums that were good.
+  std::scoped_lock space_lock(space_latch_);
+  for (size_t extent = 0; extent < extents_.size(); extent++) {
+    auto &header = extents_[extent];
+    if (header.marked_ && header.checksum_seq_ <= seq && header.writes_in_flight_ == 0) {
+      header.Control()->unsynced_ = 0;
+      header.marked_ = false;
+      header.dirty_[CONTROL_PAGE] = !WriteBlock(HeaderOffset(extent, CONTROL_PAGE), header.Page(CONTROL_PAGE));
+    }
+  }
+}
+
+void DiskManager::MarkUnsynced(const std::vector<page_id_t> &page_ids) {
+  std::vector<size_t> extents;
+  extents.reserve(page_ids.size());
+  for (auto page_id : page_ids) {
+    extents.push_back(static_cast<size_t>(page_id / PAGES_PER_EXTENT));
+  }
+  std::scoped_lock sync_lock(sync_latch_);
+  MarkUnsyncedLocked(extents);
+}
+
+void DiskManager::MarkUnsyncedLocked(const std::vector<size_t> &extents) {
+  // Only one thread marks extents at a time, so an extent that is being marked has its flag set but is not marked yet
+  std::vector<size_t> marked;
+  {
+    std::scoped_lock space_lock(space_latch_);
+    for (auto extent : extents) {
+      if (extent >= extents_.size() || extents_[extent].marked_ || extents_[extent].Control()->unsynced_ != 0) {
+        continue;
+      }
+      auto &header = extents_[extent];
+      header.Control()->unsynced_ = 1;
+      marked.push_back(extent);
+      if (db_fd_ >= 0) {
+        auto offset = HeaderOffset(extent, CONTROL_PAGE);
+        PreparePageWrite(offset);
+        header.dirty_[CONTROL_PAGE] = !WriteBlock(offset, header.Page(CONTROL_PAGE));
+      }
+    }
+  }
+  if (marked.empty()) {
+    return;
+  }
+  if (db_fd_ >= 0) {
+    num_checksum_barriers_.fetch_add(1, std::memory_order_relaxed);
+    if (fdatasync(db_fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing: %s", strerror(errno));
+    }
+  }
+  std::scoped_lock space_lock(space_latch_);
+  for (auto extent : marked) {
+    if (extent < extents_.size()) {
+      extents_[extent].marked_ = true;
+    }
+  }
+}
+
+/**
+ * Read the header of every extent in the file, and rebuild the free space from the space maps
+ */
+void DiskManager::LoadExtentHeaders() {
+  const int64_t extent_size = (PAGES_PER_EXTENT + EXTENT_HEADER_PAGES) * BUSTUB_PAGE_SIZE;
+  const auto num_extents = static_cast<size_t>((db_file_size_ + extent_size - 1) / extent_size);
+  extents_.resize(num_extents);
+  for (size_t extent = 0; extent < num_extents; extent++) {
+    auto &header = extents_[extent];
+    for (size_t i = 0; i < EXTENT_HEADER_PAGES; i++) {
+      ReadBlock(HeaderOffset(extent, i), header.Page(i));
+    }
+    // Pages of the extent were written after its checksums were last synced, so none of them can be trusted. The next
+    // sync writes the dropped checksums and clears the mark.
+    if (header.Control()->unsynced_ != 0) {
+      std::fill(header.checksums_.get(), header.checksums_.get() + PAGES_PER_EXTENT, 0);
+      for (auto i = FIRST_CHECKSUM_PAGE; i < EXTENT_HEADER_PAGES; i++) {
+        header.dirty_[i] = true;
+      }
+      header.marked_ = true;
+      header.checksum_seq_ = ++checksum_seq_;
+    }
+  }
+
+  // The high-water mark is one past the last allocated page, and every page below it that is not allocated is free
+  for (auto page_id = static_cast<page_id_t>(num_extents * PAGES_PER_EXTENT); page_id > 0; page_id -= 8) {
+    if (extents_[(page_id - 1) / PAGES_PER_EXTENT].space_map_[(page_id - 1) % PAGES_PER_EXTENT / 8] != 0) {
+      high_water_mark_ = page_id;
+      while (!IsAllocatedLocked(high_water_mark_ - 1)) {
+        high_water_mark_--;
+      }
+      break;
+    }
+  }
+  // Until instances allocate pages, all of them are free for one
+  free_lists_.push_back(std::make_unique<FreeList>());
+  auto &free_pages = free_lists_[0]->pages_;
+  for (page_id_t page_id = 0; page_id < high_water_mark_; page_id++) {
+    if (!IsAllocatedLocked(page_id)) {
+      free_pages.insert(free_pages.end(), page_id);
+    }
+  }
+}
+
+void DiskManager::SplitFreeLists(uint32_t num_instances) {
+  std::unique_lock lists_lock(free_lists_latch_);
+  if (free_lists_.size() == num_instances) {
+    return;
+  }
+  std::vector<std::unique_ptr<FreeList>> free_lists(num_instances);
+  for (auto &free_list : free_lists) {
+    free_list = std::make_unique<FreeList>();
+  }
+  for (const auto &free_list : free_lists_) {
+    for (auto page_id : free_list->pages_) {
+      auto &free_pages = free_lists[static_cast<uint32_t>(page_id) % num_instances]->pages_;
+      free_pages.insert(free_pages.end(), page_id);
+    }
+  }
+  free_lists_ = std::move(free_lists);
+}
+
+void DiskManager::AddFreePage(page_id_t page_id) {
+  auto &free_list = *free_lists_[static_cast<size_t>(page_id) % free_lists_.size()];
+  std::scoped_lock free_lock(free_list.latch_);
+  free_list.pages_.insert(page_id);
+}
+
+void DiskManager::CheckFormat() {
+  auto &header = GetExtentHeader(0);
+  auto *control = header.Control();
+  if (db_file_size_ == 0) {
+    std::memcpy(control->magic_, FILE_MAGIC, sizeof(FILE_MAGIC));
+    control->format_version_ = FORMAT_VERSION;
+    auto offset = HeaderOffset(0, CONTROL_PAGE);
+    PreparePageWrite(offset);
+    if (WriteBlock(offset, header.Page(CONTROL_PAGE)) && fdatasync(db_fd_) == 0) {
+      return;
+    }
+    LOG_DEBUG("I/O error while creating the db file: %s", strerror(errno));
+  } else if (std::memcmp(control->magic_, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+             control->format_version_ == FORMAT_VERSION) {
+    return;
+  }
+  // No destructor runs for a constructor that throws, so the file is closed here, and nothing is written to it
+  close(db_fd_);
+  db_fd_ = -1;
+  throw Exception("the db file " + file_name_ + " does not have version " + std::to_string(FORMAT_VERSION) +
+                  " of the file format");
+}
+
+auto DiskManager::GetExtentHeader(page_id_t page_id) -> ExtentHeader & {
+  const auto extent = static_cast<size_t>(page_id / PAGES_PER_EXTENT);
+  if (extents_.size() <= extent) {
+    extents_.resize(extent + 1);
+  }
+  return extents_[extent];
+}
+
+void DiskManager::SetAllocated(page_id_t page_id, bool allocated) {
+  const auto bit = page_id % PAGES_PER_EXTENT;
+  auto &header = GetExtentHeader(page_id);
+  auto &byte = header.space_map_[bit / 8];
+  byte = static_cast<char>(allocated ? byte | (1 << (bit % 8)) : byte & ~(1 << (bit % 8)));
+  header.dirty_[SPACE_MAP_PAGE] = true;
+}
+
+auto DiskManager::IsAllocatedLocked(page_id_t page_id) -> bool {
+  const auto extent = static_cast<size_t>(page_id / PAGES_PER_EXTENT);
+  const auto bit = page_id % PAGES_PER_EXTENT;
+  return extent < extents_.size() && (extents_[extent].space_map_[bit / 8] & (1 << (bit % 8))) != 0;
+}
+
+auto DiskManager::AllocatePage(uint32_t num_instances, uint32_t instance_index) -> page_id_t {
+  std::shared_lock lists_lock(free_lists_latch_);
+  while (free_lists_.size() != num_instances) {
+    lists_lock.unlock();
+    SplitFreeLists(num_instances);
+    lists_lock.lock();
+  }
+  page_id_t page_id = INVALID_PAGE_ID;
+  {
+    auto &free_list = *free_lists_[instance_index];
+    std::scoped_lock free_lock(free_list.latch_);
+    if (!free_list.pages_.empty()) {
+      page_id = *free_list.pages_.begin();
+      free_list.pages_.erase(free_list.pages_.begin());
+    }
+  }
+
+  std::scoped_lock space_lock(space_latch_);
+  if (page_id == INVALID_PAGE_ID) {
+    const auto residue = static_cast<uint32_t>(high_water_mark_) % num_instances;
+    page_id = high_water_mark_ + static_cast<page_id_t>((instance_index + num_instances - residue) % num_instances);
+    for (auto skipped = high_water_mark_; skipped < page_id; skipped++) {
+      AddFreePage(skipped);
+    }
+    high_water_mark_ = page_id + 1;
+  }
+  SetAllocated(page_id, true);
+  return page_id;
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::shared_lock lists_lock(free_lists_latch_);
+  std::scoped_lock space_lock(space_latch_);
+  if (page_id < 0 || page_id >= high_water_mark_ || !IsAllocatedLocked(page_id)) {
+    return;
+  }
+  SetAllocated(page_id, false);
+  AddFreePage(page_id);
+}
+
+auto DiskManager::IsAllocated(page_id_t page_id) -> bool {
+  std::scoped_lock space_lock(space_latch_);
+  return page_id >= 0 && IsAllocatedLocked(page_id);
+}
+
+auto DiskManager::GetHighWaterMark() -> page_id_t {
+  std::scoped_lock space_lock(space_latch_);
+  return high_water_mark_;
+}
+
+auto DiskManager::GetNumFreePages() -> size_t {
+  std::shared_lock lists_lock(free_lists_latch_);
+  size_t num_free_pages = 0;
+  for (const auto &free_list : free_lists_) {
+    std::scoped_lock free_lock(free_list->latch_);
+    num_free_pages += free_list->pages_.size();
+  }
+  return num_free_pages;
+}
+
+/**
+ * Give the trailing free pages back to the file system
+ */
+auto DiskManager::ShrinkFile() -> int64_t {
+  std::shared_lock lists_lock(free_lists_latch_);
+  std::scoped_lock space_lock(space_latch_);
+  while (high_water_mark_ > 0) {
+    // A page being allocated is already off its free list, so the loop stops there
+    auto &free_list = *free_lists_[static_cast<size_t>(high_water_mark_ - 1) % free_lists_.size()];
+    std::scoped_lock free_lock(free_list.latch_);
+    if (free_list.pages_.empty() || *free_list.pages_.rbegin() != high_water_mark_ - 1) {
+      break;
+    }
+    free_list.pages_.erase(std::prev(free_list.pages_.end()));
+    high_water_mark_--;
+    // The page is cut off the file, so its old checksum must not be held against it when it is allocated again
+    const auto slot = high_water_mark_ % PAGES_PER_EXTENT;
+    auto &header = GetExtentHeader(high_water_mark_);
+    if (header.checksums_[slot] != 0) {
+      header.checksums_[slot] = 0;
+      header.dirty_[ChecksumPage(slot)] = true;
+    }
+  }
+  // The header of extent 0 stays, since it holds the file format
+  const auto num_extents = static_cast<size_t>((high_water_mark_ + PAGES_PER_EXTENT - 1) / PAGES_PER_EXTENT);
+  extents_.resize(std::max<size_t>(num_extents, 1));
+  if (db_fd_ < 0) {
+    return 0;
+  }
+
+  const int64_t end = high_water_mark_ == 0 ? HeaderOffset(0, CONTROL_PAGE) + BUSTUB_PAGE_SIZE
+                                            : PageOffset(high_water_mark_ - 1) + BUSTUB_PAGE_SIZE;
+  std::scoped_lock growth_lock(db_growth_latch_);
+  const auto file_size = GetFileSize(file_name_);
+  if (file_size <= end) {
+    return 0;
+  }
+  if (ftruncate(db_fd_, end) != 0) {
+    LOG_DEBUG("I/O error while shrinking the db file: %s", strerror(errno));
+    return 0;
+  }
+  db_file_size_.store(end, std::memory_order_release);
+  db_data_size_.store(std::min(db_data_size_.load(), end));
+  return file_size - end;
+}
+
+auto DiskManager::PageChecksum(const char *page_data) -> uint32_t {
+  auto checksum = Crc32c::Value(page_data, BUSTUB_PAGE_SIZE);
+  return checksum == 0 ? 1 : checksum;
+}
+
+auto DiskManager::BeginPageWrite(page_id_t page_id, const char *page_data) -> bool {
+  if (checksum_mode_.load(std::memory_order_relaxed) == ChecksumMode::OFF) {
+    return true;
+  }
+  const auto checksum = PageChecksum(page_data);
+  const auto slot = page_id % PAGES_PER_EXTENT;
+  std::scoped_lock space_lock(space_latch_);
+  pages_being_written_[page_id]++;
+  num_writes_in_flight_.fetch_add(1, std::memory_order_relaxed);
+  corrupt_pages_.erase(page_id);
+  auto &header = GetExtentHeader(page_id);
+  header.writes_in_flight_++;
+  // Rewriting what a page holds already cannot make it mismatch its checksum on disk, even if the write is torn
+  if (header.checksums_[slot] == checksum) {
+    return true;
+  }
+  header.checksums_[slot] = checksum;
+  header.dirty_[ChecksumPage(slot)] = true;
+  header.checksum_seq_ = ++checksum_seq_;
+  return header.marked_;
+}
+
+void DiskManager::FinishPageWrite(page_id_t page_id) {
+  // Nothing to do for a write with checksums off, unless the mode changed while a counted write was in flight
+  if (num_writes_in_flight_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  std::scoped_lock space_lock(space_latch_);
+  auto it = pages_being_written_.find(page_id);
+  if (it == pages_being_written_.end()) {
+    return;
+  }
+  if (--it->second == 0) {
+    pages_being_written_.erase(it);
+  }
+  num_writes_in_flight_.fetch_sub(1, std::memory_order_relaxed);
+  GetExtentHeader(page_id).writes_in_flight_--;
+}
+
+void DiskManager::DropChecksums() {
+  std::scoped_lock sync_lock(sync_latch_);
+  std::vector<size_t> extents;
+  {
+    std::scoped_lock space_lock(space_latch_);
+    for (size_t extent = 0; extent < extents_.size(); extent++) {
+      auto &header = extents_[extent];
+      std::fill(header.checksums_.get(), header.checksums_.get() + PAGES_PER_EXTENT, 0);
+      for (auto i = FIRST_CHECKSUM_PAGE; i < EXTENT_HEADER_PAGES; i++) {
+        header.dirty_[i] = true;
+      }
+      header.checksum_seq_ = ++checksum_seq_;
+      extents.push_back(extent);
+    }
+  }
+  // The old checksums stay on disk until the next sync, and the pages written until then would not match them
+  MarkUnsyncedLocked(extents);
+}
+
+auto DiskManager::GetChecksum(page_id_t page_id) -> uint32_t {
+  const auto extent = static_cast<size_t>(page_id / PAGES_PER_EXTENT);
+  std::scoped_lock space_lock(space_latch_);
+  if (extent >= extents_.size() || pages_being_written_.count(page_id) != 0) {
+    return 0;
+  }
+  return extents_[extent].checksums_[page_id % PAGES_PER_EXTENT];
+}
+
+auto DiskManager::VerifyRead(page_id_t page_id, const char *page_data) -> bool {
+  if (checksum_mode_.load(std::memory_order_relaxed) != ChecksumMode::VERIFY_ON_READ) {
+    return true;
+  }
+  auto checksum = GetChecksum(page_id);
+  if (checksum == 0 || checksum == PageChecksum(page_data)) {
+    return true;
+  }
+  RecordChecksumFailure(page_id);
+  return false;
+}
+
+auto DiskManager::VerifyPage(page_id_t page_id) -> bool {
+  auto page_data = std::make_unique<char[]>(BUSTUB_PAGE_SIZE);
+  // A write of the page may land between the read and the lookup of the checksum, so a mismatch only counts if a
+  // second read confirms it
+  for (int attempt = 0; attempt < 2; attempt++) {
+    ReadBlock(PageOffset(page_id), page_data.get());
+    auto checksum = GetChecksum(page_id);
+    if (checksum == 0 || checksum == PageChecksum(page_data.get())) {
+      return true;
+    }
+  }
+  RecordChecksumFailure(page_id);
+  return false;
+}
+
+void DiskManager::RecordChecksumFailure(page_id_t page_id) {
+  LOG_ERROR("checksum mismatch on page %d", page_id);
+  num_checksum_failures_.fetch_add(1, std::memory_order_relaxed);
+  std::scoped_lock space_lock(space_latch_);
+  corrupt_pages_.insert(page_id);
+}
+
+auto DiskManager::GetCorruptPages() -> std::vector<page_id_t> {
+  std::scoped_lock space_lock(space_latch_);
+  return {corrupt_pages_.begin(), corrupt_pages_.end()};
+}
+
+void DiskManager::SetChecksumMode(ChecksumMode mode) {
+  if (checksum_mode_.exchange(mode, std::memory_order_relaxed) != ChecksumMode::OFF && mode == ChecksumMode::OFF) {
+    DropChecksums();
+  }
+  if (mode != ChecksumMode::BACKGROUND_SCRUB) {
+    StopScrubber();
+    return;
+  }
+  std::scoped_lock scrubber_lock(scrubber_latch_);
+  if (!scrubbing_) {
+    if (scrubber_thread_.joinable()) {
+      scrubber_thread_.join();
+    }
+    scrubbing_ = true;
+    scrubber_thread_ = std::thread(&DiskManager::RunScrubber, this);
+  }
+}
+
+void DiskManager::StopScrubber() {
+  {
+    std::scoped_lock scrubber_lock(scrubber_latch_);
+    scrubbing_ = false;
+  }
+  scrubber_cv_.notify_all();
+  if (scrubber_thread_.joinable()) {
+    scrubber_thread_.join();
+  }
+}
+
+/**
+ * Verify the allocated pages a batch at a time, over and over, pausing between batches to leave the disk to the reads
+ * and writes of the buffer pool
+ */
+void DiskManager::RunScrubber() {
+  page_id_t next_page_id = 0;
+  std::unique_lock scrubber_lock(scrubber_latch_);
+  while (scrubbing_) {
+    scrubber_lock.unlock();
+    auto high_water_mark = GetHighWaterMark();
+    for (size_t scrubbed = 0; scrubbed < SCRUB_BATCH_SIZE && next_page_id < high_water_mark; next_page_id++) {
+      if (IsAllocated(next_page_id)) {
+        VerifyPage(next_page_id);
+        pages_scrubbed_.fetch_add(1, std::memory_order_relaxed);
+        scrubbed++;
+      }
+    }
+    if (next_page_id >= high_water_mark) {
+      next_page_id = 0;
+    }
+    scrubber_lock.lock();
+    scrubber_cv_.wait_for(scrubber_lock, SCRUB_INTERVAL, [&] { return !scrubbing_; });
+  }
+}
+
+/**
+ * Perform the requests synchronously, in order
+ */
+void DiskManager::Schedule(std::vector<DiskRequest> *requests) {
+  for (auto &request : *requests) {
+    if (request.is_write_) {
+      WritePage(request.page_id_, request.data_);
+    } else {
+      ReadPage(request.page_id_, request.data_);
+    }
+    request.callback_.set_value(true);
+  }
+}
+
+auto DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<bool> {
+  std::vector<DiskRequest> requests(1);
+  requests[0] = {false, page_data, page_id, {}};
+  auto future = requests[0].callback_.get_future();
+  Schedule(&requests);
+  return future;
+}
+
+auto DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<bool> {
+  std::vector<DiskRequest> requests(1);
+  requests[0] = {true, const_cast<char *>(page_data), page_id, {}};  // NOLINT
+  auto future = requests[0].callback_.get_future();
+  Schedule(&requests);
+  return future;
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -161,7 +735,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
+auto DiskManager::ReadLog(char *log_data, int size, int64_t offset) -> bool {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
@@ -192,7 +766,12 @@ auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
 /**
  * Returns number of Writes made so far
  */
-auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
+auto DiskManager::GetNumWrites() const -> int { return num_writes_.load(std::memory_order_relaxed); }
+
+/**
+ * Returns number of syncs of the db file made so far
+ */
+auto DiskManager::GetNumSyncs() const -> int { return num_syncs_.load(std::memory_order_relaxed); }
 
 /**
  * Returns true if the log is currently being flushed
@@ -202,10 +781,10 @@ auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-auto DiskManager::GetFileSize(const std::string &file_name) -> int {
+auto DiskManager::GetFileSize(const std::string &file_name) -> int64_t {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -32,17 +35,18 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_P
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  root_page_id_latch_.RLock();
-  auto leaf_page = FindLeaf(key, Operation::SEARCH, transaction);
-  auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  // The leaf is read from a validated copy too, so a search of pages in the pool neither latches nor pins anything.
+  alignas(std::max_align_t) char leaf_copy[BUSTUB_PAGE_SIZE];
+  Page *leaf_page;
+  uint64_t leaf_version;
+  while (!FindLeafOptimistic(key, false, false, leaf_copy, &leaf_page, &leaf_version)) {
+  }
+  if (leaf_page == nullptr) {
+    return false;
+  }
 
   ValueType value;
-  auto key_exists = leaf_node->Lookup(key, &value, comparator_);
-
-  leaf_page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
-
-  if (!key_exists) {
+  if (!reinterpret_cast<LeafPage *>(leaf_copy)->Lookup(key, &value, comparator_)) {
     return false;
   }
 
@@ -74,26 +78,29 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
-  auto *new_page = buffer_pool_manager_->NewPage(&root_page_id_);
+  BeginRootChange();
+  page_id_t root_page_id;
+  auto new_guard = buffer_pool_manager_->NewPageGuarded(&root_page_id);
 
-  if (new_page == nullptr) {
+  if (!new_guard.IsValid()) {
+    EndRootChange();
     throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
   }
+  root_page_id_.store(root_page_id, std::memory_order_relaxed);
 
-  auto *leaf = reinterpret_cast<LeafPage *>(new_page->GetData());
-  leaf->Init(root_page_id_, INVALID_PAGE_ID, leaf_max_size_);
+  auto *leaf = new_guard.template AsMut<LeafPage>();
+  leaf->Init(root_page_id, INVALID_PAGE_ID, leaf_max_size_);
 
   leaf->Insert(key, value, comparator_);
-
-  buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
+  EndRootChange();
 
   // UpdateRootPageId(1);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  auto leaf_page = FindLeaf(key, Operation::INSERT, transaction);
-  auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  WritePageGuard leaf_guard(buffer_pool_manager_, FindLeaf(key, Operation::INSERT, transaction));
+  auto *leaf_node = leaf_guard.AsMut<LeafPage>();
 
   auto original_size = leaf_node->GetSize();
   auto updated_size = leaf_node->Insert(key, value, comparator_);
@@ -101,108 +108,105 @@ auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
   // Duplicate key
   if (updated_size == original_size) {
     ReleaseLatchFromQueue(transaction);
-    leaf_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
     return false;
   }
 
   // Leaf node is not full
   if (updated_size < leaf_max_size_) {
     ReleaseLatchFromQueue(transaction);
-    leaf_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
     return true;
   }
 
   // Leaf node is full, need to split
-  auto *split_leaf_node = Split(leaf_node);
+  auto split_guard = Split(leaf_node);
+  auto *split_leaf_node = split_guard.template AsMut<LeafPage>();
   split_leaf_node->SetNextPageId(leaf_node->GetNextPageId());
   leaf_node->SetNextPageId(split_leaf_node->GetPageId());
 
   auto rising_key = split_leaf_node->KeyAt(0);
   InsertIntoParent(leaf_node, rising_key, split_leaf_node, transaction);
-
-  leaf_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
-  buffer_pool_manager_->UnpinPage(split_leaf_node->GetPageId(), true);
   return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-auto BPLUSTREE_TYPE::Split(N *node) -> N * {
+auto BPLUSTREE_TYPE::Split(N *node) -> BasicPageGuard {
   page_id_t new_page_id;
-  auto *new_page = buffer_pool_manager_->NewPage(&new_page_id);
+  auto new_guard = buffer_pool_manager_->NewPageGuarded(&new_page_id);
 
-  if (new_page == nullptr) {
+  if (!new_guard.IsValid()) {
     throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
   }
 
-  N *new_node = reinterpret_cast<N *>(new_page->GetData());
+  N *new_node = new_guard.template AsMut<N>();
   new_node->SetPageType(node->GetPageType());
 
   if (node->IsLeafPage()) {
     auto *leaf = reinterpret_cast<LeafPage *>(node);
     auto *new_leaf = reinterpret_cast<LeafPage *>(new_node);
 
-    new_leaf->Init(new_page->GetPageId(), node->GetParentPageId(), leaf_max_size_);
+    new_leaf->Init(new_page_id, node->GetParentPageId(), leaf_max_size_);
     leaf->MoveHalfTo(new_leaf);
   } else {
     auto *internal = reinterpret_cast<InternalPage *>(node);
     auto *new_internal = reinterpret_cast<InternalPage *>(new_node);
 
-    new_internal->Init(new_page->GetPageId(), node->GetParentPageId(), internal_max_size_);
+    new_internal->Init(new_page_id, node->GetParentPageId(), internal_max_size_);
     internal->MoveHalfTo(new_internal, buffer_pool_manager_);
   }
 
-  return new_node;
+  return new_guard;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
                                       Transaction *transaction) {
   if (old_node->IsRootPage()) {
-    auto *new_page = buffer_pool_manager_->NewPage(&root_page_id_);
+    BeginRootChange();
+    page_id_t root_page_id;
+    auto new_guard = buffer_pool_manager_->NewPageGuarded(&root_page_id);
 
-    if (new_page == nullptr) {
+    if (!new_guard.IsValid()) {
+      EndRootChange();
       throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
     }
+    root_page_id_.store(root_page_id, std::memory_order_relaxed);
 
-    auto *new_root = reinterpret_cast<InternalPage *>(new_page->GetData());
-    new_root->Init(root_page_id_, INVALID_PAGE_ID, internal_max_size_);
+    auto *new_root = new_guard.template AsMut<InternalPage>();
+    new_root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
 
     new_root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    EndRootChange();
 
     old_node->SetParentPageId(new_root->GetPageId());
     new_node->SetParentPageId(new_root->GetPageId());
 
-    buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
+    new_guard.Drop();
 
     UpdateRootPageId(0);
 
     ReleaseLatchFromQueue(transaction);
     return;
   }
-  auto *parent_page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
-  auto *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  // The parent is already write latched through the page set, so only its pin is needed here.
+  auto parent_guard = buffer_pool_manager_->FetchPageBasic(old_node->GetParentPageId());
+  auto *parent_node = parent_guard.template AsMut<InternalPage>();
 
   if (parent_node->GetSize() < internal_max_size_) {
     parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
     ReleaseLatchFromQueue(transaction);
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
     return;
   }
   auto *temporary_memory = new char[INTERNAL_PAGE_HEADER_SIZE + sizeof(MappingType) * (parent_node->GetSize() + 1)];
   auto *copied_parent_node = reinterpret_cast<InternalPage *>(temporary_memory);
-  std::memcpy(temporary_memory, parent_page->GetData(), INTERNAL_PAGE_HEADER_SIZE + sizeof(MappingType) * (parent_node->GetSize()));
+  std::memcpy(temporary_memory, parent_node, INTERNAL_PAGE_HEADER_SIZE + sizeof(MappingType) * (parent_node->GetSize()));
   copied_parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-  auto *split_parent_sibling_node = Split(copied_parent_node);
+  auto split_guard = Split(copied_parent_node);
+  auto *split_parent_sibling_node = split_guard.template AsMut<InternalPage>();
   KeyType new_key = split_parent_sibling_node->KeyAt(0);
-  std::memcpy(parent_page->GetData(), temporary_memory,
+  std::memcpy(reinterpret_cast<char *>(parent_node), temporary_memory,
               INTERNAL_PAGE_HEADER_SIZE + sizeof(MappingType) * copied_parent_node->GetMinSize());
   InsertIntoParent(parent_node, new_key, split_parent_sibling_node, transaction);
-  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-  buffer_pool_manager_->UnpinPage(split_parent_sibling_node->GetPageId(), true);
   delete[] temporary_memory;
 }
 
@@ -226,24 +230,22 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
     return;
   }
 
-  auto leaf_page = FindLeaf(key, Operation::DELETE, transaction);
-  auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  WritePageGuard leaf_guard(buffer_pool_manager_, FindLeaf(key, Operation::DELETE, transaction));
+  auto *leaf_node = leaf_guard.AsMut<LeafPage>();
 
   if (leaf_node->GetSize() == leaf_node->RemoveAndDeleteRecord(key, comparator_)) {
     ReleaseLatchFromQueue(transaction);
-    leaf_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
     return;
   }
 
   auto node_should_delete = CoalesceOrRedistribute(leaf_node, transaction);
-  leaf_page->WUnlatch();
 
   if (node_should_delete) {
     transaction->AddIntoDeletedPageSet(leaf_node->GetPageId());
   }
 
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
+  // The leaf may be on the deleted page set, it has to be unpinned before the pages are deleted.
+  leaf_guard.Drop();
 
   std::for_each(transaction->GetDeletedPageSet()->begin(), transaction->GetDeletedPageSet()->end(),
                 [&bpm = buffer_pool_manager_](const page_id_t page_id) { bpm->DeletePage(page_id); });
@@ -264,23 +266,19 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
     return false;
   }
 
-  auto parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  auto *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  // The parent is already write latched through the page set, so only its pin is needed here.
+  auto parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+  auto *parent_node = parent_guard.template AsMut<InternalPage>();
   auto index_in_parent = parent_node->ValueIndex(node->GetPageId());
 
   if (index_in_parent > 0) {
-    auto sibling_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(index_in_parent - 1));
-    sibling_page->WLatch();
-    N *sibling_node = reinterpret_cast<N *>(sibling_page->GetData());
+    auto sibling_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(index_in_parent - 1));
+    N *sibling_node = sibling_guard.template AsMut<N>();
 
     if (sibling_node->GetSize() > sibling_node->GetMinSize()) {
       Redistribute(sibling_node, node, parent_node, index_in_parent, true);
 
       ReleaseLatchFromQueue(transaction);
-
-      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-      sibling_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
       return false;
     }
 
@@ -290,25 +288,17 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
     if (parent_node_should_delete) {
       transaction->AddIntoDeletedPageSet(parent_node->GetPageId());
     }
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-    sibling_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
     return true;
   }
 
   if (index_in_parent != parent_node->GetSize() - 1) {
-    auto sibling_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(index_in_parent + 1));
-    sibling_page->WLatch();
-    N *sibling_node = reinterpret_cast<N *>(sibling_page->GetData());
+    auto sibling_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(index_in_parent + 1));
+    N *sibling_node = sibling_guard.template AsMut<N>();
 
     if (sibling_node->GetSize() > sibling_node->GetMinSize()) {
       Redistribute(sibling_node, node, parent_node, index_in_parent, false);
 
       ReleaseLatchFromQueue(transaction);
-
-      buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-      sibling_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
       return false;
     }
     // Coalesce
@@ -318,9 +308,6 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
     if (parent_node_should_delete) {
       transaction->AddIntoDeletedPageSet(parent_node->GetPageId());
     }
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-    sibling_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
     return false;
   }
 
@@ -383,20 +370,22 @@ INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool {
   if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
     auto *root_node = reinterpret_cast<InternalPage *>(old_root_node);
-    auto only_child_page = buffer_pool_manager_->FetchPage(root_node->ValueAt(0));
-    auto *only_child_node = reinterpret_cast<BPlusTreePage *>(only_child_page->GetData());
+    auto only_child_guard = buffer_pool_manager_->FetchPageBasic(root_node->ValueAt(0));
+    auto *only_child_node = only_child_guard.template AsMut<BPlusTreePage>();
     only_child_node->SetParentPageId(INVALID_PAGE_ID);
 
-    root_page_id_ = only_child_node->GetPageId();
+    BeginRootChange();
+    root_page_id_.store(only_child_node->GetPageId(), std::memory_order_relaxed);
+    EndRootChange();
 
     UpdateRootPageId(0);
-
-    buffer_pool_manager_->UnpinPage(only_child_page->GetPageId(), true);
     return true;
   }
 
   if (old_root_node->IsLeafPage() && old_root_node->GetSize() == 0) {
-    root_page_id_ = INVALID_PAGE_ID;
+    BeginRootChange();
+    root_page_id_.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+    EndRootChange();
     return true;
   }
   return false;
@@ -414,7 +403,6 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
   if (root_page_id_ == INVALID_PAGE_ID) {
     return INDEXITERATOR_TYPE(nullptr, nullptr);
   }
-  root_page_id_latch_.RLock();
   auto leftmost_page = FindLeaf(KeyType(), Operation::SEARCH, nullptr, true);
   return INDEXITERATOR_TYPE(buffer_pool_manager_, leftmost_page, 0);
 }
@@ -429,8 +417,10 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
   if (root_page_id_ == INVALID_PAGE_ID) {
     return INDEXITERATOR_TYPE(nullptr, nullptr);
   }
-  root_page_id_latch_.RLock();
   auto leaf_page = FindLeaf(key, Operation::SEARCH);
+  if (leaf_page == nullptr) {
+    return INDEXITERATOR_TYPE(nullptr, nullptr);
+  }
   auto *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
   auto index_in_node = leaf_node->KeyIndex(key, comparator_);
   return INDEXITERATOR_TYPE(buffer_pool_manager_, leaf_page, index_in_node);
@@ -446,8 +436,10 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
   if (root_page_id_ == INVALID_PAGE_ID) {
     return INDEXITERATOR_TYPE(nullptr, nullptr);
   }
-  root_page_id_latch_.RLock();
   auto rightmost_page = FindLeaf(KeyType(), Operation::SEARCH, nullptr, false, true);
+  if (rightmost_page == nullptr) {
+    return INDEXITERATOR_TYPE(nullptr, nullptr);
+  }
   auto *leaf_node = reinterpret_cast<LeafPage *>(rightmost_page->GetData());
   return INDEXITERATOR_TYPE(buffer_pool_manager_, rightmost_page, leaf_node->GetSize());
 }
@@ -457,46 +449,59 @@ auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, Operation operation, Transacti
                               bool rightMost) -> Page * {
   assert(operation == Operation::SEARCH ? !(leftMost && rightMost) : transaction != nullptr);
 
+  if (operation == Operation::SEARCH) {
+    while (true) {
+      Page *leaf_page;
+      uint64_t leaf_version;
+      if (!FindLeafOptimistic(key, leftMost, rightMost, nullptr, &leaf_page, &leaf_version)) {
+        continue;
+      }
+      if (leaf_page == nullptr) {
+        return nullptr;
+      }
+      leaf_page->RLatch();
+      if (leaf_page->ValidateOptimisticLatch(leaf_version)) {
+        return leaf_page;
+      }
+      leaf_page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+    }
+  }
+
   assert(root_page_id_ != INVALID_PAGE_ID);
   auto page = buffer_pool_manager_->FetchPage(root_page_id_);
+  page->SetPageType(PageType::INDEX);
   auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  if (operation == Operation::SEARCH) {
-    root_page_id_latch_.RUnlock();
-    page->RLatch();
-  } else {
-    page->WLatch();
-    if (operation == Operation::DELETE && node->GetSize() > 2) {
-      ReleaseLatchFromQueue(transaction);
-    }
-    if (operation == Operation::INSERT && node->IsLeafPage() && node->GetSize() < node->GetMaxSize() - 1) {
-      ReleaseLatchFromQueue(transaction);
-    }
-    if (operation == Operation::INSERT && !node->IsLeafPage() && node->GetSize() < node->GetMaxSize()) {
-      ReleaseLatchFromQueue(transaction);
-    }
+  page->WLatch();
+  if (operation == Operation::DELETE && node->GetSize() > 2) {
+    ReleaseLatchFromQueue(transaction);
+  }
+  if (operation == Operation::INSERT && node->IsLeafPage() && node->GetSize() < node->GetMaxSize() - 1) {
+    ReleaseLatchFromQueue(transaction);
+  }
+  if (operation == Operation::INSERT && !node->IsLeafPage() && node->GetSize() < node->GetMaxSize()) {
+    ReleaseLatchFromQueue(transaction);
   }
 
   while (!node->IsLeafPage()) {
     auto *internal_node = reinterpret_cast<InternalPage *>(node);
 
-    page_id_t child_node_page_id;
+    int child_slot;
     if (leftMost) {
-      child_node_page_id = internal_node->ValueAt(0);
+      child_slot = 0;
     } else if (rightMost) {
-      child_node_page_id = internal_node->ValueAt(internal_node->GetSize() - 1);
+      child_slot = internal_node->GetSize() - 1;
     } else {
-      child_node_page_id = internal_node->Lookup(key, comparator_);
+      child_slot = internal_node->LookupSlot(key, comparator_);
     }
+    auto child_node_page_id = internal_node->ValueAt(child_slot);
     assert(child_node_page_id > 0);
 
-    auto child_page = buffer_pool_manager_->FetchPage(child_node_page_id);
+    auto child_page = buffer_pool_manager_->FetchChildPage(page, child_slot, child_node_page_id);
+    child_page->SetPageType(PageType::INDEX);
     auto child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
 
-    if (operation == Operation::SEARCH) {
-      child_page->RLatch();
-      page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    } else if (operation == Operation::INSERT) {
+    if (operation == Operation::INSERT) {
       child_page->WLatch();
       transaction->AddIntoPageSet(page);
 
@@ -524,6 +529,157 @@ auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, Operation operation, Transacti
   return page;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, bool leftMost, bool rightMost, char *leaf_copy,
+                                        Page **leaf_page, uint64_t *leaf_version) -> bool {
+  alignas(std::max_align_t) char node_copy[BUSTUB_PAGE_SIZE];
+  char *copy = leaf_copy != nullptr ? leaf_copy : node_copy;
+
+  auto root_version = root_version_.load(std::memory_order_acquire);
+  if ((root_version & 1) != 0) {
+    std::this_thread::yield();
+    return false;
+  }
+  page_id_t page_id = root_page_id_.load(std::memory_order_relaxed);
+  if (page_id == INVALID_PAGE_ID) {
+    *leaf_page = nullptr;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return root_version_.load(std::memory_order_relaxed) == root_version;
+  }
+
+  uint64_t version;
+  bool pinned;
+  auto *page = FindNodeOptimistic(nullptr, 0, page_id, &version, &pinned);
+  Page *parent = nullptr;
+  int parent_slot = 0;
+  // A node that had to be fetched stays pinned until its child is found. Pinless reads leave no history in the
+  // replacer, so the fetch of the child would otherwise evict it first, and every retry would do the same.
+  auto unpin = [&] {
+    if (pinned) {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+    }
+  };
+  while (true) {
+    if (page == nullptr) {
+      return false;
+    }
+    CopyNode(page, copy);
+    if (!page->ValidateOptimisticLatch(version)) {
+      unpin();
+      return false;
+    }
+    // The page may have stopped being the root before its version was taken, e.g. after a split that is done by now.
+    if (parent == nullptr) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (root_version_.load(std::memory_order_relaxed) != root_version) {
+        unpin();
+        return false;
+      }
+    }
+    auto *node = reinterpret_cast<BPlusTreePage *>(copy);
+    if (node->IsLeafPage()) {
+      break;
+    }
+
+    auto *internal_node = reinterpret_cast<InternalPage *>(node);
+    int child_slot;
+    if (leftMost) {
+      child_slot = 0;
+    } else if (rightMost) {
+      child_slot = internal_node->GetSize() - 1;
+    } else {
+      child_slot = internal_node->LookupSlot(key, comparator_);
+    }
+    auto child_page_id = internal_node->ValueAt(child_slot);
+    uint64_t child_version;
+    bool child_pinned;
+    auto *child_page = FindNodeOptimistic(page, child_slot, child_page_id, &child_version, &child_pinned);
+    // A writer may have moved the key out of the child between the copy and the version of the child.
+    bool parent_valid = page->ValidateOptimisticLatch(version);
+    unpin();
+    if (!parent_valid) {
+      if (child_pinned) {
+        buffer_pool_manager_->UnpinPage(child_page_id, false);
+      }
+      return false;
+    }
+
+    parent = page;
+    parent_slot = child_slot;
+    page = child_page;
+    page_id = child_page_id;
+    version = child_version;
+    pinned = child_pinned;
+  }
+
+  if (leaf_copy != nullptr) {
+    unpin();
+  } else if (!pinned) {
+    // The caller reads the leaf in place, so it needs a pin on the very frame that was validated.
+    auto *pinned_page = parent == nullptr ? buffer_pool_manager_->FetchPage(page_id)
+                                          : buffer_pool_manager_->FetchChildPage(parent, parent_slot, page_id);
+    if (pinned_page != page || !page->ValidateOptimisticLatch(version)) {
+      if (pinned_page != nullptr) {
+        buffer_pool_manager_->UnpinPage(page_id, false);
+      }
+      return false;
+    }
+  }
+  *leaf_page = page;
+  *leaf_version = version;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindNodeOptimistic(Page *parent, int slot, page_id_t page_id, uint64_t *version, bool *pinned)
+    -> Page * {
+  *pinned = false;
+  if (parent == nullptr) {
+    auto *root_page = root_frame_.load(std::memory_order_relaxed);
+    if (root_page != nullptr && root_page->OptimisticLatchFrame(page_id, version)) {
+      return root_page;
+    }
+  } else if (auto *child_page = buffer_pool_manager_->PeekChildPage(parent, slot, page_id, version);
+             child_page != nullptr) {
+    return child_page;
+  }
+
+  // Not resident where we last saw it: fetch it, which also refreshes the swip
+  auto *page = parent == nullptr ? buffer_pool_manager_->FetchPage(page_id)
+                                 : buffer_pool_manager_->FetchChildPage(parent, slot, page_id);
+  if (page == nullptr) {
+    return nullptr;
+  }
+  *pinned = true;
+  page->SetPageType(PageType::INDEX);
+  *version = page->OptimisticLatch();
+  if (parent == nullptr) {
+    root_frame_.store(page, std::memory_order_relaxed);
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CopyNode(Page *page, char *copy) {
+  const auto *node = reinterpret_cast<const BPlusTreePage *>(page->GetData());
+  // The size is only trusted to be somewhere in the page. One more entry covers the padding before the entries.
+  auto size = static_cast<size_t>(std::max(node->GetSize(), 0)) + 1;
+  auto bytes = node->IsLeafPage() ? LEAF_PAGE_HEADER_SIZE + size * sizeof(std::pair<KeyType, ValueType>)
+                                  : INTERNAL_PAGE_HEADER_SIZE + size * sizeof(std::pair<KeyType, page_id_t>);
+  std::memcpy(copy, page->GetData(), std::min<size_t>(bytes, BUSTUB_PAGE_SIZE));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BeginRootChange() {
+  root_version_.store(root_version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::EndRootChange() {
+  root_version_.store(root_version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::ReleaseLatchFromQueue(Transaction *transaction) {
   while (!transaction->GetPageSet()->empty()) {
@@ -562,6 +718,7 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t {
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  header_page->SetPageType(PageType::HEADER);
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header page
     header_page->InsertRecord(index_name_, root_page_id_);
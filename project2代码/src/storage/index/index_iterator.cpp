@@ -14,9 +14,10 @@ namespace bustub {
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, Page *page, int index)
-    : buffer_pool_manager_(bpm), page_(page), index_(index) {
+    : buffer_pool_manager_(bpm), page_(page), index_(index), read_ahead_(bpm, &NextLeafPageId) {
   if (page != nullptr) {
     leaf_ = reinterpret_cast<LeafPage *>(page->GetData());
+    read_ahead_.OnPageAccess(page->GetPageId(), leaf_->GetNextPageId());
   } else {
     leaf_ = nullptr;
   }
@@ -30,6 +31,11 @@ INDEXITERATOR_TYPE::~IndexIterator() {
   }
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::NextLeafPageId(Page *page) -> page_id_t {
+  return reinterpret_cast<LeafPage *>(page->GetData())->GetNextPageId();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::IsEnd() -> bool {
   return leaf_ == nullptr || (leaf_->GetNextPageId() == INVALID_PAGE_ID && index_ == leaf_->GetSize());
@@ -42,6 +48,7 @@ INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
   if (index_ == leaf_->GetSize() - 1 && leaf_->GetNextPageId() != INVALID_PAGE_ID) {
     auto next_page = buffer_pool_manager_->FetchPage(leaf_->GetNextPageId());
+    next_page->SetPageType(PageType::INDEX);
 
     next_page->RLatch();
     page_->RUnlatch();
@@ -50,6 +57,7 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
     page_ = next_page;
     leaf_ = reinterpret_cast<LeafPage *>(page_->GetData());
     index_ = 0;
+    read_ahead_.OnPageAccess(page_->GetPageId(), leaf_->GetNextPageId());
   } else {
     index_++;
   }
@@ -60,16 +60,21 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const ->
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType {
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupSlot(const KeyType &key, const KeyComparator &comparator) const -> int {
   auto target = std::lower_bound(array_ + 1, array_ + GetSize(), key,
                                  [&comparator](const auto &pair, auto k) { return comparator(pair.first, k) < 0; });
   if (target == array_ + GetSize()) {
-    return ValueAt(GetSize() - 1);
+    return GetSize() - 1;
   }
   if (comparator(target->first, key) == 0) {
-    return target->second;
+    return static_cast<int>(std::distance(array_, target));
   }
-  return std::prev(target)->second;
+  return static_cast<int>(std::distance(array_, target)) - 1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType {
+  return ValueAt(LookupSlot(key, comparator));
 }
 
 INDEX_TEMPLATE_ARGUMENTS
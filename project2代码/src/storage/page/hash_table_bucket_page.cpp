@@ -11,71 +11,195 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/page/hash_table_bucket_page.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
 #include "common/logger.h"
 #include "common/util/hash_util.h"
+#include "murmur3/MurmurHash3.h"
 #include "storage/index/generic_key.h"
 #include "storage/index/hash_comparator.h"
 #include "storage/table/tmp_tuple.h"
 
 namespace bustub {
 
+namespace {
+
+/** Seeds the fingerprint hash apart from HashFunction, whose low bits are the same for every key of a bucket. */
+constexpr uint32_t FINGERPRINT_SEED = 0x9E3779B9;
+
+#if defined(__AVX2__)
+constexpr uint32_t FINGERPRINT_GROUP_SIZE = 32;
+using GroupMask = uint32_t;
+
+/** @return a mask with bit i set if fingerprints[i] == fingerprint */
+inline auto MatchFingerprints(const uint8_t *fingerprints, uint8_t fingerprint) -> GroupMask {
+  auto group = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fingerprints));
+  auto needle = _mm256_set1_epi8(static_cast<char>(fingerprint));
+  return static_cast<GroupMask>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(group, needle)));
+}
+#elif defined(__SSE2__)
+constexpr uint32_t FINGERPRINT_GROUP_SIZE = 16;
+using GroupMask = uint16_t;
+
+/** @return a mask with bit i set if fingerprints[i] == fingerprint */
+inline auto MatchFingerprints(const uint8_t *fingerprints, uint8_t fingerprint) -> GroupMask {
+  auto group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints));
+  auto needle = _mm_set1_epi8(static_cast<char>(fingerprint));
+  return static_cast<GroupMask>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, needle)));
+}
+#endif
+
+}  // namespace
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool {
+auto HASH_TABLE_BUCKET_TYPE::Fingerprint(const KeyType &key) -> uint8_t {
+  auto hash = murmur3::MurmurHash3_x86_32(reinterpret_cast<const void *>(&key), sizeof(KeyType), FINGERPRINT_SEED);
+  return static_cast<uint8_t>(hash >> 24);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visitor>
+auto HASH_TABLE_BUCKET_TYPE::ProbeFingerprint(uint8_t fingerprint, Visitor &&visit) const -> bool {
+  // Slots are taken in order, so the first slot that was never occupied ends the probe.
+  uint32_t bucket_idx = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+  static_assert(FINGERPRINT_GROUP_SIZE % 8 == 0, "a group must start at a byte of the bitmaps");
+  for (; bucket_idx + FINGERPRINT_GROUP_SIZE <= BUCKET_ARRAY_SIZE && IsOccupied(bucket_idx);
+       bucket_idx += FINGERPRINT_GROUP_SIZE) {
+    // Bit i of the bitmap word is slot bucket_idx + i on a little-endian machine, same as in the match mask.
+    GroupMask readable;
+    std::memcpy(&readable, &readable_[bucket_idx / 8], sizeof(GroupMask));
+    uint32_t matches = MatchFingerprints(&fingerprints_[bucket_idx], fingerprint) & readable;
+    for (; matches != 0; matches &= matches - 1) {
+      if (visit(bucket_idx + __builtin_ctz(matches))) {
+        return true;
+      }
+    }
+  }
+#endif
+  for (; bucket_idx < BUCKET_ARRAY_SIZE && IsOccupied(bucket_idx); bucket_idx++) {
+    if (IsReadable(bucket_idx) && fingerprints_[bucket_idx] == fingerprint && visit(bucket_idx)) {
+      return true;
+    }
+  }
   return false;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) const -> bool {
+  bool found = false;
+  ProbeFingerprint(Fingerprint(key), [&](uint32_t bucket_idx) {
+    if (cmp(key, array_[bucket_idx].first) == 0) {
+      result->push_back(array_[bucket_idx].second);
+      found = true;
+    }
+    return false;
+  });
+  return found;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool {
+  static_assert(sizeof(HASH_TABLE_BUCKET_TYPE) + (BUCKET_ARRAY_SIZE - 1) * sizeof(MappingType) <= BUSTUB_PAGE_SIZE,
+                "a bucket must fit into a page");
+  auto fingerprint = Fingerprint(key);
+  if (ProbeFingerprint(fingerprint, [&](uint32_t bucket_idx) {
+        return cmp(key, array_[bucket_idx].first) == 0 && value == array_[bucket_idx].second;
+      })) {
+    return false;
+  }
+
+  // The pair goes into the first slot that is not readable: a tombstone, or else the first slot never occupied.
+  uint32_t free_idx = BUCKET_ARRAY_SIZE;
+  for (uint32_t byte_idx = 0; byte_idx < std::size(readable_); byte_idx++) {
+    auto free_bits = static_cast<uint8_t>(~readable_[byte_idx]);
+    if (free_bits != 0) {
+      free_idx = byte_idx * 8 + __builtin_ctz(free_bits);
+      break;
+    }
+  }
+  if (free_idx >= BUCKET_ARRAY_SIZE) {
+    return false;
+  }
+  array_[free_idx] = MappingType(key, value);
+  fingerprints_[free_idx] = fingerprint;
+  SetOccupied(free_idx);
+  SetReadable(free_idx);
   return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) -> bool {
-  return false;
+  return ProbeFingerprint(Fingerprint(key), [&](uint32_t bucket_idx) {
+    if (cmp(key, array_[bucket_idx].first) == 0 && value == array_[bucket_idx].second) {
+      RemoveAt(bucket_idx);
+      return true;
+    }
+    return false;
+  });
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::KeyAt(uint32_t bucket_idx) const -> KeyType {
-  return {};
+  return array_[bucket_idx].first;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::ValueAt(uint32_t bucket_idx) const -> ValueType {
-  return {};
+  return array_[bucket_idx].second;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
+  readable_[bucket_idx / 8] = static_cast<char>(readable_[bucket_idx / 8] & ~(1 << (bucket_idx % 8)));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsOccupied(uint32_t bucket_idx) const -> bool {
-  return false;
+  return (occupied_[bucket_idx / 8] & (1 << (bucket_idx % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {
+  occupied_[bucket_idx / 8] = static_cast<char>(occupied_[bucket_idx / 8] | (1 << (bucket_idx % 8)));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsReadable(uint32_t bucket_idx) const -> bool {
-  return false;
+  return (readable_[bucket_idx / 8] & (1 << (bucket_idx % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {
+  readable_[bucket_idx / 8] = static_cast<char>(readable_[bucket_idx / 8] | (1 << (bucket_idx % 8)));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::IsFull() -> bool {
-  return false;
+auto HASH_TABLE_BUCKET_TYPE::IsFull() const -> bool {
+  return NumReadable() == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::NumReadable() -> uint32_t {
-  return 0;
+auto HASH_TABLE_BUCKET_TYPE::NumReadable() const -> uint32_t {
+  uint32_t num_readable = 0;
+  for (auto byte : readable_) {
+    num_readable += __builtin_popcount(static_cast<uint8_t>(byte));
+  }
+  return num_readable;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::IsEmpty() -> bool {
-  return false;
+auto HASH_TABLE_BUCKET_TYPE::IsEmpty() const -> bool {
+  return std::all_of(std::begin(readable_), std::end(readable_), [](char byte) { return byte == 0; });
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
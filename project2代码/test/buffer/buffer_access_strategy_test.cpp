@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+/** An in-memory disk manager that counts reads. */
+class CountingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    reads_++;
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  std::atomic<int> reads_{0};
+};
+
+/** Allocate num_pages pages and write them straight to disk, so that they exist on disk only. */
+static auto CreatePagesOnDisk(DiskManager *disk_manager, size_t num_pages) -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  for (size_t i = 0; i < num_pages; i++) {
+    auto page_id = disk_manager->AllocatePage();
+    snprintf(data, BUSTUB_PAGE_SIZE, "page %d", page_id);
+    disk_manager->WritePage(page_id, data);
+    page_ids.push_back(page_id);
+  }
+  return page_ids;
+}
+
+/** Fetch every page like a TableIterator does: once per tuple on the page. */
+static void Scan(BufferPoolManager *bpm, const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) {
+  const int tuples_per_page = 20;
+  for (auto page_id : page_ids) {
+    for (int i = 0; i < tuples_per_page; i++) {
+      auto *page = strategy == nullptr ? bpm->FetchPage(page_id) : bpm->FetchPage(page_id, *strategy);
+      ASSERT_NE(nullptr, page);
+      bpm->UnpinPage(page_id, false);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, BulkReadKeepsHotPages) {
+  const size_t buffer_pool_size = 16;
+  CountingDiskManager disk_manager;
+  BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+
+  auto scan_page_ids = CreatePagesOnDisk(&disk_manager, 100);
+  std::vector<page_id_t> hot_page_ids;
+  for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    hot_page_ids.push_back(page_id);
+  }
+
+  // With a ring of 4 frames the scan never touches the hot pages.
+  BufferAccessStrategy strategy(BufferAccessStrategy::Type::BULK_READ, 4);
+  ASSERT_EQ(4, strategy.GetRingSize());
+  Scan(&bpm, scan_page_ids, &strategy);
+  ASSERT_EQ(100, disk_manager.reads_);
+  for (auto page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+    ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+  }
+  ASSERT_EQ(100, disk_manager.reads_);
+
+  // The same scan without a strategy flushes them out of the pool.
+  Scan(&bpm, scan_page_ids, nullptr);
+  for (auto page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+    ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+  }
+  ASSERT_EQ(200 + hot_page_ids.size(), static_cast<size_t>(disk_manager.reads_));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, BulkWriteRing) {
+  const size_t buffer_pool_size = 8;
+  CountingDiskManager disk_manager;
+  BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+
+  page_id_t hot_page_id;
+  auto *hot_page = bpm.NewPage(&hot_page_id);
+  ASSERT_NE(nullptr, hot_page);
+  snprintf(hot_page->GetData(), BUSTUB_PAGE_SIZE, "hot");
+  ASSERT_TRUE(bpm.UnpinPage(hot_page_id, true));
+
+  // Dirty pages in the ring are written back when their frame comes around again.
+  BufferAccessStrategy strategy(BufferAccessStrategy::Type::BULK_WRITE, 2);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 50; i++) {
+    page_id_t page_id;
+    auto *page = bpm.NewPage(&page_id, strategy);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  ASSERT_NE(nullptr, bpm.FetchPage(hot_page_id));
+  ASSERT_TRUE(bpm.UnpinPage(hot_page_id, false));
+  ASSERT_EQ(0, disk_manager.reads_);
+
+  for (auto page_id : page_ids) {
+    auto *page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_id).c_str()));
+    ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+  }
+}
+
+// Point lookups over a hot set of pages (think index pages) interleaved with a large analytic scan, with and without a
+// ring for the scan. Reports the hit rate of the point lookups.
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, DISABLED_ScanResistanceBenchmark) {
+  const size_t buffer_pool_size = 128;
+  const size_t num_hot_pages = 96;
+  const size_t num_scan_pages = 10000;
+  const size_t lookups_per_scan_page = 4;
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (bool use_strategy : {false, true}) {
+    CountingDiskManager disk_manager;
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager);
+    auto scan_page_ids = CreatePagesOnDisk(&disk_manager, num_scan_pages);
+    auto hot_page_ids = CreatePagesOnDisk(&disk_manager, num_hot_pages);
+
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<size_t> dist(0, num_hot_pages - 1);
+    auto lookup = [&] {
+      auto page_id = hot_page_ids[dist(gen)];
+      bpm.FetchPage(page_id);
+      bpm.UnpinPage(page_id, false);
+    };
+    // Warm up the hot set.
+    for (size_t i = 0; i < num_hot_pages * 20; i++) {
+      lookup();
+    }
+
+    BufferAccessStrategy strategy(BufferAccessStrategy::Type::BULK_READ);
+    size_t lookups = 0;
+    int lookup_reads = 0;
+    for (auto scan_page_id : scan_page_ids) {
+      Scan(&bpm, {scan_page_id}, use_strategy ? &strategy : nullptr);
+      int reads_before = disk_manager.reads_;
+      for (size_t i = 0; i < lookups_per_scan_page; i++) {
+        lookup();
+      }
+      lookup_reads += disk_manager.reads_ - reads_before;
+      lookups += lookups_per_scan_page;
+    }
+    std::cout << fmt::format("strategy={} lookup_hit_rate={:.4f}", use_strategy ? "bulk_read" : "none",
+                             1.0 - static_cast<double>(lookup_reads) / static_cast<double>(lookups))
+              << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
@@ -10,9 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <iostream>
 #include <memory>
 #include <random>
 #include <string>
@@ -20,7 +23,9 @@
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "fmt/format.h"
 #include "mock_buffer_pool_manager.h"  // NOLINT
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 #define PAGE_SIZE 4096
@@ -946,4 +951,420 @@ TEST(BufferPoolManagerInstanceTest, HardTest_4) {  // NOLINT
   }
 }
 
+/**
+ * A disk manager that drops every write and never touches the read buffer, so that the miss latency measured below is
+ * the cost of the buffer pool bookkeeping alone.
+ */
+class NullDiskManager : public DiskManager {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override {}
+  void ReadPage(page_id_t page_id, char *page_data) override {}
+};
+
+// Fetch latency on a miss should not depend on the pool size. Half of the pool stays pinned (the worst case for a
+// linear scan looking for an unpinned frame) and every fetch misses and evicts one of the unpinned pages.
+// Note: the 1M frame run needs a bit more than 4 GiB of memory for the frames alone.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_MissLatencyBenchmark) {
+  const std::vector<size_t> pool_sizes = {128, 1024, 8192, 65536, 262144, 1048576};
+  const size_t num_misses = 100000;
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (auto pool_size : pool_sizes) {
+    auto *disk_manager = new NullDiskManager();
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, 2);
+
+    // Fill the pool. The first half gets a second access and stays pinned, which also moves it out of the LRU-K
+    // history list so that it does not get in the way of eviction.
+    for (size_t i = 0; i < pool_size; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      if (i < pool_size / 2) {
+        ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      } else {
+        ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    }
+
+    auto next_page_id = static_cast<page_id_t>(pool_size);
+    auto clock_start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_misses; i++) {
+      auto page_id = next_page_id++;
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    auto clock_end = std::chrono::steady_clock::now();
+    auto nanos = std::chrono::duration<double, std::nano>(clock_end - clock_start).count();
+    std::cout << "pool_size=" << pool_size << " miss_latency=" << nanos / num_misses << " ns" << std::endl;
+
+    delete bpm;
+    delete disk_manager;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+/**
+ * An in-memory disk manager whose reads and writes of one chosen page take `delay` to complete. It counts all reads and
+ * writes as well as the reads of the slow page, and lets the test know once the first slow I/O has started.
+ */
+class SlowDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  SlowDiskManager(page_id_t slow_page_id, std::chrono::milliseconds delay)
+      : slow_page_id_(slow_page_id), delay_(delay) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    writes_++;
+    if (page_id == slow_page_id_) {
+      io_started_ = true;
+      std::this_thread::sleep_for(delay_);
+    }
+    DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+  }
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    reads_++;
+    if (page_id == slow_page_id_) {
+      slow_reads_++;
+      io_started_ = true;
+      std::this_thread::sleep_for(delay_);
+    }
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  void WaitForSlowIo() const {
+    while (!io_started_) {
+      std::this_thread::yield();
+    }
+  }
+
+  page_id_t slow_page_id_;
+  std::chrono::milliseconds delay_;
+  std::atomic<bool> io_started_{false};
+  std::atomic<int> slow_reads_{0};
+  std::atomic<int> writes_{0};
+  std::atomic<int> reads_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, SlowReadDoesNotBlockHits) {
+  const page_id_t slow_page_id = 100;
+  auto *disk_manager = new SlowDiskManager(slow_page_id, std::chrono::milliseconds(1000));
+  auto *bpm = new BufferPoolManagerInstance(8, disk_manager, 2);
+
+  char data[BUSTUB_PAGE_SIZE] = "slow page";
+  disk_manager->DiskManagerUnlimitedMemory::WritePage(slow_page_id, data);
+
+  std::vector<page_id_t> hot_page_ids;
+  for (int i = 0; i < 4; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    hot_page_ids.push_back(page_id);
+  }
+
+  // Two threads miss on the same slow page. Only one of them may go to disk, the other waits on the frame.
+  Page *slow_pages[2];
+  std::thread reader_1([&] { slow_pages[0] = bpm->FetchPage(slow_page_id); });
+  disk_manager->WaitForSlowIo();
+  std::thread reader_2([&] { slow_pages[1] = bpm->FetchPage(slow_page_id); });
+
+  // Meanwhile, hits on other pages go through without waiting for the disk.
+  auto clock_start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 1000; i++) {
+    auto page_id = hot_page_ids[i % hot_page_ids.size()];
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  auto elapsed = std::chrono::steady_clock::now() - clock_start;
+  EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+
+  reader_1.join();
+  reader_2.join();
+  ASSERT_NE(nullptr, slow_pages[0]);
+  EXPECT_EQ(slow_pages[0], slow_pages[1]);
+  EXPECT_EQ(0, strcmp(slow_pages[0]->GetData(), "slow page"));
+  EXPECT_EQ(1, disk_manager->slow_reads_);
+  EXPECT_EQ(2, slow_pages[0]->GetPinCount());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, SlowFlushDoesNotBlockHits) {
+  const page_id_t slow_page_id = 0;
+  auto *disk_manager = new SlowDiskManager(slow_page_id, std::chrono::milliseconds(1000));
+  auto *bpm = new BufferPoolManagerInstance(8, disk_manager, 2);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 4; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  ASSERT_EQ(slow_page_id, page_ids[0]);
+
+  std::thread flusher([&] { EXPECT_TRUE(bpm->FlushPage(slow_page_id)); });
+  disk_manager->WaitForSlowIo();
+
+  // The flush holds a pin on its page but not the latch, so hits on the others go through
+  auto clock_start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 1000; i++) {
+    auto page_id = page_ids[1 + i % 3];
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - clock_start, std::chrono::milliseconds(500));
+  flusher.join();
+
+  auto *page = bpm->FetchPage(slow_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_FALSE(page->IsDirty());
+  EXPECT_EQ(1, page->GetPinCount());
+  char data[BUSTUB_PAGE_SIZE];
+  disk_manager->DiskManagerUnlimitedMemory::ReadPage(slow_page_id, data);
+  EXPECT_EQ(0, strcmp(data, "page 0"));
+  ASSERT_TRUE(bpm->UnpinPage(slow_page_id, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FetchWaitsForWriteBack) {
+  auto *disk_manager = new SlowDiskManager(0, std::chrono::milliseconds(300));
+  auto *bpm = new BufferPoolManagerInstance(2, disk_manager, 2);
+
+  page_id_t page_id_0;
+  page_id_t page_id_1;
+  auto *page_0 = bpm->NewPage(&page_id_0);
+  ASSERT_NE(nullptr, page_0);
+  ASSERT_EQ(0, page_id_0);
+  snprintf(page_0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  ASSERT_TRUE(bpm->UnpinPage(page_id_0, true));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_1));
+  ASSERT_TRUE(bpm->UnpinPage(page_id_1, false));
+
+  // Evicting page 0 starts a slow write-back. A fetch of page 0 must not read the stale copy on disk.
+  std::thread writer([&] {
+    page_id_t page_id_2;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_2));
+    ASSERT_TRUE(bpm->UnpinPage(page_id_2, false));
+  });
+  disk_manager->WaitForSlowIo();
+  auto *fetched = bpm->FetchPage(page_id_0);
+  writer.join();
+
+  ASSERT_NE(nullptr, fetched);
+  EXPECT_EQ(0, strcmp(fetched->GetData(), "Hello"));
+  ASSERT_TRUE(bpm->UnpinPage(page_id_0, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// A reader that raced with a delete may load the freed page back into the pool. Reusing its id must not map the id to
+// a second frame.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ReusedPageIdIsNotResidentTwice) {
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  ASSERT_TRUE(bpm->DeletePage(page_id));
+  auto *stale = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, stale);
+
+  // While the stale copy is pinned, its id is skipped but stays free
+  page_id_t other_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+  ASSERT_NE(page_id, other_page_id);
+  ASSERT_FALSE(disk_manager->IsAllocated(page_id));
+
+  // Once it is unpinned, the id is reused and the stale copy dropped
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  page_id_t reused_page_id;
+  auto *page = bpm->NewPage(&reused_page_id);
+  ASSERT_NE(nullptr, page);
+  ASSERT_EQ(page_id, reused_page_id);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  ASSERT_EQ(page, bpm->FetchPage(page_id));
+  EXPECT_EQ(0, strcmp(page->GetData(), "Hello"));
+  EXPECT_EQ(1, page->GetPinCount());
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_TRUE(bpm->UnpinPage(other_page_id, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageCleaner) {
+  const size_t buffer_pool_size = 16;
+  // The cleaner looks ahead at a quarter of the pool.
+  const size_t lookahead = buffer_pool_size / 4;
+  auto *disk_manager = new SlowDiskManager(INVALID_PAGE_ID, std::chrono::milliseconds(0));
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Fill the pool with dirty pages. The oldest one stays pinned (and is not marked dirty yet), the cleaner must skip it.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    if (i > 0) {
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    page_ids.push_back(page_id);
+  }
+  ASSERT_EQ(0, disk_manager->writes_);
+  ASSERT_DOUBLE_EQ(static_cast<double>(buffer_pool_size - 1) / buffer_pool_size, bpm->GetDirtyRatio());
+
+  bpm->StartPageCleaner();
+  for (int i = 0; i < 500 && bpm->GetPagesCleaned() < lookahead; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  bpm->StopPageCleaner();
+  ASSERT_EQ(lookahead, bpm->GetPagesCleaned());
+  ASSERT_EQ(lookahead, static_cast<size_t>(disk_manager->writes_));
+  ASSERT_DOUBLE_EQ(static_cast<double>(buffer_pool_size - 1 - lookahead) / buffer_pool_size, bpm->GetDirtyRatio());
+
+  // The next misses evict the cleaned pages, so the foreground does not write.
+  for (size_t i = 0; i < lookahead; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_EQ(lookahead, static_cast<size_t>(disk_manager->writes_));
+  ASSERT_EQ(lookahead, bpm->GetWritebacksAvoided());
+
+  // The cleaned pages made it to disk.
+  for (size_t i = 1; i <= lookahead; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_ids[i]).c_str()));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchPage) {
+  const size_t buffer_pool_size = 8;
+  auto *disk_manager = new SlowDiskManager(INVALID_PAGE_ID, std::chrono::milliseconds(0));
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Create twice as many pages as fit, so that the first half is pushed out to disk.
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  ASSERT_EQ(0, disk_manager->reads_);
+
+  // Pages that were never allocated and pages already in the pool are ignored.
+  bpm->PrefetchPage(1000);
+  bpm->PrefetchPage(2 * buffer_pool_size - 1);
+  bpm->PrefetchRange(0, 4);
+  for (int i = 0; i < 500 && bpm->GetPagesPrefetched() < 4; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(4, bpm->GetPagesPrefetched());
+  ASSERT_EQ(4, disk_manager->reads_);
+
+  // The prefetched pages are hits now.
+  for (page_id_t page_id = 0; page_id < 4; page_id++) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_id).c_str()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_EQ(4, disk_manager->reads_);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Hit throughput of a few threads, alone and next to a thread that keeps missing on a slow disk.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_SlowMissHitThroughputBenchmark) {
+  const size_t num_hit_threads = 4;
+  const size_t num_hot_pages = 64;
+  const auto duration = std::chrono::seconds(2);
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (bool with_slow_reader : {false, true}) {
+    auto *disk_manager = new SlowDiskManager(INVALID_PAGE_ID, std::chrono::milliseconds(0));
+    auto *bpm = new BufferPoolManagerInstance(num_hot_pages * 2, disk_manager);
+    for (size_t i = 0; i < num_hot_pages; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    // Pages the slow reader cycles through. They don't fit in the free frames, so every fetch is a miss.
+    char data[BUSTUB_PAGE_SIZE] = {};
+    const page_id_t cold_start = 1000;
+    const page_id_t num_cold_pages = num_hot_pages * 2;
+    for (page_id_t page_id = cold_start; page_id < cold_start + num_cold_pages; page_id++) {
+      disk_manager->WritePage(page_id, data);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> hits{0};
+    std::vector<std::thread> threads;
+    for (size_t tid = 0; tid < num_hit_threads; tid++) {
+      threads.emplace_back([&, tid] {
+        std::mt19937 gen(tid);
+        std::uniform_int_distribution<page_id_t> dist(0, num_hot_pages - 1);
+        size_t local_hits = 0;
+        while (!stop) {
+          auto page_id = dist(gen);
+          if (bpm->FetchPage(page_id) != nullptr) {
+            bpm->UnpinPage(page_id, false);
+            local_hits++;
+          }
+        }
+        hits += local_hits;
+      });
+    }
+    if (with_slow_reader) {
+      threads.emplace_back([&] {
+        for (page_id_t i = 0; !stop; i++) {
+          auto page_id = cold_start + i % num_cold_pages;
+          disk_manager->slow_page_id_ = page_id;
+          disk_manager->delay_ = std::chrono::milliseconds(5);
+          if (bpm->FetchPage(page_id) != nullptr) {
+            bpm->UnpinPage(page_id, false);
+          }
+        }
+      });
+    }
+
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::cout << fmt::format("slow_reader={} hit_throughput={:.0f} ops/s", with_slow_reader,
+                             static_cast<double>(hits) / std::chrono::duration<double>(duration).count())
+              << std::endl;
+
+    delete bpm;
+    delete disk_manager;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
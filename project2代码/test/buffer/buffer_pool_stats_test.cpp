@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats_test.cpp
+//
+// Identification: test/buffer/buffer_pool_stats_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BufferPoolStatsTest, CountsRequests) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(3, &disk_manager, 2);
+
+  page_id_t page_ids[4];
+  for (int i = 0; i < 3; i++) {
+    bpm.NewPage(&page_ids[i]);
+    bpm.UnpinPage(page_ids[i], true);
+  }
+  bpm.FetchPage(page_ids[0]);
+  bpm.UnpinPage(page_ids[0], false);
+
+  // Page 1 is the oldest page with a single access, so it makes room for page 3. Page 2 then makes room for page 1.
+  bpm.NewPage(&page_ids[3]);
+  bpm.UnpinPage(page_ids[3], false);
+  ASSERT_NE(nullptr, bpm.FetchPage(page_ids[1]));
+
+  auto stats = bpm.GetStats();
+  EXPECT_EQ(3, stats.pool_size_);
+  EXPECT_EQ(4, stats.new_pages_);
+  EXPECT_EQ(2, stats.fetches_);
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(2, stats.dirty_writebacks_);
+  EXPECT_EQ(0, stats.free_frames_);
+  EXPECT_EQ(1, stats.pinned_frames_);
+  EXPECT_EQ(1, stats.dirty_frames_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+
+  // With every frame pinned, both a new page and a miss fail.
+  bpm.FetchPage(page_ids[0]);
+  bpm.FetchPage(page_ids[3]);
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm.NewPage(&page_id));
+  EXPECT_EQ(nullptr, bpm.FetchPage(page_ids[2]));
+
+  stats = bpm.GetStats();
+  EXPECT_EQ(5, stats.fetches_);
+  EXPECT_EQ(3, stats.hits_);
+  EXPECT_EQ(2, stats.failed_requests_);
+  EXPECT_EQ(3, stats.pinned_frames_);
+  EXPECT_DOUBLE_EQ(0.75, stats.HitRatio());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolStatsTest, ResidencyByPageType) {
+  DiskManagerUnlimitedMemory disk_manager;
+  ParallelBufferPoolManager bpm(2, 4, &disk_manager, 2);
+
+  auto stats = bpm.GetStats();
+  EXPECT_EQ(8, stats.pool_size_);
+  EXPECT_EQ(8, stats.free_frames_);
+  EXPECT_EQ(0, stats.HitRatio());
+
+  const PageType page_types[] = {PageType::TABLE, PageType::TABLE, PageType::INDEX, PageType::UNKNOWN};
+  page_id_t page_ids[4];
+  for (int i = 0; i < 4; i++) {
+    auto *page = bpm.NewPage(&page_ids[i]);
+    page->SetPageType(page_types[i]);
+    bpm.UnpinPage(page_ids[i], false);
+  }
+
+  stats = bpm.GetStats();
+  EXPECT_EQ(4, stats.new_pages_);
+  EXPECT_EQ(4, stats.free_frames_);
+  EXPECT_EQ(2, stats.resident_pages_[static_cast<size_t>(PageType::TABLE)]);
+  EXPECT_EQ(1, stats.resident_pages_[static_cast<size_t>(PageType::INDEX)]);
+  EXPECT_EQ(1, stats.resident_pages_[static_cast<size_t>(PageType::UNKNOWN)]);
+  EXPECT_EQ(0, stats.resident_pages_[static_cast<size_t>(PageType::HEADER)]);
+
+  // A deleted page frees its frame, and whatever is loaded into the frame next starts out untyped.
+  ASSERT_TRUE(bpm.DeletePage(page_ids[2]));
+  stats = bpm.GetStats();
+  EXPECT_EQ(5, stats.free_frames_);
+  EXPECT_EQ(0, stats.resident_pages_[static_cast<size_t>(PageType::INDEX)]);
+  EXPECT_NE(std::string::npos, stats.ToString().find("resident_table_pages: 2\n"));
+}
+
+}  // namespace bustub
@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_clock_replacer_test.cpp
+//
+// Identification: test/buffer/concurrent_clock_replacer_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/concurrent_clock_replacer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/exception.h"
+#include "fmt/core.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ConcurrentClockReplacerTest, SampleTest) {
+  ConcurrentClockReplacer replacer(7);
+  for (frame_id_t frame_id = 0; frame_id < 6; frame_id++) {
+    replacer.RecordAccess(frame_id);
+    replacer.SetEvictable(frame_id, true);
+  }
+  EXPECT_EQ(6, replacer.Size());
+
+  // The first sweep clears every reference bit, the second one evicts in clock order.
+  frame_id_t frame_id;
+  for (frame_id_t expected : {0, 1, 2}) {
+    ASSERT_TRUE(replacer.Evict(&frame_id));
+    EXPECT_EQ(expected, frame_id);
+  }
+
+  // Frame 3 gets a second chance and frame 4 is pinned.
+  replacer.RecordAccess(3);
+  replacer.SetEvictable(4, false);
+  EXPECT_EQ(2, replacer.Size());
+  EXPECT_EQ((std::vector<frame_id_t>{5, 3}), replacer.GetEvictionCandidates(7));
+  for (frame_id_t expected : {5, 3}) {
+    ASSERT_TRUE(replacer.Evict(&frame_id));
+    EXPECT_EQ(expected, frame_id);
+  }
+  EXPECT_FALSE(replacer.Evict(&frame_id));
+
+  EXPECT_THROW(replacer.Remove(4), Exception);
+  EXPECT_THROW(replacer.RecordAccess(7), Exception);
+  replacer.SetEvictable(4, true);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(4, frame_id);
+  EXPECT_EQ(0, replacer.Size());
+}
+
+// 64 threads use the replacer the way buffer pool threads would: evict a frame to load a page into it, keep a few such
+// frames pinned for a while, and keep touching frames all over the pool. No frame may ever be handed to two threads.
+// NOLINTNEXTLINE
+TEST(ConcurrentClockReplacerTest, StressTest) {
+  const size_t num_threads = 64;
+  const size_t num_frames = 512;
+  const size_t frames_per_thread = 4;
+  const size_t num_rounds = 5000;
+
+  ConcurrentClockReplacer replacer(num_frames);
+  for (size_t i = 0; i < num_frames; i++) {
+    replacer.RecordAccess(static_cast<frame_id_t>(i));
+    replacer.SetEvictable(static_cast<frame_id_t>(i), true);
+  }
+
+  // owned[i] is true while some thread holds frame i pinned after evicting it.
+  std::vector<std::atomic<bool>> owned(num_frames);
+  std::atomic<size_t> evictions{0};
+  std::atomic<bool> double_claim{false};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<size_t> dist(0, num_frames - 1);
+      std::vector<frame_id_t> pinned;
+      auto unpin_oldest = [&] {
+        auto frame_id = pinned.front();
+        pinned.erase(pinned.begin());
+        owned[frame_id] = false;
+        replacer.SetEvictable(frame_id, true);
+      };
+
+      for (size_t round = 0; round < num_rounds; round++) {
+        for (int i = 0; i < 4; i++) {
+          replacer.RecordAccess(static_cast<frame_id_t>(dist(gen)));
+        }
+        frame_id_t frame_id;
+        if (!replacer.Evict(&frame_id)) {
+          continue;
+        }
+        evictions++;
+        if (owned[frame_id].exchange(true)) {
+          double_claim = true;
+        }
+        replacer.RecordAccess(frame_id);
+        replacer.SetEvictable(frame_id, false);
+        pinned.push_back(frame_id);
+        if (pinned.size() > frames_per_thread) {
+          unpin_oldest();
+        }
+      }
+      while (!pinned.empty()) {
+        unpin_oldest();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(double_claim);
+  EXPECT_GT(evictions, num_threads * num_rounds / 2);
+
+  // Every frame ends up tracked and evictable exactly once.
+  EXPECT_EQ(num_frames, replacer.Size());
+  std::vector<frame_id_t> victims;
+  frame_id_t frame_id;
+  while (replacer.Evict(&frame_id)) {
+    victims.push_back(frame_id);
+  }
+  std::sort(victims.begin(), victims.end());
+  ASSERT_EQ(num_frames, victims.size());
+  for (size_t i = 0; i < num_frames; i++) {
+    EXPECT_EQ(static_cast<frame_id_t>(i), victims[i]);
+  }
+}
+
+// The replacer calls a buffer pool makes on a hit (record the access, pin, unpin) from many threads at once. Reports
+// millions of hits per second for each policy.
+// NOLINTNEXTLINE
+TEST(ConcurrentClockReplacerTest, DISABLED_HitPathBenchmark) {
+  const size_t num_frames = 4096;
+  const size_t hits_per_thread = 200000;
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::ARC, ReplacerType::TWO_Q, ReplacerType::CLOCK_PRO,
+                    ReplacerType::CLOCK}) {
+    for (size_t num_threads : {1, 8, 64}) {
+      auto replacer = MakeReplacementPolicy(type, num_frames, LRUK_REPLACER_K);
+      for (size_t i = 0; i < num_frames; i++) {
+        replacer->RecordAccess(static_cast<frame_id_t>(i), static_cast<page_id_t>(i));
+        replacer->SetEvictable(static_cast<frame_id_t>(i), true);
+      }
+
+      // Each thread works on its own slice of frames, as if the pages it needs were cached, so that the only
+      // contention is inside the replacer.
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+          std::mt19937 gen(t);
+          auto slice = num_frames / num_threads;
+          std::uniform_int_distribution<size_t> dist(t * slice, (t + 1) * slice - 1);
+          for (size_t i = 0; i < hits_per_thread; i++) {
+            auto frame_id = static_cast<frame_id_t>(dist(gen));
+            replacer->RecordAccess(frame_id);
+            replacer->SetEvictable(frame_id, false);
+            replacer->SetEvictable(frame_id, true);
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::cout << fmt::format("replacer={} threads={} mhits_per_sec={:.2f}", ReplacerTypeToString(type), num_threads,
+                               static_cast<double>(num_threads * hits_per_thread) / elapsed / 1e6)
+                << std::endl;
+    }
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
@@ -3,7 +3,9 @@
  */
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <iostream>
 #include <memory>
 #include <random>
 #include <set>
@@ -11,6 +13,7 @@
 #include <vector>
 
 #include "buffer/lru_k_replacer.h"
+#include "common/exception.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -563,4 +566,76 @@ TEST(LRUKReplacerTest, ConcurrencyTest) {  // NOLINT
     ASSERT_EQ(i, evicted_elements[i - 500]);
   }
 }
+
+TEST(LRUKReplacerTest, OrdersByKthMostRecentAccess) {
+  LRUKReplacer lru_replacer(10, 2);
+  // Frame 1 was accessed last, but its second most recent access is older than frame 2's, so it goes first.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.SetEvictable(1, true);
+  lru_replacer.SetEvictable(2, true);
+  ASSERT_EQ((std::vector<frame_id_t>{1, 2}), lru_replacer.GetEvictionCandidates(10));
+
+  // Two more accesses move frame 1 behind frame 2.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  int result;
+  ASSERT_TRUE(lru_replacer.Evict(&result));
+  ASSERT_EQ(2, result);
+  ASSERT_TRUE(lru_replacer.Evict(&result));
+  ASSERT_EQ(1, result);
+  ASSERT_FALSE(lru_replacer.Evict(&result));
+}
+
+TEST(LRUKReplacerTest, KEqualsOneIsLRU) {
+  LRUKReplacer lru_replacer(10, 1);
+  for (int i = 0; i < 5; i++) {
+    lru_replacer.RecordAccess(i);
+    lru_replacer.SetEvictable(i, true);
+  }
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(2);
+  int result;
+  for (auto expected : {1, 3, 4, 0, 2}) {
+    ASSERT_TRUE(lru_replacer.Evict(&result));
+    ASSERT_EQ(expected, result);
+  }
+  ASSERT_THROW(lru_replacer.RecordAccess(10), Exception);
+}
+
+// Evictions with 90% of the frames pinned. The pinned frames were accessed once and sit in front of every evictable
+// frame, the way the pages held by a long scan do; each evicted frame comes back as a hot, evictable page.
+TEST(LRUKReplacerTest, DISABLED_PinnedEvictBenchmark) {
+  const size_t num_frames = 10000;
+  const int num_evictions = 20000;
+  LRUKReplacer lru_replacer(num_frames, 2);
+  for (size_t i = 0; i < num_frames; i++) {
+    lru_replacer.RecordAccess(static_cast<frame_id_t>(i));
+  }
+  for (size_t i = 0; i < num_frames; i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    if (i % 10 == 0) {
+      lru_replacer.RecordAccess(frame_id);
+      lru_replacer.SetEvictable(frame_id, true);
+    }
+  }
+
+  auto clock_start = std::chrono::steady_clock::now();
+  for (int n = 0; n < num_evictions; n++) {
+    frame_id_t frame_id;
+    ASSERT_TRUE(lru_replacer.Evict(&frame_id));
+    lru_replacer.RecordAccess(frame_id);
+    lru_replacer.RecordAccess(frame_id);
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+
+  auto dur = std::chrono::duration_cast<std::chrono::microseconds>(clock_end - clock_start).count();
+  std::cout << "<<< BEGIN PINNED EVICT" << std::endl;
+  std::cout << "Evictions/ms: " << static_cast<double>(num_evictions) * 1000 / std::max<int64_t>(dur, 1) << std::endl;
+  std::cout << ">>> END PINNED EVICT" << std::endl;
+}
 }  // namespace bustub
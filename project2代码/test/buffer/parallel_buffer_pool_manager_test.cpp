@@ -0,0 +1,226 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const size_t num_instances = 5;
+  const size_t pool_size = 2;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager, 5);
+  ASSERT_EQ(num_instances * pool_size, bpm->GetPoolSize());
+
+  // Scenario: NewPage hands out page ids round robin, one stripe per instance.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(page_id, static_cast<page_id_t>(i));
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: every instance is full, so no more pages can be created.
+  page_id_t page_id_temp;
+  ASSERT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: each page is owned by the instance its id maps to.
+  for (auto page_id : page_ids) {
+    ASSERT_EQ(bpm->GetBufferPoolManager(page_id), bpm->GetBufferPoolManager(page_id + num_instances));
+    ASSERT_NE(bpm->GetBufferPoolManager(page_id), bpm->GetBufferPoolManager(page_id + 1));
+  }
+
+  // Scenario: after unpinning everything, new pages evict old ones and old pages can still be read back.
+  for (auto page_id : page_ids) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < num_instances * pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    ASSERT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_id).c_str()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: deleting an unpinned page succeeds, deleting a pinned one fails.
+  ASSERT_TRUE(bpm->DeletePage(page_ids[0]));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1]));
+  ASSERT_FALSE(bpm->DeletePage(page_ids[1]));
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[1], false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, NewPageSkipsFullInstances) {
+  const size_t num_instances = 4;
+  const size_t pool_size = 3;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager, 5);
+
+  // Fill up every instance, then unpin all pages except the ones owned by instance 0.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+  }
+  for (auto page_id : page_ids) {
+    if (bpm->GetBufferPoolManager(page_id) != bpm->GetBufferPoolManager(0)) {
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  }
+
+  // Every new page now has to come from one of the other instances.
+  for (size_t i = 0; i < (num_instances - 1) * pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_NE(bpm->GetBufferPoolManager(page_id), bpm->GetBufferPoolManager(0));
+  }
+  page_id_t page_id_temp;
+  ASSERT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const size_t num_threads = 8;
+  const size_t num_runs = 20;
+  for (size_t run = 0; run < num_runs; run++) {
+    auto *disk_manager = new DiskManagerUnlimitedMemory();
+    auto bpm = std::make_shared<ParallelBufferPoolManager>(4, 16, disk_manager);
+    std::vector<std::thread> threads;
+
+    for (size_t tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&bpm]() {
+        page_id_t temp_page_id;
+        std::vector<page_id_t> page_ids;
+        for (int i = 0; i < 8; i++) {
+          auto *new_page = bpm->NewPage(&temp_page_id);
+          EXPECT_NE(nullptr, new_page);
+          ASSERT_NE(nullptr, new_page);
+          strcpy(new_page->GetData(), std::to_string(temp_page_id).c_str());  // NOLINT
+          page_ids.push_back(temp_page_id);
+        }
+        for (auto page_id : page_ids) {
+          EXPECT_EQ(1, bpm->UnpinPage(page_id, true));
+        }
+        for (auto page_id : page_ids) {
+          auto *page = bpm->FetchPage(page_id);
+          EXPECT_NE(nullptr, page);
+          ASSERT_NE(nullptr, page);
+          EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+          EXPECT_EQ(1, bpm->UnpinPage(page_id, true));
+        }
+        for (auto page_id : page_ids) {
+          EXPECT_EQ(1, bpm->DeletePage(page_id));
+        }
+      });
+    }
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    delete disk_manager;
+  }
+}
+
+/**
+ * Run fetch/unpin pairs from `num_threads` threads against `bpm` for a fixed number of operations and return the
+ * throughput in operations per second. Every thread works on its own set of resident pages, so the only contention
+ * left is on the buffer pool latches.
+ */
+auto BufferPoolScalingBenchmarkCall(BufferPoolManager *bpm, const std::vector<page_id_t> &page_ids, size_t num_threads,
+                                    size_t ops_per_thread) -> double {
+  std::vector<std::thread> threads;
+  auto clock_start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, &page_ids, tid, ops_per_thread]() {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        auto page_id = page_ids[dist(gen)];
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  auto seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+  return static_cast<double>(num_threads * ops_per_thread) / seconds;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_ScalingBenchmark) {
+  const size_t total_frames = 1024;
+  const size_t ops_per_thread = 100000;
+  const std::vector<size_t> thread_counts = {1, 2, 4, 8, 16, 32};
+  const std::vector<size_t> instance_counts = {1, 16};
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (auto num_instances : instance_counts) {
+    auto *disk_manager = new DiskManagerUnlimitedMemory();
+    auto *bpm = new ParallelBufferPoolManager(num_instances, total_frames / num_instances, disk_manager);
+
+    // Populate the pool so that every fetch in the benchmark is a hit.
+    std::vector<page_id_t> page_ids;
+    for (size_t i = 0; i < total_frames; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      page_ids.push_back(page_id);
+    }
+
+    for (auto num_threads : thread_counts) {
+      auto throughput = BufferPoolScalingBenchmarkCall(bpm, page_ids, num_threads, ops_per_thread);
+      std::cout << "instances=" << num_instances << " threads=" << num_threads << " throughput=" << throughput
+                << " ops/s" << std::endl;
+    }
+
+    delete bpm;
+    delete disk_manager;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
@@ -0,0 +1,296 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pointer_swizzling_test.cpp
+//
+// Identification: test/buffer/pointer_swizzling_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+/** Create a page that holds its own id as a string, and unpin it. */
+static auto CreatePage(BufferPoolManager *bpm) -> page_id_t {
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+  bpm->UnpinPage(page_id, true);
+  return page_id;
+}
+
+/** Create a page like CreatePage() and access it once more, so that LRU-K evicts older pages before it. */
+static auto CreateHotPage(BufferPoolManager *bpm) -> page_id_t {
+  auto page_id = CreatePage(bpm);
+  bpm->FetchPage(page_id);
+  bpm->UnpinPage(page_id, false);
+  return page_id;
+}
+
+static auto HoldsPage(Page *page, page_id_t page_id) -> bool {
+  char expected[32];
+  snprintf(expected, sizeof(expected), "page %d", page_id);
+  return page != nullptr && page->GetPageId() == page_id && std::strcmp(page->GetData(), expected) == 0;
+}
+
+// NOLINTNEXTLINE
+TEST(PointerSwizzlingTest, ResidentChildSkipsPageTable) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+  bpm.EnableSwizzling();
+
+  auto parent_id = CreatePage(&bpm);
+  auto child_id = CreatePage(&bpm);
+  auto *parent = bpm.FetchPage(parent_id);
+
+  // The first fetch goes through the page table and swizzles the slot, the second one uses the swip.
+  auto *child = bpm.FetchChildPage(parent, 3, child_id);
+  ASSERT_TRUE(HoldsPage(child, child_id));
+  bpm.UnpinPage(child_id, false);
+  EXPECT_EQ(0, bpm.GetSwizzledFetches());
+
+  child = bpm.FetchChildPage(parent, 3, child_id);
+  ASSERT_TRUE(HoldsPage(child, child_id));
+  EXPECT_EQ(1, child->GetPinCount());
+  bpm.UnpinPage(child_id, false);
+  EXPECT_EQ(1, bpm.GetSwizzledFetches());
+  EXPECT_EQ(0, child->GetPinCount());
+
+  bpm.UnpinPage(parent_id, false);
+}
+
+// NOLINTNEXTLINE
+TEST(PointerSwizzlingTest, EvictedChildIsUnswizzled) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(3, &disk_manager, 2);
+  bpm.EnableSwizzling();
+
+  auto parent_id = CreatePage(&bpm);
+  auto child_id = CreatePage(&bpm);
+  auto *parent = bpm.FetchPage(parent_id);
+  ASSERT_TRUE(HoldsPage(bpm.FetchChildPage(parent, 0, child_id), child_id));
+  bpm.UnpinPage(child_id, false);
+
+  // Push the child out of the pool; its old frame now holds another page.
+  for (int i = 0; i < 2; i++) {
+    CreateHotPage(&bpm);
+  }
+
+  auto swizzled_fetches = bpm.GetSwizzledFetches();
+  ASSERT_TRUE(HoldsPage(bpm.FetchChildPage(parent, 0, child_id), child_id));
+  EXPECT_EQ(swizzled_fetches, bpm.GetSwizzledFetches());
+  bpm.UnpinPage(child_id, false);
+
+  // A slot that points to another child after a split falls back to the page table as well. Keep the old child
+  // pinned, so that its frame still holds it.
+  bpm.FetchPage(child_id);
+  auto other_child_id = CreatePage(&bpm);
+  ASSERT_TRUE(HoldsPage(bpm.FetchChildPage(parent, 0, other_child_id), other_child_id));
+  EXPECT_EQ(swizzled_fetches, bpm.GetSwizzledFetches());
+  bpm.UnpinPage(other_child_id, false);
+  bpm.UnpinPage(child_id, false);
+
+  bpm.UnpinPage(parent_id, false);
+}
+
+// NOLINTNEXTLINE
+TEST(PointerSwizzlingTest, PeekChildWithoutPin) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(3, &disk_manager, 2);
+  bpm.EnableSwizzling();
+
+  auto parent_id = CreatePage(&bpm);
+  auto child_id = CreatePage(&bpm);
+  auto *parent = bpm.FetchPage(parent_id);
+  uint64_t version;
+  EXPECT_EQ(nullptr, bpm.PeekChildPage(parent, 0, child_id, &version));
+  ASSERT_TRUE(HoldsPage(bpm.FetchChildPage(parent, 0, child_id), child_id));
+  bpm.UnpinPage(child_id, false);
+
+  // The swizzled child is found without a pin and without counting as a fetch
+  auto fetches = bpm.GetStats().fetches_;
+  auto *child = bpm.PeekChildPage(parent, 0, child_id, &version);
+  ASSERT_TRUE(HoldsPage(child, child_id));
+  EXPECT_EQ(0, child->GetPinCount());
+  EXPECT_TRUE(child->ValidateOptimisticLatch(version));
+  EXPECT_EQ(fetches, bpm.GetStats().fetches_);
+
+  // Another child id in the slot, or an unswizzled slot, is not found
+  EXPECT_EQ(nullptr, bpm.PeekChildPage(parent, 0, parent_id, &version));
+  EXPECT_EQ(nullptr, bpm.PeekChildPage(parent, 1, child_id, &version));
+
+  // Neither is a child that is being written
+  ASSERT_NE(nullptr, bpm.PeekChildPage(parent, 0, child_id, &version));
+  child->WLatch();
+  uint64_t latched_version;
+  EXPECT_EQ(nullptr, bpm.PeekChildPage(parent, 0, child_id, &latched_version));
+  child->WUnlatch();
+  EXPECT_FALSE(child->ValidateOptimisticLatch(version));
+
+  // A read that started before the frame went to another page fails to validate
+  ASSERT_NE(nullptr, bpm.PeekChildPage(parent, 0, child_id, &version));
+  for (int i = 0; i < 2; i++) {
+    CreateHotPage(&bpm);
+  }
+  EXPECT_NE(child_id, child->GetPageId());
+  EXPECT_FALSE(child->ValidateOptimisticLatch(version));
+  EXPECT_EQ(nullptr, bpm.PeekChildPage(parent, 0, child_id, &version));
+
+  bpm.UnpinPage(parent_id, false);
+}
+
+// NOLINTNEXTLINE
+TEST(PointerSwizzlingTest, EvictedParentDropsItsSwips) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(3, &disk_manager, 2);
+  bpm.EnableSwizzling();
+
+  auto parent_id = CreatePage(&bpm);
+  auto child_id = CreatePage(&bpm);
+  auto *parent = bpm.FetchPage(parent_id);
+  ASSERT_TRUE(HoldsPage(bpm.FetchChildPage(parent, 0, child_id), child_id));
+  bpm.UnpinPage(child_id, false);
+  bpm.UnpinPage(parent_id, false);
+
+  // Evict the parent while the child stays pinned, then bring the parent back into some frame.
+  auto *child = bpm.FetchPage(child_id);
+  for (int i = 0; i < 2; i++) {
+    CreateHotPage(&bpm);
+  }
+  parent = bpm.FetchPage(parent_id);
+  ASSERT_NE(nullptr, parent);
+
+  ASSERT_EQ(child, bpm.FetchChildPage(parent, 0, child_id));
+  EXPECT_EQ(0, bpm.GetSwizzledFetches());
+  bpm.UnpinPage(child_id, false);
+  bpm.UnpinPage(child_id, false);
+  bpm.UnpinPage(parent_id, false);
+}
+
+// NOLINTNEXTLINE
+TEST(PointerSwizzlingTest, ParallelBufferPool) {
+  DiskManagerUnlimitedMemory disk_manager;
+  ParallelBufferPoolManager bpm(4, 4, &disk_manager, 2);
+  bpm.EnableSwizzling();
+
+  auto parent_id = CreatePage(&bpm);
+  std::vector<page_id_t> child_ids;
+  for (int i = 0; i < 8; i++) {
+    child_ids.push_back(CreatePage(&bpm));
+  }
+  auto *parent = bpm.FetchPage(parent_id);
+  for (int round = 0; round < 2; round++) {
+    for (size_t slot = 0; slot < child_ids.size(); slot++) {
+      auto child_id = child_ids[slot];
+      ASSERT_TRUE(HoldsPage(bpm.FetchChildPage(parent, static_cast<int>(slot), child_id), child_id));
+      bpm.UnpinPage(child_id, false);
+    }
+  }
+  size_t swizzled_fetches = 0;
+  for (size_t i = 0; i < bpm.GetNumInstances(); i++) {
+    swizzled_fetches += bpm.GetBufferPoolManager(static_cast<page_id_t>(i))->GetSwizzledFetches();
+  }
+  EXPECT_EQ(child_ids.size(), swizzled_fetches);
+  bpm.UnpinPage(parent_id, false);
+}
+
+// NOLINTNEXTLINE
+TEST(PointerSwizzlingTest, BPlusTreeWithSmallPool) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(50, &disk_manager, 2);
+  bpm.EnableSwizzling();
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", &bpm, comparator, 4, 4);
+  page_id_t header_page_id;
+  bpm.NewPage(&header_page_id);
+
+  // The pool is far smaller than the tree, so children keep getting evicted under their parents' swips.
+  const int64_t num_keys = 2000;
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; i++) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+  auto *transaction = new Transaction(0);
+  GenericKey<8> index_key;
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key)), transaction);
+  }
+  for (auto key : keys) {
+    if (key % 3 == 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+  }
+  delete transaction;
+
+  std::vector<RID> result;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    result.clear();
+    ASSERT_EQ(key % 3 != 0, tree.GetValue(index_key, &result));
+    if (key % 3 != 0) {
+      EXPECT_EQ(static_cast<int32_t>(key), result[0].GetSlotNum());
+    }
+  }
+  EXPECT_GT(bpm.GetSwizzledFetches(), 0);
+  bpm.UnpinPage(HEADER_PAGE_ID, true);
+}
+
+// Once the swips are in place, point lookups in a tree that fits in the pool fetch nothing from the buffer pool.
+// NOLINTNEXTLINE
+TEST(PointerSwizzlingTest, BPlusTreeLookupsDoNotFetch) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(64, &disk_manager, 2);
+  bpm.EnableSwizzling();
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", &bpm, comparator, 8, 8);
+  page_id_t header_page_id;
+  bpm.NewPage(&header_page_id);
+
+  const int64_t num_keys = 100;
+  auto *transaction = new Transaction(0);
+  GenericKey<8> index_key;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, static_cast<int32_t>(key)), transaction);
+  }
+  delete transaction;
+
+  std::vector<RID> result;
+  for (int round = 0; round < 2; round++) {
+    auto fetches = bpm.GetStats().fetches_;
+    for (int64_t key = 0; key < num_keys; key++) {
+      index_key.SetFromInteger(key);
+      result.clear();
+      ASSERT_TRUE(tree.GetValue(index_key, &result));
+      EXPECT_EQ(static_cast<int32_t>(key), result[0].GetSlotNum());
+    }
+    // The first round swizzles the tree
+    if (round == 1) {
+      EXPECT_EQ(fetches, bpm.GetStats().fetches_);
+    }
+  }
+  bpm.UnpinPage(HEADER_PAGE_ID, true);
+}
+
+}  // namespace bustub
@@ -0,0 +1,223 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_test.cpp
+//
+// Identification: test/buffer/read_ahead_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/read_ahead.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+/**
+ * A buffer pool over a chain of pages that records prefetch hints instead of acting on them. A prefetched page counts
+ * as resident right away unless it is slow to read, and the chain can only be looked up through resident pages.
+ */
+class RecordingBufferPoolManager : public BufferPoolManagerInstance {
+ public:
+  explicit RecordingBufferPoolManager(DiskManager *disk_manager) : BufferPoolManagerInstance(1, disk_manager) {}
+
+  void PrefetchPage(page_id_t page_id) override {
+    prefetched_.push_back(page_id);
+    if (slow_.count(page_id) == 0) {
+      resident_.insert(page_id);
+    }
+  }
+
+  auto PeekNextPageId(page_id_t page_id, next_page_id_fn next_page_id) -> page_id_t override {
+    if (resident_.count(page_id) == 0 || chain_.count(page_id) == 0) {
+      return INVALID_PAGE_ID;
+    }
+    return chain_[page_id];
+  }
+
+  std::vector<page_id_t> prefetched_;
+  std::unordered_set<page_id_t> resident_;
+  std::unordered_set<page_id_t> slow_;
+  std::unordered_map<page_id_t, page_id_t> chain_;
+};
+
+/** Chain pages through the first four bytes of their data, like the table heap does. */
+auto NextPageIdOf(Page *page) -> page_id_t { return *reinterpret_cast<page_id_t *>(page->GetData()); }
+
+/** The pages of a chain whose ids are anything but contiguous. */
+auto ScatteredChain(size_t length) -> std::vector<page_id_t> {
+  std::vector<page_id_t> chain;
+  for (size_t i = 0; i < length; i++) {
+    chain.push_back(static_cast<page_id_t>((i * 7919) % 10007));
+  }
+  return chain;
+}
+
+// NOLINTNEXTLINE
+TEST(ReadAheadTest, FollowsTheChain) {
+  DiskManagerUnlimitedMemory disk_manager;
+  RecordingBufferPoolManager bpm(&disk_manager);
+  ReadAheadDetector read_ahead(&bpm, NextPageIdOf);
+  auto chain = ScatteredChain(1000);
+  for (size_t i = 0; i + 1 < chain.size(); i++) {
+    bpm.chain_[chain[i]] = chain[i + 1];
+  }
+  auto visit = [&](size_t i) {
+    read_ahead.OnPageAccess(chain[i], i + 1 < chain.size() ? chain[i + 1] : INVALID_PAGE_ID);
+  };
+
+  // Nothing is prefetched until the scan has made READ_AHEAD_TRIGGER steps along the chain.
+  visit(0);
+  visit(1);
+  ASSERT_TRUE(bpm.prefetched_.empty());
+  visit(2);
+  ASSERT_EQ(std::vector<page_id_t>({chain[3], chain[4], chain[5], chain[6]}), bpm.prefetched_);
+
+  // The next window is requested once half of the last one has been consumed, and it is twice as large.
+  bpm.prefetched_.clear();
+  visit(3);
+  ASSERT_TRUE(bpm.prefetched_.empty());
+  visit(4);
+  ASSERT_EQ(std::vector<page_id_t>(chain.begin() + 7, chain.begin() + 13), bpm.prefetched_);
+
+  // Every page is requested at most once and in chain order over a long scan, and the window never exceeds the
+  // maximum.
+  bpm.prefetched_.clear();
+  for (size_t i = 5; i < chain.size(); i++) {
+    visit(i);
+    ASSERT_LE(bpm.prefetched_.size(), i + ReadAheadDetector::READ_AHEAD_MAX_WINDOW - 12);
+  }
+  ASSERT_EQ(std::vector<page_id_t>(chain.begin() + 13, chain.end()), bpm.prefetched_);
+}
+
+// NOLINTNEXTLINE
+TEST(ReadAheadTest, StopsAtPagesNotInThePool) {
+  DiskManagerUnlimitedMemory disk_manager;
+  RecordingBufferPoolManager bpm(&disk_manager);
+  ReadAheadDetector read_ahead(&bpm, NextPageIdOf);
+  auto chain = ScatteredChain(20);
+  for (size_t i = 0; i + 1 < chain.size(); i++) {
+    bpm.chain_[chain[i]] = chain[i + 1];
+  }
+
+  // A prefetched page that is still being read in cannot be looked into, so the walk stops there ...
+  bpm.slow_.insert(chain[4]);
+  for (size_t i = 0; i < 3; i++) {
+    read_ahead.OnPageAccess(chain[i], chain[i + 1]);
+  }
+  ASSERT_EQ(std::vector<page_id_t>({chain[3], chain[4]}), bpm.prefetched_);
+
+  // ... and the walk goes on from there on a later step, once it has arrived.
+  bpm.prefetched_.clear();
+  bpm.resident_.insert(chain[4]);
+  read_ahead.OnPageAccess(chain[3], chain[4]);
+  ASSERT_EQ(std::vector<page_id_t>({chain[5], chain[6], chain[7]}), bpm.prefetched_);
+}
+
+// NOLINTNEXTLINE
+TEST(ReadAheadTest, GuessesContiguousIds) {
+  DiskManagerUnlimitedMemory disk_manager;
+  RecordingBufferPoolManager bpm(&disk_manager);
+  ReadAheadDetector read_ahead(&bpm, NextPageIdOf);
+  // A cold scan: no page is in the pool before the scan reads it
+  for (page_id_t page_id = 100; page_id < 300; page_id++) {
+    bpm.slow_.insert(page_id);
+  }
+
+  // Past the next page, which the scan reports, the ids that follow are guessed.
+  for (page_id_t page_id = 100; page_id < 103; page_id++) {
+    read_ahead.OnPageAccess(page_id, page_id + 1);
+  }
+  ASSERT_EQ(std::vector<page_id_t>({103, 104, 105, 106}), bpm.prefetched_);
+
+  // The window grows to its maximum as it would on a warm chain, and every page is requested once and in order.
+  page_id_t max_ahead = 0;
+  for (page_id_t page_id = 103; page_id < 299; page_id++) {
+    read_ahead.OnPageAccess(page_id, page_id + 1);
+    max_ahead = std::max(max_ahead, bpm.prefetched_.back() - page_id);
+  }
+  ASSERT_EQ(static_cast<page_id_t>(ReadAheadDetector::READ_AHEAD_MAX_WINDOW), max_ahead);
+  for (size_t i = 0; i < bpm.prefetched_.size(); i++) {
+    ASSERT_EQ(static_cast<page_id_t>(103 + i), bpm.prefetched_[i]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ReadAheadTest, DropsWrongGuesses) {
+  DiskManagerUnlimitedMemory disk_manager;
+  RecordingBufferPoolManager bpm(&disk_manager);
+  ReadAheadDetector read_ahead(&bpm, NextPageIdOf);
+  for (page_id_t page_id : {10, 11, 12, 13, 14, 15, 16, 50, 51, 52, 53}) {
+    bpm.slow_.insert(page_id);
+  }
+  for (page_id_t page_id = 10; page_id < 13; page_id++) {
+    read_ahead.OnPageAccess(page_id, page_id + 1);
+  }
+  ASSERT_EQ(std::vector<page_id_t>({13, 14, 15, 16}), bpm.prefetched_);
+
+  // The chain leaves the contiguous ids after 13, so 14 to 16 were wrong. The window starts over from where the chain
+  // goes, and the run is not guessed on any more.
+  bpm.prefetched_.clear();
+  read_ahead.OnPageAccess(13, 50);
+  ASSERT_EQ(std::vector<page_id_t>({50}), bpm.prefetched_);
+  read_ahead.OnPageAccess(50, 51);
+  read_ahead.OnPageAccess(51, 52);
+  ASSERT_EQ(std::vector<page_id_t>({50, 51, 52}), bpm.prefetched_);
+}
+
+// NOLINTNEXTLINE
+TEST(ReadAheadTest, LeavingTheChainResets) {
+  DiskManagerUnlimitedMemory disk_manager;
+  RecordingBufferPoolManager bpm(&disk_manager);
+  ReadAheadDetector read_ahead(&bpm, NextPageIdOf);
+
+  // Contiguous page ids mean nothing if the scan does not go where the previous page pointed to.
+  for (page_id_t page_id : {5, 6, 7, 8, 9}) {
+    read_ahead.OnPageAccess(page_id, page_id + 10);
+  }
+  ASSERT_TRUE(bpm.prefetched_.empty());
+
+  // A new run starts over with the smallest window.
+  read_ahead.OnPageAccess(20, 30);
+  read_ahead.OnPageAccess(30, 2);
+  read_ahead.OnPageAccess(2, 50);
+  ASSERT_EQ(std::vector<page_id_t>({50}), bpm.prefetched_);
+}
+
+// NOLINTNEXTLINE
+TEST(ReadAheadTest, PeekNextPageId) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(4, &disk_manager);
+
+  page_id_t page_id;
+  auto *page = bpm.NewPage(&page_id);
+  page_id_t next_page_id = 42;
+  memcpy(page->GetData(), &next_page_id, sizeof(next_page_id));
+
+  // A resident page is read without a pin left behind, and its access is not counted.
+  ASSERT_EQ(42, bpm.PeekNextPageId(page_id, NextPageIdOf));
+  ASSERT_EQ(1, page->GetPinCount());
+
+  // A page with a writer is given up on rather than waited for.
+  page->WLatch();
+  ASSERT_EQ(INVALID_PAGE_ID, bpm.PeekNextPageId(page_id, NextPageIdOf));
+  page->WUnlatch();
+  ASSERT_EQ(42, bpm.PeekNextPageId(page_id, NextPageIdOf));
+
+  // So is a page that is not in the pool.
+  ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+  ASSERT_TRUE(bpm.DeletePage(page_id));
+  ASSERT_EQ(INVALID_PAGE_ID, bpm.PeekNextPageId(page_id, NextPageIdOf));
+}
+
+}  // namespace bustub
@@ -0,0 +1,222 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacement_policy_test.cpp
+//
+// Identification: test/buffer/replacement_policy_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacement_policy.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/clock_pro_replacer.h"
+#include "buffer/page_access_trace.h"
+#include "buffer/two_queue_replacer.h"
+#include "fmt/core.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+static const ReplacerType ALL_REPLACER_TYPES[] = {ReplacerType::LRU_K, ReplacerType::ARC, ReplacerType::TWO_Q,
+                                                  ReplacerType::CLOCK_PRO, ReplacerType::CLOCK};
+
+/** Load page first_page_id + i into frame i for every frame, with a single access each, and make them evictable. */
+static void FillFrames(ReplacementPolicy *replacer, size_t num_frames, page_id_t first_page_id) {
+  for (size_t i = 0; i < num_frames; i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    replacer->RecordAccess(frame_id, first_page_id + static_cast<page_id_t>(i));
+    replacer->SetEvictable(frame_id, true);
+  }
+}
+
+static auto EvictAll(ReplacementPolicy *replacer) -> std::vector<frame_id_t> {
+  std::vector<frame_id_t> victims;
+  frame_id_t frame_id;
+  while (replacer->Evict(&frame_id)) {
+    victims.push_back(frame_id);
+  }
+  return victims;
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacementPolicyTest, NeverEvictsPinnedFrames) {
+  for (auto type : ALL_REPLACER_TYPES) {
+    SCOPED_TRACE(ReplacerTypeToString(type));
+    auto replacer = MakeReplacementPolicy(type, 5, 2);
+    FillFrames(replacer.get(), 5, 0);
+    replacer->RecordAccess(2);
+    replacer->SetEvictable(1, false);
+    replacer->SetEvictable(3, false);
+    EXPECT_EQ(3, replacer->Size());
+    for (auto frame_id : replacer->GetEvictionCandidates(5)) {
+      EXPECT_TRUE(frame_id != 1 && frame_id != 3);
+    }
+    EXPECT_THROW(replacer->Remove(1), Exception);
+    EXPECT_THROW(replacer->RecordAccess(5), Exception);
+
+    auto victims = EvictAll(replacer.get());
+    std::sort(victims.begin(), victims.end());
+    EXPECT_EQ((std::vector<frame_id_t>{0, 2, 4}), victims);
+    EXPECT_EQ(0, replacer->Size());
+
+    // An unpinned frame can be evicted again, and a removed frame is forgotten.
+    replacer->SetEvictable(1, true);
+    replacer->Remove(1);
+    replacer->SetEvictable(3, true);
+    EXPECT_EQ((std::vector<frame_id_t>{3}), EvictAll(replacer.get()));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacementPolicyTest, ArcAdaptsToRecencyGhostHits) {
+  ArcReplacer replacer(3);
+  // Page 10 is used twice and moves to T2; a scan over pages 11 and 12 only fills T1.
+  replacer.RecordAccess(0, 10);
+  replacer.RecordAccess(0, 10);
+  replacer.RecordAccess(1, 11);
+  replacer.RecordAccess(2, 12);
+  for (frame_id_t frame_id = 0; frame_id < 3; frame_id++) {
+    replacer.SetEvictable(frame_id, true);
+  }
+  EXPECT_EQ(0, replacer.GetTargetRecencySize());
+
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(1, frame_id);
+
+  // Page 11 comes back while it is remembered in B1, so T1 should have been larger. T1 is at its target now, so T2
+  // gives up its least recently used frame first.
+  replacer.RecordAccess(1, 11);
+  replacer.SetEvictable(1, true);
+  EXPECT_EQ(1, replacer.GetTargetRecencySize());
+  EXPECT_EQ((std::vector<frame_id_t>{0, 1, 2}), EvictAll(&replacer));
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacementPolicyTest, TwoQueuePromotesFromA1out) {
+  // Four frames: A1in holds one frame, A1out remembers two pages.
+  TwoQueueReplacer replacer(4);
+  FillFrames(&replacer, 4, 100);
+  // A second access while the page is in A1in is a correlated reference and does not promote it.
+  replacer.RecordAccess(3, 103);
+
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(0, frame_id);
+
+  // Page 100 returns from A1out straight into Am, which is only drained once A1in is down to its share.
+  replacer.RecordAccess(0, 100);
+  replacer.SetEvictable(0, true);
+  EXPECT_EQ((std::vector<frame_id_t>{1, 2, 0, 3}), EvictAll(&replacer));
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacementPolicyTest, ClockProTestPeriodHit) {
+  ClockProReplacer replacer(4);
+  FillFrames(&replacer, 4, 200);
+  EXPECT_EQ(1, replacer.GetColdTarget());
+
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(0, frame_id);
+
+  // Page 200 returns during its test period: it becomes hot and cold pages get more room.
+  replacer.RecordAccess(0, 200);
+  replacer.SetEvictable(0, true);
+  EXPECT_EQ(2, replacer.GetColdTarget());
+  EXPECT_EQ((std::vector<frame_id_t>{1, 2, 3}), replacer.GetEvictionCandidates(4));
+  EXPECT_EQ((std::vector<frame_id_t>{1, 2, 3, 0}), EvictAll(&replacer));
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacementPolicyTest, BufferPoolWithEachPolicy) {
+  for (auto type : ALL_REPLACER_TYPES) {
+    SCOPED_TRACE(ReplacerTypeToString(type));
+    DiskManagerUnlimitedMemory disk_manager;
+    BufferPoolManagerInstance bpm(8, &disk_manager, 2, nullptr, type);
+
+    std::vector<page_id_t> page_ids(32);
+    for (auto &page_id : page_ids) {
+      auto *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      bpm.UnpinPage(page_id, true);
+    }
+
+    // A skewed mix: every other request goes to one of the first four pages.
+    std::mt19937 rng(0);
+    for (int i = 0; i < 500; i++) {
+      auto page_id = i % 2 == 0 ? page_ids[rng() % 4] : page_ids[rng() % page_ids.size()];
+      auto *page = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      char expected[32];
+      snprintf(expected, sizeof(expected), "page %d", page_id);
+      ASSERT_STREQ(expected, page->GetData());
+      bpm.UnpinPage(page_id, false);
+    }
+
+    // With three frames pinned, the policy has to work around them.
+    for (int i = 0; i < 3; i++) {
+      ASSERT_NE(nullptr, bpm.FetchPage(page_ids[i]));
+    }
+    for (auto page_id : page_ids) {
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      bpm.UnpinPage(page_id, false);
+    }
+    for (int i = 0; i < 3; i++) {
+      bpm.UnpinPage(page_ids[i], false);
+    }
+    EXPECT_TRUE(bpm.DeletePage(page_ids[5]));
+
+    auto stats = bpm.GetStats();
+    EXPECT_EQ(535, stats.fetches_);
+    EXPECT_EQ(stats.fetches_, stats.hits_ + stats.misses_);
+    EXPECT_EQ(0, stats.failed_requests_);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacementPolicyTest, AccessTraceRoundTrip) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  std::stringstream out;
+  PageAccessTrace trace(&out);
+  bpm.SetAccessTrace(&trace);
+
+  page_id_t page_id;
+  bpm.NewPage(&page_id);
+  bpm.UnpinPage(page_id, false);
+  bpm.FetchPage(page_id);
+  bpm.UnpinPage(page_id, false);
+  bpm.DeletePage(page_id);
+  bpm.SetAccessTrace(nullptr);
+  page_id_t untraced_page_id;
+  bpm.NewPage(&untraced_page_id);
+  bpm.UnpinPage(untraced_page_id, false);
+
+  EXPECT_EQ(fmt::format("N {0}\nF {0}\nD {0}\n", page_id), out.str());
+  auto events = PageAccessTrace::Read(&out);
+  ASSERT_EQ(3, events.size());
+  EXPECT_EQ(PageAccessTrace::EventType::NEW, events[0].type_);
+  EXPECT_EQ(PageAccessTrace::EventType::FETCH, events[1].type_);
+  EXPECT_EQ(PageAccessTrace::EventType::DELETE, events[2].type_);
+  EXPECT_EQ(page_id, events[2].page_id_);
+
+  std::stringstream malformed("F 1\nF 2\nX 3\nF 4\n");
+  EXPECT_EQ(2, PageAccessTrace::Read(&malformed).size());
+}
+
+}  // namespace bustub
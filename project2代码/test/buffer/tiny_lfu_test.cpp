@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tiny_lfu_test.cpp
+//
+// Identification: test/buffer/tiny_lfu_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/tiny_lfu.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "fmt/core.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+static auto CreatePages(BufferPoolManager *bpm, size_t num_pages) -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids(num_pages);
+  for (auto &page_id : page_ids) {
+    bpm->NewPage(&page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  return page_ids;
+}
+
+static void Touch(BufferPoolManager *bpm, page_id_t page_id, int times = 1) {
+  for (int i = 0; i < times; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(TinyLfuTest, EstimatesAndAges) {
+  TinyLfu sketch(16);
+  ASSERT_EQ(160, sketch.GetSampleSize());
+
+  for (int i = 0; i < 5; i++) {
+    sketch.RecordAccess(1);
+  }
+  for (int i = 0; i < 20; i++) {
+    sketch.RecordAccess(2);
+  }
+  EXPECT_EQ(5, sketch.Estimate(1));
+  EXPECT_EQ(15, sketch.Estimate(2));
+  EXPECT_EQ(0, sketch.Estimate(3));
+  EXPECT_TRUE(sketch.Admit(2, 1));
+  EXPECT_FALSE(sketch.Admit(1, 2));
+  EXPECT_FALSE(sketch.Admit(3, 3));
+
+  // Filling up the sample halves every count.
+  for (page_id_t page_id = 100; page_id < 235; page_id++) {
+    sketch.RecordAccess(page_id);
+  }
+  EXPECT_EQ(2, sketch.Estimate(1));
+  EXPECT_EQ(7, sketch.Estimate(2));
+}
+
+// NOLINTNEXTLINE
+TEST(TinyLfuTest, OneOffPagesStayOnProbation) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  bpm.EnableAdmissionFilter();
+
+  auto one_off_page_ids = CreatePages(&bpm, 8);
+  auto spare_page_id = CreatePages(&bpm, 1)[0];
+  auto hot_page_ids = CreatePages(&bpm, 4);
+  for (auto page_id : hot_page_ids) {
+    Touch(&bpm, page_id, 4);
+  }
+
+  // Every ad-hoc page is read twice, which makes it look more recent than the hot pages to LRU-K. The first one still
+  // takes a regular victim to fill the single frame of the probation area; the others all share that frame.
+  for (auto page_id : one_off_page_ids) {
+    Touch(&bpm, page_id, 2);
+  }
+  EXPECT_EQ(8, bpm.GetAdmissionsRejected());
+  auto misses = bpm.GetStats().misses_;
+  for (size_t i = 1; i < hot_page_ids.size(); i++) {
+    Touch(&bpm, hot_page_ids[i]);
+  }
+  EXPECT_EQ(misses, bpm.GetStats().misses_);
+
+  // A page that became popular while on probation keeps its frame, and the replacer's victim makes room instead.
+  auto popular_page_id = one_off_page_ids.back();
+  Touch(&bpm, popular_page_id, 6);
+  misses = bpm.GetStats().misses_;
+  Touch(&bpm, spare_page_id);
+  EXPECT_EQ(9, bpm.GetAdmissionsRejected());
+  Touch(&bpm, popular_page_id);
+  EXPECT_EQ(misses + 1, bpm.GetStats().misses_);
+  Touch(&bpm, hot_page_ids[1]);
+  EXPECT_EQ(misses + 2, bpm.GetStats().misses_);
+}
+
+// Zipfian point lookups over a table much larger than the pool, with a short ad-hoc scan every now and then. Reports
+// the overall hit ratio with and without the admission filter.
+// NOLINTNEXTLINE
+TEST(TinyLfuTest, DISABLED_ZipfianWithScansBenchmark) {
+  const size_t buffer_pool_size = 128;
+  const size_t num_pages = 4096;
+  const size_t num_lookups = 200000;
+  const size_t lookups_per_scan = 1000;
+  const size_t scan_length = 64;
+
+  std::vector<double> weights(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), 0.9);
+  }
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::ARC}) {
+    for (bool use_filter : {false, true}) {
+      DiskManagerUnlimitedMemory disk_manager;
+      BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, LRUK_REPLACER_K, nullptr, type);
+      if (use_filter) {
+        bpm.EnableAdmissionFilter();
+      }
+      auto page_ids = CreatePages(&bpm, num_pages);
+
+      std::mt19937 gen(0);
+      std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+      std::uniform_int_distribution<size_t> scan_start(0, num_pages - scan_length);
+      auto before = bpm.GetStats();
+      for (size_t i = 0; i < num_lookups; i++) {
+        Touch(&bpm, page_ids[zipf(gen)]);
+        if (i % lookups_per_scan == 0) {
+          auto start = scan_start(gen);
+          for (size_t j = start; j < start + scan_length; j++) {
+            Touch(&bpm, page_ids[j]);
+          }
+        }
+      }
+      auto after = bpm.GetStats();
+      auto hits = after.hits_ - before.hits_;
+      auto misses = after.misses_ - before.misses_;
+      std::cout << fmt::format("replacer={} filter={} hit_ratio={:.4f} rejected={}", ReplacerTypeToString(type),
+                               use_filter ? "tinylfu" : "none",
+                               static_cast<double>(hits) / static_cast<double>(hits + misses),
+                               after.admissions_rejected_)
+                << std::endl;
+    }
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sstream>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -17,8 +18,12 @@
 #include "buffer/buffer_pool_manager_instance.h"
 #include "catalog/catalog.h"
 #include "catalog/table_generator.h"
+#include "common/bustub_instance.h"
 #include "execution/executor_context.h"
+#include "execution/executors/index_scan_executor.h"
+#include "execution/expressions/constant_value_expression.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -688,4 +693,168 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
   remove("catalog_test.log");
 }
 
+// Checks that a hash index over column A holds the tuples with the given rids, and that it takes a new entry
+static void CheckHashIndex(const Schema &table_schema, const std::vector<RID> &rids, Index *index, Transaction *txn) {
+  // The index holds the existing tuples
+  auto key_of = [&](int a) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetIntegerValue(a), ValueFactory::GetIntegerValue(0)}, &table_schema};
+    return tuple.KeyFromTuple(table_schema, *index->GetKeySchema(), index->GetKeyAttrs());
+  };
+  for (int i = 0; i < 3; i++) {
+    std::vector<RID> results{};
+    index->ScanKey(key_of(i), &results, txn);
+    ASSERT_EQ(std::vector<RID>{rids[i]}, results);
+  }
+
+  // Insert and delete an entry
+  RID rid{42, 0};
+  index->InsertEntry(key_of(7), rid, txn);
+  std::vector<RID> results{};
+  index->ScanKey(key_of(7), &results, txn);
+  ASSERT_EQ(std::vector<RID>{rid}, results);
+  index->DeleteEntry(key_of(7), rid, txn);
+  results.clear();
+  index->ScanKey(key_of(7), &results, txn);
+  ASSERT_TRUE(results.empty());
+}
+
+// Should be able to create either kind of hash index over the tuples already in a table, and interact with it
+TEST(CatalogTest, HashIndexInteraction) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  const std::string table_name{"foobar"};
+
+  // Construct a new table with a few tuples
+  std::vector<Column> columns{{"A", TypeId::INTEGER}, {"B", TypeId::INTEGER}};
+  Schema table_schema{columns};
+  auto *table_info = catalog->CreateTable(txn.get(), table_name, table_schema);
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, table_info);
+  std::vector<RID> rids(3);
+  for (int i = 0; i < 3; i++) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i * 10)},
+                &table_schema};
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rids[i], txn.get()));
+  }
+
+  // Construct hash indexes on column A
+  std::vector<Column> key_columns{{"A", TypeId::INTEGER}};
+  std::vector<uint32_t> key_attrs{0};
+  Schema key_schema{key_columns};
+  for (auto index_type : {IndexType::HashTableIndex, IndexType::LinearProbeHashTableIndex}) {
+    auto *index_info = catalog->CreateIndex<GenericKey<4>, RID, GenericComparator<4>>(
+        txn.get(), index_type == IndexType::HashTableIndex ? "index1" : "index2", table_name, table_schema,
+        key_schema, key_attrs, 4, HashFunction<GenericKey<4>>{}, index_type);
+    ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+    EXPECT_EQ(index_type, index_info->index_type_);
+    CheckHashIndex(table_schema, rids, index_info->index_.get(), txn.get());
+  }
+}
+
+// An equality predicate on a column with a hash index is planned as a point lookup, while an order by still needs a
+// B+ tree
+TEST(CatalogTest, HashIndexPointLookupPlan) {
+  BustubInstance bustub;
+  std::stringstream ss;
+  SimpleStreamWriter writer(ss);
+  auto optimized_plan = [&](const std::string &sql) {
+    ss.str("");
+    bustub.ExecuteSql(sql, writer);
+    auto plan = ss.str();
+    return plan.substr(plan.find("=== OPTIMIZER ==="));
+  };
+
+  bustub.ExecuteSql("CREATE TABLE t1(v1 int, v2 int);", writer);
+  bustub.ExecuteSql("CREATE INDEX t1v1 ON t1 USING hash (v1);", writer);
+
+  auto plan = optimized_plan("EXPLAIN SELECT * FROM t1 WHERE v1 = 3;");
+  EXPECT_NE(std::string::npos, plan.find("IndexScan { index_oid=0, pred_key=3 }")) << plan;
+  EXPECT_EQ(std::string::npos, plan.find("Filter")) << plan;
+
+  plan = optimized_plan("EXPLAIN SELECT * FROM t1 WHERE 3 = v1 AND v2 > 1;");
+  EXPECT_NE(std::string::npos, plan.find("IndexScan { index_oid=0, pred_key=3 }")) << plan;
+  EXPECT_NE(std::string::npos, plan.find("Filter")) << plan;
+
+  plan = optimized_plan("EXPLAIN SELECT * FROM t1 WHERE v2 = 3;");
+  EXPECT_EQ(std::string::npos, plan.find("IndexScan")) << plan;
+
+  plan = optimized_plan("EXPLAIN SELECT * FROM t1 ORDER BY v1;");
+  EXPECT_EQ(std::string::npos, plan.find("IndexScan")) << plan;
+
+  // With both kinds of index on a column, the point lookup goes to the hash index
+  bustub.ExecuteSql("CREATE INDEX t1v1_tree ON t1(v1);", writer);
+  plan = optimized_plan("EXPLAIN SELECT * FROM t1 WHERE v1 = 3;");
+  EXPECT_NE(std::string::npos, plan.find("IndexScan { index_oid=0, pred_key=3 }")) << plan;
+  plan = optimized_plan("EXPLAIN SELECT * FROM t1 ORDER BY v1;");
+  EXPECT_NE(std::string::npos, plan.find("IndexScan { index_oid=1 }")) << plan;
+
+  // So does a point lookup on a column with a linear probing hash index, which cannot serve an order by either
+  bustub.ExecuteSql("CREATE INDEX t1v2 ON t1 USING linear_probe (v2);", writer);
+  plan = optimized_plan("EXPLAIN SELECT * FROM t1 WHERE v2 = 5;");
+  EXPECT_NE(std::string::npos, plan.find("IndexScan { index_oid=2, pred_key=5 }")) << plan;
+  plan = optimized_plan("EXPLAIN SELECT * FROM t1 ORDER BY v2;");
+  EXPECT_EQ(std::string::npos, plan.find("IndexScan")) << plan;
+}
+
+// An index scan looks its key up in either kind of index, or walks a B+ tree in key order, and skips deleted tuples
+TEST(CatalogTest, IndexScanExecutor) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+  ExecutorContext exec_ctx(txn.get(), catalog.get(), bpm.get(), nullptr, nullptr);
+
+  const std::string table_name{"foobar"};
+  std::vector<Column> columns{{"A", TypeId::INTEGER}, {"B", TypeId::INTEGER}};
+  auto table_schema = std::make_shared<Schema>(columns);
+  auto *table_info = catalog->CreateTable(txn.get(), table_name, *table_schema);
+  std::vector<RID> rids(10);
+  for (int i = 9; i >= 0; i--) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i % 3)},
+                table_schema.get()};
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rids[i], txn.get()));
+  }
+
+  std::vector<Column> key_columns{{"A", TypeId::INTEGER}};
+  Schema key_schema{key_columns};
+  auto *hash_index = catalog->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
+      txn.get(), "hash", table_name, *table_schema, key_schema, {0}, INTEGER_SIZE, IntegerHashFunctionType{},
+      IndexType::HashTableIndex);
+  auto *tree_index = catalog->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
+      txn.get(), "tree", table_name, *table_schema, key_schema, {0}, INTEGER_SIZE, IntegerHashFunctionType{},
+      IndexType::BPlusTreeIndex);
+
+  auto scan = [&](const IndexInfo *index_info, int key) {
+    AbstractExpressionRef pred_key;
+    if (key >= 0) {
+      pred_key = std::make_shared<ConstantValueExpression>(ValueFactory::GetIntegerValue(key));
+    }
+    IndexScanPlanNode plan(table_schema, index_info->index_oid_, pred_key);
+    IndexScanExecutor executor(&exec_ctx, &plan);
+    executor.Init();
+    std::vector<int> keys;
+    Tuple tuple;
+    RID rid;
+    while (executor.Next(&tuple, &rid)) {
+      EXPECT_EQ(rids[tuple.GetValue(table_schema.get(), 0).GetAs<int32_t>()], rid);
+      keys.push_back(tuple.GetValue(table_schema.get(), 0).GetAs<int32_t>());
+    }
+    return keys;
+  };
+
+  for (const auto *index_info : {hash_index, tree_index}) {
+    EXPECT_EQ(std::vector<int>{3}, scan(index_info, 3));
+    EXPECT_EQ(std::vector<int>{}, scan(index_info, 42));
+  }
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), scan(tree_index, -1));
+  EXPECT_THROW(scan(hash_index, -1), NotImplementedException);
+
+  ASSERT_TRUE(table_info->table_->MarkDelete(rids[3], txn.get()));
+  table_info->table_->ApplyDelete(rids[3], txn.get());
+  EXPECT_EQ(std::vector<int>{}, scan(hash_index, 3));
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 4, 5, 6, 7, 8, 9}), scan(tree_index, -1));
+}
+
 }  // namespace bustub
@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_test.cpp
+//
+// Identification: test/common/crc32c_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+// The test vectors of RFC 3720, appendix B.4.
+// NOLINTNEXTLINE
+TEST(Crc32cTest, KnownValuesTest) {
+  std::string digits = "123456789";
+  std::vector<char> zeros(32, 0);
+  std::vector<char> ones(32, static_cast<char>(0xFF));
+  std::vector<char> ascending(32);
+  for (size_t i = 0; i < ascending.size(); i++) {
+    ascending[i] = static_cast<char>(i);
+  }
+  std::vector<char> descending(ascending.rbegin(), ascending.rend());
+
+  for (bool software : {false, true}) {
+    auto crc = [&](const char *data, size_t length) {
+      return software ? Crc32c::ExtendSoftware(0, data, length) : Crc32c::Value(data, length);
+    };
+    EXPECT_EQ(0xE3069283, crc(digits.data(), digits.size()));
+    EXPECT_EQ(0x8A9136AA, crc(zeros.data(), zeros.size()));
+    EXPECT_EQ(0x62A8AB43, crc(ones.data(), ones.size()));
+    EXPECT_EQ(0x46DD794E, crc(ascending.data(), ascending.size()));
+    EXPECT_EQ(0x113FDB5C, crc(descending.data(), descending.size()));
+    EXPECT_EQ(0, crc(nullptr, 0));
+  }
+}
+
+// Every length and alignment gives the same checksum on both paths, and checksums can be extended piecewise.
+// NOLINTNEXTLINE
+TEST(Crc32cTest, HardwareMatchesSoftwareTest) {
+  std::mt19937 gen(42);
+  std::vector<char> data(3 * BUSTUB_PAGE_SIZE + 64);
+  for (auto &byte : data) {
+    byte = static_cast<char>(gen());
+  }
+
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t length : {0, 1, 7, 8, 9, 63, 767, 768, 769, 1535, 1536, 2304, 4095, 4096, 4097, 3 * 4096}) {
+      auto expected = Crc32c::ExtendSoftware(0, &data[offset], length);
+      EXPECT_EQ(expected, Crc32c::Value(&data[offset], length)) << offset << " " << length;
+      for (size_t split : {size_t{0}, length / 3, length / 2, length}) {
+        auto crc = Crc32c::Extend(0, &data[offset], split);
+        EXPECT_EQ(expected, Crc32c::Extend(crc, &data[offset + split], length - split)) << offset << " " << length;
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(Crc32cTest, DISABLED_ThroughputBenchmark) {
+  const size_t num_pages = 16384;
+  const size_t rounds = 16;
+  std::mt19937 gen(42);
+  std::vector<char> data(num_pages * BUSTUB_PAGE_SIZE);
+  for (auto &byte : data) {
+    byte = static_cast<char>(gen());
+  }
+
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << fmt::format("hardware_accelerated={}", Crc32c::IsHardwareAccelerated()) << std::endl;
+  for (bool software : {false, true}) {
+    uint32_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+      for (size_t i = 0; i < num_pages; i++) {
+        auto *page = &data[i * BUSTUB_PAGE_SIZE];
+        sum += software ? Crc32c::ExtendSoftware(0, page, BUSTUB_PAGE_SIZE) : Crc32c::Value(page, BUSTUB_PAGE_SIZE);
+      }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << fmt::format("crc32c {}: {:.0f} ns/page, {:.2f} GB/s (sum {:x})", software ? "software" : "hardware",
+                             elapsed * 1e9 / (rounds * num_pages), rounds * data.size() / elapsed / 1e9, sum)
+              << std::endl;
+  }
+
+  // What checksums add to a page written to and read from the page cache. The pages are written again in each mode,
+  // since checksums off drops them.
+  remove("test.db");
+  remove("test.log");
+  {
+    DiskManager disk_manager("test.db");
+    for (size_t i = 0; i < num_pages; i++) {
+      disk_manager.WritePage(static_cast<page_id_t>(i), &data[i * BUSTUB_PAGE_SIZE]);
+    }
+    auto buf = std::make_unique<char[]>(BUSTUB_PAGE_SIZE);
+    for (auto mode : {ChecksumMode::OFF, ChecksumMode::VERIFY_ON_READ, ChecksumMode::OFF,
+                      ChecksumMode::VERIFY_ON_READ}) {
+      disk_manager.SetChecksumMode(mode);
+      disk_manager.SyncDatabase();
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < num_pages; i++) {
+        disk_manager.WritePage(static_cast<page_id_t>(i), &data[i * BUSTUB_PAGE_SIZE]);
+      }
+      auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::cout << fmt::format("WritePage checksum={}: {:.0f} ns/page", mode == ChecksumMode::VERIFY_ON_READ,
+                               elapsed * 1e9 / num_pages)
+                << std::endl;
+
+      start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < num_pages; i++) {
+        disk_manager.ReadPage(static_cast<page_id_t>(i), buf.get());
+      }
+      elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::cout << fmt::format("ReadPage verify={}: {:.0f} ns/page", mode == ChecksumMode::VERIFY_ON_READ,
+                               elapsed * 1e9 / num_pages)
+                << std::endl;
+    }
+    disk_manager.ShutDown();
+  }
+  remove("test.db");
+  remove("test.log");
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
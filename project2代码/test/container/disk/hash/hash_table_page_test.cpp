@@ -10,20 +10,28 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <iostream>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
+#include "fmt/core.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/hash_table_block_page.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_header_page.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
+TEST(HashTablePageTest, DirectoryPageSampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -57,7 +65,7 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
+TEST(HashTablePageTest, BucketPageSampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -114,4 +122,180 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, HeaderPageSampleTest) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(5, &disk_manager);
+
+  page_id_t header_page_id = INVALID_PAGE_ID;
+  auto *header_page = reinterpret_cast<HashTableHeaderPage *>(bpm.NewPage(&header_page_id)->GetData());
+  header_page->SetPageId(header_page_id);
+  EXPECT_EQ(header_page_id, header_page->GetPageId());
+  EXPECT_EQ(0, header_page->NumBlocks());
+
+  // the block page ids fill up the rest of the page
+  EXPECT_EQ((BUSTUB_PAGE_SIZE - 32) / sizeof(page_id_t), HashTableHeaderPage::MaxBlocks());
+  for (size_t i = 0; i < HashTableHeaderPage::MaxBlocks(); i++) {
+    header_page->AddBlockPageId(static_cast<page_id_t>(i + 100));
+  }
+  EXPECT_THROW(header_page->AddBlockPageId(0), Exception);
+  EXPECT_EQ(HashTableHeaderPage::MaxBlocks(), header_page->NumBlocks());
+  for (size_t i = 0; i < HashTableHeaderPage::MaxBlocks(); i++) {
+    EXPECT_EQ(static_cast<page_id_t>(i + 100), header_page->GetBlockPageId(i));
+  }
+  header_page->SetSize(42);
+  EXPECT_EQ(42, header_page->GetSize());
+  EXPECT_EQ(header_page_id, header_page->GetPageId());
+
+  bpm.UnpinPage(header_page_id, true);
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BlockPageSampleTest) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(5, &disk_manager);
+
+  page_id_t block_page_id = INVALID_PAGE_ID;
+  auto *block_page =
+      reinterpret_cast<HashTableBlockPage<int, int, IntComparator> *>(bpm.NewPage(&block_page_id)->GetData());
+
+  for (slot_offset_t i = 0; i < 10; i++) {
+    EXPECT_FALSE(block_page->IsOccupied(i));
+    EXPECT_TRUE(block_page->Insert(i, static_cast<int>(i), static_cast<int>(2 * i)));
+    EXPECT_FALSE(block_page->Insert(i, 0, 0));
+    EXPECT_EQ(i, block_page->KeyAt(i));
+    EXPECT_EQ(2 * i, block_page->ValueAt(i));
+  }
+
+  // removed slots stay occupied as tombstones, and take a new pair
+  for (slot_offset_t i = 1; i < 10; i += 2) {
+    block_page->Remove(i);
+  }
+  for (slot_offset_t i = 0; i < 12; i++) {
+    EXPECT_EQ(i < 10, block_page->IsOccupied(i));
+    EXPECT_EQ(i < 10 && i % 2 == 0, block_page->IsReadable(i));
+  }
+  EXPECT_TRUE(block_page->Insert(1, 7, 7));
+  EXPECT_TRUE(block_page->IsReadable(1));
+  EXPECT_EQ(7, block_page->KeyAt(1));
+
+  bpm.UnpinPage(block_page_id, true);
+}
+
+// Fills a bucket of 8-byte keys, so that every probe has to get through a full fingerprint array, then punches
+// tombstones into it and fills them again.
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, FullBucketPageTest) {
+  using BucketPage = HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+  const uint32_t bucket_array_size = 4 * BUSTUB_PAGE_SIZE / (4 * sizeof(std::pair<GenericKey<8>, RID>) + 5);
+
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(5, &disk_manager);
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto *bucket_page = reinterpret_cast<BucketPage *>(bpm.NewPage(&bucket_page_id)->GetData());
+
+  auto key_of = [](int64_t i) {
+    GenericKey<8> key;
+    key.SetFromInteger(i);
+    return key;
+  };
+  for (uint32_t i = 0; i < bucket_array_size; i++) {
+    ASSERT_TRUE(bucket_page->Insert(key_of(i), RID(i), comparator));
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  EXPECT_FALSE(bucket_page->Insert(key_of(bucket_array_size), RID(0), comparator));
+
+  // A second value for a key is kept as long as there is room, the same pair never is.
+  ASSERT_TRUE(bucket_page->Remove(key_of(0), RID(0), comparator));
+  EXPECT_FALSE(bucket_page->Insert(key_of(1), RID(1), comparator));
+  ASSERT_TRUE(bucket_page->Insert(key_of(1), RID(-1), comparator));
+  std::vector<RID> result;
+  ASSERT_TRUE(bucket_page->GetValue(key_of(1), comparator, &result));
+  EXPECT_EQ((std::vector<RID>{RID(-1), RID(1)}), result);
+  ASSERT_TRUE(bucket_page->Remove(key_of(1), RID(-1), comparator));
+
+  // Tombstones are skipped by lookups and reused by inserts.
+  for (uint32_t i = 0; i < bucket_array_size; i += 3) {
+    EXPECT_EQ(i != 0, bucket_page->Remove(key_of(i), RID(i), comparator));
+  }
+  EXPECT_FALSE(bucket_page->IsFull());
+  for (uint32_t i = 0; i < bucket_array_size; i++) {
+    result.clear();
+    EXPECT_EQ(i % 3 != 0, bucket_page->GetValue(key_of(i), comparator, &result));
+    EXPECT_EQ(i % 3 != 0, bucket_page->IsReadable(i));
+    EXPECT_TRUE(bucket_page->IsOccupied(i));
+  }
+  for (uint32_t i = 0; i < bucket_array_size; i += 3) {
+    ASSERT_TRUE(bucket_page->Insert(key_of(i + bucket_array_size), RID(i), comparator));
+    EXPECT_EQ(i, bucket_page->ValueAt(i).GetSlotNum());
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  for (uint32_t i = 0; i < bucket_array_size; i++) {
+    result.clear();
+    ASSERT_TRUE(bucket_page->GetValue(key_of(i % 3 == 0 ? i + bucket_array_size : i), comparator, &result));
+    EXPECT_EQ(std::vector<RID>{RID(i)}, result);
+  }
+
+  bpm.UnpinPage(bucket_page_id, true);
+}
+
+// Looks up every key of a full bucket of 8-byte keys, once through the fingerprints and once by running the comparator
+// on every readable slot, the way lookups worked before buckets kept fingerprints. Reports millions of lookups per
+// second for both.
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, DISABLED_FullBucketLookupBenchmark) {
+  using BucketPage = HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+  const uint32_t bucket_array_size = 4 * BUSTUB_PAGE_SIZE / (4 * sizeof(std::pair<GenericKey<8>, RID>) + 5);
+  const int num_rounds = 2000;
+
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(5, &disk_manager);
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto *bucket_page = reinterpret_cast<BucketPage *>(bpm.NewPage(&bucket_page_id)->GetData());
+  std::vector<GenericKey<8>> keys(bucket_array_size);
+  for (uint32_t i = 0; i < bucket_array_size; i++) {
+    keys[i].SetFromInteger(i);
+    ASSERT_TRUE(bucket_page->Insert(keys[i], RID(i), comparator));
+  }
+
+  auto run = [&](const char *probe, auto &&lookup) {
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < num_rounds; round++) {
+      for (const auto &key : keys) {
+        found += lookup(key);
+      }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(keys.size() * num_rounds, found);
+    std::cout << fmt::format("probe={} slots={} mlookups_per_sec={:.2f}", probe, bucket_array_size,
+                             static_cast<double>(found) / elapsed / 1e6)
+              << std::endl;
+  };
+
+  std::cout << "<<< BEGIN" << std::endl;
+  std::vector<RID> result;
+  run("fingerprint", [&](const GenericKey<8> &key) {
+    result.clear();
+    bucket_page->GetValue(key, comparator, &result);
+    return result.size();
+  });
+  run("comparator", [&](const GenericKey<8> &key) {
+    result.clear();
+    for (uint32_t i = 0; i < bucket_array_size && bucket_page->IsOccupied(i); i++) {
+      if (bucket_page->IsReadable(i) && comparator(key, bucket_page->KeyAt(i)) == 0) {
+        result.push_back(bucket_page->ValueAt(i));
+      }
+    }
+    return result.size();
+  });
+  std::cout << ">>> END" << std::endl;
+
+  bpm.UnpinPage(bucket_page_id, false);
+}
+
 }  // namespace bustub
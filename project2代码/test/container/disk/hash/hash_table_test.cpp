@@ -10,21 +10,31 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
 #include "container/disk/hash/disk_extendible_hash_table.h"
+#include "container/disk/hash/linear_probe_hash_table.h"
+#include "fmt/core.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 
 // NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
   DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
@@ -117,4 +127,209 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowShrinkTest) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(50, &disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), HashFunction<int>());
+
+  // Enough pairs for dozens of buckets, so that buckets split both with and without doubling the directory.
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 42, 42));
+  ht.VerifyIntegrity();
+  auto global_depth = ht.GetGlobalDepth();
+  EXPECT_GE(global_depth, 6);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << "Failed to keep " << i;
+    ASSERT_EQ(std::vector<int>{i}, res);
+  }
+
+  // Removing half of the pairs leaves pairs in every bucket, so nothing merges until the other half goes as well.
+  for (int i = 0; i < num_keys; i += 2) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, i, &res));
+  }
+  for (int i = 1; i < num_keys; i += 2) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  // The table grows again from a single bucket, into the same shape.
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, -i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(global_depth, ht.GetGlobalDepth());
+  std::vector<int> res;
+  ASSERT_TRUE(ht.GetValue(nullptr, 7, &res));
+  EXPECT_EQ(std::vector<int>{-7}, res);
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, FullDirectoryTest) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(50, &disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), HashFunction<int>());
+
+  // All values of one key share a bucket that no split can make room in. Once the directory cannot double anymore,
+  // the insert fails instead of looping.
+  const int bucket_array_size = 4 * BUSTUB_PAGE_SIZE / (4 * sizeof(std::pair<int, int>) + 5);
+  for (int i = 0; i < bucket_array_size; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, 1, i));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 1, bucket_array_size));
+  EXPECT_EQ(9, ht.GetGlobalDepth());
+  ht.VerifyIntegrity();
+  EXPECT_TRUE(ht.Insert(nullptr, 2, 0));
+  std::vector<int> res;
+  ASSERT_TRUE(ht.GetValue(nullptr, 1, &res));
+  EXPECT_EQ(bucket_array_size, res.size());
+
+  // Removing them all merges the split images back, down to a single bucket.
+  for (int i = 0; i < bucket_array_size; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, 1, i));
+  }
+  ASSERT_TRUE(ht.Remove(nullptr, 2, 0));
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+}
+
+// Writers insert and remove their own keys while readers look up keys that never move. Buckets keep splitting in place
+// and merging under the readers.
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentTest) {
+  const int num_writers = 4;
+  const int num_readers = 4;
+  const int num_keys = 5000;
+  const int num_stable_keys = 1000;
+  const int lookups_per_reader = 20000;
+
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(64, &disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), HashFunction<int>());
+  for (int i = 0; i < num_stable_keys; i++) {
+    ht.Insert(nullptr, -i - 1, i);
+  }
+
+  std::atomic<int> lost{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_readers; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<int> dist(0, num_stable_keys - 1);
+      for (int lookup = 0; lookup < lookups_per_reader; lookup++) {
+        auto i = dist(gen);
+        std::vector<int> res;
+        if (!ht.GetValue(nullptr, -i - 1, &res) || res != std::vector<int>{i}) {
+          lost++;
+        }
+      }
+    });
+  }
+  for (int t = 0; t < num_writers; t++) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 2; round++) {
+        for (int i = t; i < num_keys; i += num_writers) {
+          EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        }
+        for (int i = t; i < num_keys; i += num_writers) {
+          std::vector<int> res;
+          EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+          EXPECT_TRUE(ht.Remove(nullptr, i, i));
+        }
+      }
+      for (int i = t; i < num_keys; i += num_writers) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(0, lost);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res));
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+}
+
+// Point lookups of random keys in both hash tables and in a B+ tree over the same keys, with every page in the buffer
+// pool. Reports millions of lookups per second for each.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_PointLookupBenchmark) {
+  const int64_t num_keys = 50000;
+  const size_t num_lookups = 1000000;
+
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  std::vector<GenericKey<8>> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; i++) {
+    keys[i].SetFromInteger(i);
+  }
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int64_t> dist(0, num_keys - 1);
+  std::vector<int64_t> lookups(num_lookups);
+  std::generate(lookups.begin(), lookups.end(), [&] { return dist(gen); });
+
+  auto run = [&](const char *index, auto &&insert, auto &&get_value) {
+    for (int64_t i = 0; i < num_keys; i++) {
+      insert(keys[i], RID(static_cast<page_id_t>(i), 0));
+    }
+    std::vector<RID> result;
+    auto start = std::chrono::steady_clock::now();
+    for (auto i : lookups) {
+      result.clear();
+      get_value(keys[i], &result);
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << fmt::format("index={} keys={} mlookups_per_sec={:.2f}", index, num_keys,
+                             static_cast<double>(num_lookups) / elapsed / 1e6)
+              << std::endl;
+  };
+
+  std::cout << "<<< BEGIN" << std::endl;
+  {
+    DiskManagerUnlimitedMemory disk_manager;
+    BufferPoolManagerInstance bpm(2048, &disk_manager);
+    DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> ht("foo_pk", &bpm, comparator,
+                                                                         HashFunction<GenericKey<8>>());
+    run(
+        "hash", [&](const auto &key, const auto &rid) { ht.Insert(nullptr, key, rid); },
+        [&](const auto &key, auto *result) { ht.GetValue(nullptr, key, result); });
+  }
+  {
+    DiskManagerUnlimitedMemory disk_manager;
+    BufferPoolManagerInstance bpm(2048, &disk_manager);
+    LinearProbeHashTable<GenericKey<8>, RID, GenericComparator<8>> ht("foo_pk", &bpm, comparator, 1,
+                                                                      HashFunction<GenericKey<8>>());
+    run(
+        "linear_probe", [&](const auto &key, const auto &rid) { ht.Insert(nullptr, key, rid); },
+        [&](const auto &key, auto *result) { ht.GetValue(nullptr, key, result); });
+  }
+  {
+    DiskManagerUnlimitedMemory disk_manager;
+    BufferPoolManagerInstance bpm(2048, &disk_manager);
+    page_id_t header_page_id;
+    bpm.NewPage(&header_page_id);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", &bpm, comparator);
+    Transaction transaction(0);
+    run(
+        "bplustree", [&](const auto &key, const auto &rid) { tree.Insert(key, rid, &transaction); },
+        [&](const auto &key, auto *result) { tree.GetValue(key, result, &transaction); });
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
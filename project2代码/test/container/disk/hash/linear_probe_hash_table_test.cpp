@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/disk/hash/linear_probe_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/disk/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, SampleTest) {
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(50, &disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), 10, HashFunction<int>());
+  const size_t block_array_size = 4 * BUSTUB_PAGE_SIZE / (4 * sizeof(std::pair<int, int>) + 1);
+  EXPECT_EQ(block_array_size, ht.GetSize());
+
+  // insert a few values
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(std::vector<int>{i}, res) << "Failed to insert " << i << std::endl;
+  }
+
+  // insert one more value for each key, but never the same pair twice
+  for (int i = 0; i < 5; i++) {
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i + 1));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    std::sort(res.begin(), res.end());
+    EXPECT_EQ((std::vector<int>{i, 2 * i + 1}), res);
+  }
+
+  // remove the first values, which leaves tombstones behind
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(std::vector<int>{2 * i + 1}, res);
+  }
+
+  // look for a key that was never inserted
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 20, &res));
+  EXPECT_FALSE(ht.Remove(nullptr, 20, 20));
+}
+
+// Grows the table from a single block, looking every key up while resizes are migrating, then removes and reinserts
+// keys until the tombstones make the table rebuild itself.
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ResizeTest) {
+  const int num_keys = 20000;
+
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(50, &disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), 1, HashFunction<int>());
+  auto initial_size = ht.GetSize();
+
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    if (i % 2999 == 0) {
+      for (int j = 0; j <= i; j++) {
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, j, &res)) << "Lost " << j << " after inserting " << i;
+        ASSERT_EQ(std::vector<int>{j}, res);
+      }
+    }
+  }
+  auto size = ht.GetSize();
+  EXPECT_GE(size, 4 * initial_size);
+  EXPECT_GE(size * 3, num_keys * 4);
+  EXPECT_FALSE(ht.Insert(nullptr, 0, 0));
+
+  // Churn through keys at a steady count. The tombstones get the table rebuilt, not grown without end.
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < num_keys; i += 2) {
+      ASSERT_TRUE(ht.Remove(nullptr, i + round * num_keys, i + round * num_keys));
+      ASSERT_TRUE(ht.Insert(nullptr, i + (round + 1) * num_keys, i + (round + 1) * num_keys));
+    }
+  }
+  EXPECT_LE(ht.GetSize(), 2 * size);
+  for (int i = 0; i < num_keys; i++) {
+    auto key = i % 2 == 0 ? i + 5 * num_keys : i;
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, key, &res));
+    EXPECT_EQ(std::vector<int>{key}, res);
+  }
+}
+
+// A resize only allocates the new blocks. Until the operations that follow have migrated every old block, keys are
+// found in either, and each is found exactly once.
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, IncrementalResizeTest) {
+  const int num_keys = 2000;
+
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(50, &disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), 4000, HashFunction<int>());
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  auto size = ht.GetSize();
+  ht.Resize(size);
+  EXPECT_GE(ht.GetSize(), 2 * size);
+
+  // Every remove migrates a few blocks, whether or not it finds its pair.
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(std::vector<int>{i}, res);
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, -1, -1));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    ASSERT_FALSE(ht.GetValue(nullptr, i, &res));
+  }
+}
+
+// Writers insert and remove their own keys while readers look up keys that never change, all while the table keeps
+// resizing under them.
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentTest) {
+  const int num_writers = 4;
+  const int num_readers = 4;
+  const int num_keys = 5000;
+  const int num_stable_keys = 1000;
+  const int lookups_per_reader = 20000;
+
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(64, &disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", &bpm, IntComparator(), 1, HashFunction<int>());
+  for (int i = 0; i < num_stable_keys; i++) {
+    ht.Insert(nullptr, -i - 1, i);
+  }
+
+  std::atomic<int> lost{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_readers; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<int> dist(0, num_stable_keys - 1);
+      for (int lookup = 0; lookup < lookups_per_reader; lookup++) {
+        auto i = dist(gen);
+        std::vector<int> res;
+        if (!ht.GetValue(nullptr, -i - 1, &res) || res != std::vector<int>{i}) {
+          lost++;
+        }
+      }
+    });
+  }
+  for (int t = 0; t < num_writers; t++) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 2; round++) {
+        for (int i = t; i < num_keys; i += num_writers) {
+          EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        }
+        for (int i = t; i < num_keys; i += num_writers) {
+          std::vector<int> res;
+          EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+          EXPECT_TRUE(ht.Remove(nullptr, i, i));
+        }
+      }
+      for (int i = t; i < num_keys; i += num_writers) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+      }
+    });
+  }
+  // Every thread inserts the same pairs, and only one of them may succeed for each.
+  std::atomic<int> duplicates_inserted{0};
+  for (int t = 0; t < num_writers; t++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < num_keys; i++) {
+        if (ht.Insert(nullptr, num_keys + i, i)) {
+          duplicates_inserted++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(0, lost);
+  EXPECT_EQ(num_keys, duplicates_inserted);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res));
+    EXPECT_EQ(std::vector<int>{i}, res);
+    res.clear();
+    ASSERT_TRUE(ht.GetValue(nullptr, num_keys + i, &res));
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+}
+
+}  // namespace bustub
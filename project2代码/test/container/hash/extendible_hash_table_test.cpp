@@ -73,10 +73,17 @@
  * extendible_hash_test.cpp
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <mutex>  // NOLINT
 #include <random>
 #include <thread>  // NOLINT
 
+#include "common/config.h"
 #include "container/hash/extendible_hash_table.h"
+#include "fmt/core.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -754,4 +761,285 @@ TEST(ExtendibleHashTableTest, IntegratedTest) {
     ASSERT_FALSE(table->Remove(i));
   }
 }
+
+TEST(ExtendibleHashTableTest, ShrinkOnRemove) {
+  auto table = std::make_unique<ExtendibleHashTable<int, int>>(4);
+  auto empty_usage = table->GetMemoryUsage();
+
+  for (int i = 0; i < 1000; i++) {
+    table->Insert(i, i);
+  }
+  ASSERT_EQ(8, table->GetGlobalDepth());
+  auto peak_usage = table->GetMemoryUsage();
+  ASSERT_GT(peak_usage, 50 * empty_usage);
+
+  // The 256 buckets hold the keys that are equal modulo 256. Removing the keys from 256 to 511 and from 768 on leaves
+  // two keys in every bucket, four in every pair of buddies, which is too many to merge.
+  ASSERT_EQ(256, table->GetNumBuckets());
+  for (int i = 0; i < 1000; i++) {
+    if ((i / 256) % 2 == 1) {
+      ASSERT_TRUE(table->Remove(i));
+    }
+  }
+  ASSERT_EQ(256, table->GetNumBuckets());
+  ASSERT_EQ(8, table->GetGlobalDepth());
+
+  // Once they are emptied, buddies merge level by level, and the directory follows them down, keeping one level to
+  // spare.
+  for (int i = 0; i < 1000; i++) {
+    if ((i / 256) % 2 == 0) {
+      ASSERT_TRUE(table->Remove(i));
+    }
+  }
+  ASSERT_EQ(1, table->GetNumBuckets());
+  ASSERT_EQ(1, table->GetGlobalDepth());
+  ASSERT_EQ(0, table->GetLocalDepth(0));
+  ASSERT_EQ(0, table->GetLocalDepth(1));
+  ASSERT_LT(table->GetMemoryUsage(), 2 * empty_usage);
+
+  for (int i = 0; i < 1000; i++) {
+    table->Insert(i, -i);
+  }
+  for (int i = 0; i < 1000; i++) {
+    int value;
+    ASSERT_TRUE(table->Find(i, value));
+    ASSERT_EQ(-i, value);
+  }
+}
+
+TEST(ExtendibleHashTableTest, NoSplitMergeFlapping) {
+  auto table = std::make_unique<ExtendibleHashTable<int, int>>(4);
+
+  // Bucket 0 splits on the fifth key into buckets 0 and 1, with three and two keys.
+  for (int i = 0; i < 5; i++) {
+    table->Insert(i, i);
+  }
+  ASSERT_EQ(2, table->GetNumBuckets());
+
+  // Taking the fifth key out and putting it back neither merges the buckets nor splits them again.
+  for (int round = 0; round < 100; round++) {
+    ASSERT_TRUE(table->Remove(4));
+    ASSERT_EQ(2, table->GetNumBuckets());
+    table->Insert(4, 4);
+    ASSERT_EQ(2, table->GetNumBuckets());
+  }
+
+  // Down to two keys, the buddies merge.
+  ASSERT_TRUE(table->Remove(4));
+  ASSERT_TRUE(table->Remove(3));
+  ASSERT_EQ(2, table->GetNumBuckets());
+  ASSERT_TRUE(table->Remove(2));
+  ASSERT_EQ(1, table->GetNumBuckets());
+  ASSERT_EQ(1, table->GetGlobalDepth());
+}
+
+TEST(ExtendibleHashTableTest, ConcurrentFindDuringSplitsAndMerges) {
+  const int num_keys = 1000;
+  const int num_writers = 4;
+  const int num_readers = 4;
+  const int inserts_per_writer = 5000;
+
+  auto table = std::make_unique<ExtendibleHashTable<int, int>>(4);
+  for (int i = 0; i < num_keys; i++) {
+    table->Insert(i, -i);
+  }
+
+  // The readers keep looking up keys that are in the table all along, while the writers split buckets and double the
+  // directory underneath them, then merge the buckets and halve the directory again.
+  std::atomic<bool> done{false};
+  std::atomic<int> misses{0};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < num_readers; tid++) {
+    readers.emplace_back([tid, &table, &done, &misses]() {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<> dis(0, num_keys - 1);
+      while (!done) {
+        int key = dis(gen);
+        int value;
+        if (!table->Find(key, value) || value != -key) {
+          misses++;
+        }
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (int tid = 0; tid < num_writers; tid++) {
+    writers.emplace_back([tid, &table]() {
+      int first = num_keys + tid * inserts_per_writer;
+      for (int i = first; i < first + inserts_per_writer; i++) {
+        table->Insert(i, -i);
+        if (i % 2 == 0) {
+          table->Remove(i);
+        }
+      }
+      for (int i = first + 1; i < first + inserts_per_writer; i += 2) {
+        table->Remove(i);
+      }
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(0, misses);
+
+  for (int i = 0; i < num_keys + num_writers * inserts_per_writer; i++) {
+    int value;
+    ASSERT_EQ(i < num_keys, table->Find(i, value));
+  }
+  // Every bucket is counted once: a bucket of local depth d fills 2^(global depth - d) slots.
+  int num_buckets = 0;
+  for (int i = 0; i < (1 << table->GetGlobalDepth()); i++) {
+    if (i < (1 << table->GetLocalDepth(i))) {
+      num_buckets++;
+    }
+  }
+  ASSERT_EQ(num_buckets, table->GetNumBuckets());
+}
+
+/** The same table behind one latch, the way the table was latched before buckets had latches of their own. */
+class SingleLatchHashTable : public HashTable<int, int> {
+ public:
+  explicit SingleLatchHashTable(size_t bucket_size) : table_(bucket_size) {}
+
+  auto Find(const int &key, int &value) -> bool override {
+    std::scoped_lock<std::mutex> lock(latch_);
+    return table_.Find(key, value);
+  }
+
+  auto Remove(const int &key) -> bool override {
+    std::scoped_lock<std::mutex> lock(latch_);
+    return table_.Remove(key);
+  }
+
+  void Insert(const int &key, const int &value) override {
+    std::scoped_lock<std::mutex> lock(latch_);
+    table_.Insert(key, value);
+  }
+
+ private:
+  std::mutex latch_;
+  ExtendibleHashTable<int, int> table_;
+};
+
+// A page-table-like workload: 95% lookups of resident keys, 5% evictions that remove a key and insert another one.
+// Reports millions of operations per second with a table latch and with bucket latches.
+TEST(ExtendibleHashTableTest, DISABLED_FindHeavyBenchmark) {
+  const int num_keys = 100000;
+  const size_t total_ops = 4000000;
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (bool bucket_latches : {false, true}) {
+    for (size_t num_threads : {1, 8, 64}) {
+      std::unique_ptr<HashTable<int, int>> table;
+      if (bucket_latches) {
+        table = std::make_unique<ExtendibleHashTable<int, int>>(8);
+      } else {
+        table = std::make_unique<SingleLatchHashTable>(8);
+      }
+      for (int i = 0; i < num_keys; i++) {
+        table->Insert(i, i);
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+          std::mt19937 gen(t);
+          std::uniform_int_distribution<> key_dis(0, num_keys - 1);
+          std::uniform_int_distribution<> op_dis(0, 99);
+          // Each thread churns its own keys, so that every key it finds is still there.
+          int next_key = num_keys + static_cast<int>(t) * static_cast<int>(total_ops);
+          for (size_t i = 0; i < total_ops / num_threads; i++) {
+            int value;
+            if (op_dis(gen) < 95) {
+              table->Find(key_dis(gen), value);
+            } else {
+              table->Insert(next_key, next_key);
+              table->Remove(next_key);
+              next_key++;
+            }
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::cout << fmt::format("latch={} threads={} mops_per_sec={:.2f}", bucket_latches ? "bucket" : "table",
+                               num_threads, static_cast<double>(total_ops) / elapsed / 1e6)
+                << std::endl;
+    }
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+// One million inserts, hits, misses and removes, once with random int keys and once with the dense page ids a page
+// table maps to frame ids, for the bucket size of the page table and for the default one. Reports millions of
+// operations per second for each phase, and the memory footprint of the table when full and once emptied again.
+TEST(ExtendibleHashTableTest, DISABLED_MillionEntriesBenchmark) {
+  const int num_entries = 1000000;
+
+  std::mt19937 gen(0);
+  std::vector<int> random_keys(2 * num_entries);
+  for (auto &key : random_keys) {
+    key = static_cast<int>(gen());
+  }
+  std::vector<page_id_t> page_ids(2 * num_entries);
+  for (int i = 0; i < 2 * num_entries; i++) {
+    page_ids[i] = i;
+  }
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t bucket_size : {static_cast<size_t>(4), static_cast<size_t>(BUCKET_SIZE)}) {
+    for (auto *keys : {&random_keys, &page_ids}) {
+      // The first half of the keys goes into the table, the second half is looked up but never inserted.
+      std::vector<int> lookups(keys->begin(), keys->begin() + num_entries);
+      std::shuffle(lookups.begin(), lookups.end(), gen);
+      ExtendibleHashTable<int, int> table(bucket_size);
+      auto time = [](auto &&phase) {
+        auto start = std::chrono::steady_clock::now();
+        phase();
+        return static_cast<double>(num_entries) /
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 1e6;
+      };
+
+      auto insert_mops = time([&]() {
+        for (int i = 0; i < num_entries; i++) {
+          table.Insert((*keys)[i], i);
+        }
+      });
+      int found = 0;
+      auto hit_mops = time([&]() {
+        int value;
+        for (auto key : lookups) {
+          found += static_cast<int>(table.Find(key, value));
+        }
+      });
+      auto miss_mops = time([&]() {
+        int value;
+        for (int i = num_entries; i < 2 * num_entries; i++) {
+          found += static_cast<int>(table.Find((*keys)[i], value));
+        }
+      });
+      EXPECT_GE(found, num_entries);
+      auto peak_kib = table.GetMemoryUsage() / 1024;
+      auto remove_mops = time([&]() {
+        for (auto key : lookups) {
+          table.Remove(key);
+        }
+      });
+      std::cout << fmt::format(
+                       "keys={} bucket_size={} insert_mops={:.2f} hit_mops={:.2f} miss_mops={:.2f} remove_mops={:.2f} "
+                       "peak_kib={} empty_kib={}",
+                       keys == &page_ids ? "page_ids" : "random", bucket_size, insert_mops, hit_mops, miss_mops,
+                       remove_mops, peak_kib, table.GetMemoryUsage() / 1024)
+                << std::endl;
+    }
+  }
+  std::cout << ">>> END" << std::endl;
+}
 }  // namespace bustub
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager_test.cpp
+//
+// Identification: test/storage/async_disk_manager_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Every test runs once with io_uring, where the kernel has it, and once with the thread pool. */
+class AsyncDiskManagerTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+  }
+
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+  };
+
+  auto MakeDiskManager(size_t queue_depth) -> std::unique_ptr<AsyncDiskManager> {
+    auto disk_manager = std::make_unique<AsyncDiskManager>("test.db", queue_depth, GetParam());
+    if (!GetParam()) {
+      EXPECT_EQ(AsyncIoEngine::THREAD_POOL, disk_manager->GetEngine());
+    }
+    return disk_manager;
+  }
+};
+
+// A batch larger than the queue depth, of writes and then of reads, completes in full.
+// NOLINTNEXTLINE
+TEST_P(AsyncDiskManagerTest, BatchTest) {
+  const size_t num_pages = 100;
+  auto dm = MakeDiskManager(8);
+
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(BUSTUB_PAGE_SIZE));
+  std::vector<DiskRequest> requests(num_pages);
+  std::vector<std::future<bool>> futures;
+  for (size_t i = 0; i < num_pages; i++) {
+    std::memset(data[i].data(), static_cast<int>(i), BUSTUB_PAGE_SIZE);
+    requests[i] = {true, data[i].data(), static_cast<page_id_t>(i), {}};
+    futures.push_back(requests[i].callback_.get_future());
+  }
+  dm->Schedule(&requests);
+  for (auto &future : futures) {
+    EXPECT_TRUE(future.get());
+  }
+  EXPECT_EQ(static_cast<int>(num_pages), dm->GetNumWrites());
+
+  std::vector<std::vector<char>> buf(num_pages, std::vector<char>(BUSTUB_PAGE_SIZE));
+  requests = std::vector<DiskRequest>(num_pages);
+  futures.clear();
+  for (size_t i = 0; i < num_pages; i++) {
+    requests[i] = {false, buf[i].data(), static_cast<page_id_t>(i), {}};
+    futures.push_back(requests[i].callback_.get_future());
+  }
+  dm->Schedule(&requests);
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_TRUE(futures[i].get());
+    EXPECT_EQ(data[i], buf[i]) << i;
+  }
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_P(AsyncDiskManagerTest, SinglePageTest) {
+  char buf[BUSTUB_PAGE_SIZE];
+  char zeros[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::strncpy(data, "A test string.", sizeof(data));
+  auto dm = MakeDiskManager(4);
+
+  EXPECT_TRUE(dm->WritePageAsync(3, data).get());
+  std::memset(buf, 'x', sizeof(buf));
+  EXPECT_TRUE(dm->ReadPageAsync(3, buf).get());
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+
+  // A page that was never written reads as zeros, before or past the end of the file
+  std::memset(buf, 'x', sizeof(buf));
+  EXPECT_TRUE(dm->ReadPageAsync(1, buf).get());
+  EXPECT_EQ(0, std::memcmp(buf, zeros, sizeof(buf)));
+  std::memset(buf, 'x', sizeof(buf));
+  EXPECT_TRUE(dm->ReadPageAsync(100, buf).get());
+  EXPECT_EQ(0, std::memcmp(buf, zeros, sizeof(buf)));
+
+  // The synchronous calls see the same file
+  dm->ReadPage(3, buf);
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+
+  // A page past 4 GiB
+  EXPECT_TRUE(dm->WritePageAsync(1048576 + 3, data).get());
+  std::memset(buf, 'x', sizeof(buf));
+  EXPECT_TRUE(dm->ReadPageAsync(1048576 + 3, buf).get());
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+  dm->ShutDown();
+}
+
+// Many threads schedule writes and reads of their own pages into one manager.
+// NOLINTNEXTLINE
+TEST_P(AsyncDiskManagerTest, ConcurrentTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  auto dm = MakeDiskManager(16);
+
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(num_threads, 0);
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::vector<std::vector<char>> data(pages_per_thread, std::vector<char>(BUSTUB_PAGE_SIZE));
+      std::vector<std::vector<char>> buf(pages_per_thread, std::vector<char>(BUSTUB_PAGE_SIZE));
+      for (bool is_write : {true, false}) {
+        std::vector<DiskRequest> requests(pages_per_thread);
+        std::vector<std::future<bool>> futures;
+        for (int i = 0; i < pages_per_thread; i++) {
+          std::memset(data[i].data(), t * pages_per_thread + i, BUSTUB_PAGE_SIZE);
+          requests[i] = {is_write, is_write ? data[i].data() : buf[i].data(), i * num_threads + t, {}};
+          futures.push_back(requests[i].callback_.get_future());
+        }
+        dm->Schedule(&requests);
+        for (auto &future : futures) {
+          future.wait();
+        }
+      }
+      for (int i = 0; i < pages_per_thread; i++) {
+        mismatches[t] += data[i] != buf[i] ? 1 : 0;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < num_threads; t++) {
+    EXPECT_EQ(0, mismatches[t]);
+  }
+  dm->ShutDown();
+}
+
+// The buffer pool writes back and reads in its pages through the manager's queue.
+// NOLINTNEXTLINE
+TEST_P(AsyncDiskManagerTest, BufferPoolTest) {
+  const size_t pool_size = 16;
+  const int num_pages = 200;
+  auto dm = MakeDiskManager(8);
+  {
+    BufferPoolManagerInstance bpm(pool_size, dm.get());
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      auto *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      std::snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      bpm.UnpinPage(page_id, true);
+    }
+    for (page_id_t page_id = 0; page_id < num_pages; page_id += 5) {
+      bpm.PrefetchPage(page_id);
+    }
+    bpm.FlushAllPages();
+    EXPECT_GE(dm->GetNumSyncs(), 1);
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      auto *page = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      bpm.UnpinPage(page_id, false);
+    }
+  }
+  dm->ShutDown();
+}
+
+// A read of a page that was corrupted on disk completes with false.
+// NOLINTNEXTLINE
+TEST_P(AsyncDiskManagerTest, ChecksumTest) {
+  char buf[BUSTUB_PAGE_SIZE];
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::strncpy(data, "A test string.", sizeof(data));
+  auto dm = MakeDiskManager(4);
+  EXPECT_TRUE(dm->WritePageAsync(3, data).get());
+  EXPECT_TRUE(dm->WritePageAsync(4, data).get());
+
+  int fd = open("test.db", O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(1, pwrite(fd, "!", 1, DiskManager::PageOffset(3)));
+  close(fd);
+
+  EXPECT_FALSE(dm->ReadPageAsync(3, buf).get());
+  EXPECT_TRUE(dm->ReadPageAsync(4, buf).get());
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+  EXPECT_EQ(std::vector<page_id_t>{3}, dm->GetCorruptPages());
+  dm->ShutDown();
+}
+
+INSTANTIATE_TEST_SUITE_P(AsyncDiskManagerTest, AsyncDiskManagerTest, ::testing::Bool(),
+                         [](const ::testing::TestParamInfo<bool> &info) {
+                           return info.param ? "IoUring" : "ThreadPool";
+                         });
+
+}  // namespace bustub
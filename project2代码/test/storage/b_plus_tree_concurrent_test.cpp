@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -333,4 +334,88 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+// Merges free pages while optimistic readers may be on their way into them, and splits reuse the freed ids right away.
+// The readers must keep finding every key that is never removed. With swizzling, the readers also read pages without
+// pinning them, while the small pool keeps reusing their frames.
+void MixedReuseCall(bool swizzle) {
+  const int64_t num_stable_keys = 500;
+  const int num_rounds = 10;
+  const uint64_t num_writers = 4;
+  const uint64_t num_readers = 4;
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm_instance = new BufferPoolManagerInstance(64, disk_manager);
+  if (swizzle) {
+    bpm_instance->EnableSwizzling();
+  }
+  BufferPoolManager *bpm = bpm_instance;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  // The even keys stay, the odd ones come and go
+  std::vector<int64_t> stable_keys;
+  for (int64_t key = 0; key < 2 * num_stable_keys; key += 2) {
+    stable_keys.push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  std::atomic<uint64_t> writers_done{0};
+  std::atomic<int64_t> lookups_failed{0};
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < num_writers; i++) {
+    threads.emplace_back([&, i] {
+      std::vector<int64_t> keys;
+      for (int64_t key = 2 * static_cast<int64_t>(i) + 1; key < 2 * num_stable_keys; key += 2 * num_writers) {
+        keys.push_back(key);
+      }
+      for (int round = 0; round < num_rounds; round++) {
+        InsertHelper(&tree, keys);
+        DeleteHelper(&tree, keys);
+      }
+      writers_done++;
+    });
+  }
+  for (uint64_t i = 0; i < num_readers; i++) {
+    threads.emplace_back([&] {
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      // The odd keys lead the readers into the leaves that are being merged away
+      while (writers_done.load() < num_writers) {
+        for (int64_t key = 0; key < 2 * num_stable_keys; key++) {
+          rids.clear();
+          index_key.SetFromInteger(key);
+          auto found = tree.GetValue(index_key, &rids);
+          if (key % 2 == 0 && (!found || rids.size() != 1 || rids[0].GetSlotNum() != key)) {
+            lookups_failed++;
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, lookups_failed.load());
+
+  int64_t expected_key = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(expected_key, (*iterator).second.GetSlotNum());
+    expected_key += 2;
+  }
+  EXPECT_EQ(2 * num_stable_keys, expected_key);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, MixedReuseTest) { MixedReuseCall(false); }
+
+TEST(BPlusTreeConcurrentTest, MixedReuseSwizzledTest) { MixedReuseCall(true); }
+
 }  // namespace bustub
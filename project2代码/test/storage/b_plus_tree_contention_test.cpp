@@ -7,6 +7,7 @@
 #include <functional>
 #include <future>  // NOLINT
 #include <iostream>
+#include <random>
 #include <thread>  // NOLINT
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -74,6 +75,70 @@ bool BPlusTreeLockBenchmarkCall(size_t num_threads, int leaf_node_size, bool wit
   return success;
 }
 
+/**
+ * Look up random keys from num_threads threads, each doing the same number of lookups. The whole tree fits in the
+ * buffer pool.
+ * @param swizzle true to enable pointer swizzling in the buffer pool
+ * @return the total number of lookups per millisecond
+ */
+auto BPlusTreeReadBenchmarkCall(size_t num_threads, bool swizzle = false) -> double {
+  const int64_t num_keys = 10000;
+  const int lookups_per_thread = 200000;
+
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerMemory(256 << 10);  // 1GB
+  auto *bpm = new BufferPoolManagerInstance(1024, disk_manager);
+  if (swizzle) {
+    bpm->EnableSwizzling();
+  }
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 32, 32);
+  page_id_t page_id;
+  auto *header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  auto *transaction = new Transaction(0);
+  GenericKey<8> index_key;
+  RID rid;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  delete transaction;
+
+  std::vector<std::thread> threads;
+  std::atomic<bool> all_found{true};
+  auto clock_start = std::chrono::system_clock::now();
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&tree, &all_found, i]() {
+      std::mt19937_64 rng(i);
+      std::uniform_int_distribution<int64_t> dist(0, num_keys - 1);
+      GenericKey<8> index_key;
+      std::vector<RID> result;
+      for (int n = 0; n < lookups_per_thread; n++) {
+        index_key.SetFromInteger(dist(rng));
+        result.clear();
+        if (!tree.GetValue(index_key, &result)) {
+          all_found = false;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::system_clock::now();
+  EXPECT_TRUE(all_found);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+
+  auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(clock_end - clock_start).count();
+  return static_cast<double>(num_threads * lookups_per_thread) / std::max<int64_t>(dur, 1);
+}
+
 TEST(BPlusTreeTest, BPlusTreeContentionBenchmark) {  // NOLINT
   std::vector<size_t> time_ms_with_mutex;
   std::vector<size_t> time_ms_wo_mutex;
@@ -155,4 +220,42 @@ TEST(BPlusTreeTest, DISABLED_BPlusTreeContentionBenchmark2) {  // NOLINT
             << std::endl;
 }
 
+// Read-only lookups go down the tree with optimistic latches; throughput should grow with the number of threads up to
+// the number of cores.
+// Without swizzling every level is fetched and pinned under the buffer pool latch; with it, lookups of resident pages
+// touch no shared lock at all and should scale with the number of cores.
+TEST(BPlusTreeTest, DISABLED_BPlusTreeReadScalingBenchmark) {  // NOLINT
+  const size_t max_threads = std::max(1U, std::thread::hardware_concurrency());
+  std::cout << "<<< BEGIN READ SCALING" << std::endl;
+  for (bool swizzle : {false, true}) {
+    double single_thread = 0;
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+      auto throughput = BPlusTreeReadBenchmarkCall(num_threads, swizzle);
+      if (num_threads == 1) {
+        single_thread = throughput;
+      }
+      std::cout << (swizzle ? "Swizzled " : "Page table ") << "Threads: " << num_threads
+                << " Lookups/ms: " << throughput << " Speedup: " << throughput / single_thread << std::endl;
+    }
+  }
+  std::cout << ">>> END READ SCALING" << std::endl;
+}
+
+// In-memory point lookups with and without pointer swizzling, from a single thread so that only the cost of
+// turning child page ids into frames differs.
+TEST(BPlusTreeTest, DISABLED_BPlusTreeSwizzlingBenchmark) {  // NOLINT
+  const int rounds = 3;
+  double plain = 0;
+  double swizzled = 0;
+  for (int i = 0; i < rounds; i++) {
+    plain += BPlusTreeReadBenchmarkCall(1, false);
+    swizzled += BPlusTreeReadBenchmarkCall(1, true);
+  }
+  std::cout << "<<< BEGIN SWIZZLING" << std::endl;
+  std::cout << "Page table Lookups/ms: " << plain / rounds << std::endl;
+  std::cout << "Swizzled Lookups/ms: " << swizzled / rounds << std::endl;
+  std::cout << "Speedup: " << swizzled / plain << std::endl;
+  std::cout << ">>> END SWIZZLING" << std::endl;
+}
+
 }  // namespace bustub
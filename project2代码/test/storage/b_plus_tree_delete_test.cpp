@@ -10,8 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/stat.h>
 #include <algorithm>
 #include <cstdio>
+#include <numeric>
+#include <random>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
@@ -163,4 +166,69 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+// Filling and emptying the tree over and over reuses the pages freed by merges, so the file stops growing after the
+// first round, and shrinks once the tree is empty.
+TEST(BPlusTreeTests, InsertDeleteSoakTest) {
+  const int num_rounds = 20;
+  const int64_t num_keys = 3000;
+  remove("test.db");
+  remove("test.log");
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 8, 8);
+  GenericKey<8> index_key;
+  RID rid;
+  auto *transaction = new Transaction(0);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  std::vector<int64_t> keys(num_keys);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::mt19937 gen(0);
+  page_id_t high_water_mark = INVALID_PAGE_ID;
+  off_t file_size = 0;
+  struct stat stat_buf;
+  for (int round = 0; round < num_rounds; round++) {
+    std::shuffle(keys.begin(), keys.end(), gen);
+    for (auto key : keys) {
+      rid.Set(0, key);
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+    std::shuffle(keys.begin(), keys.end(), gen);
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+    ASSERT_TRUE(tree.IsEmpty());
+    bpm->FlushAllPages();
+    ASSERT_EQ(0, stat("test.db", &stat_buf));
+    if (round == 0) {
+      high_water_mark = disk_manager->GetHighWaterMark();
+      file_size = stat_buf.st_size;
+      EXPECT_GT(high_water_mark, num_keys / 8);
+    }
+    // Only the header page stays allocated. Every round reuses the pages freed by the ones before, and only grows the
+    // file when its shape needs a few pages more than any round before it did.
+    EXPECT_EQ(disk_manager->GetHighWaterMark() - 1, disk_manager->GetNumFreePages()) << round;
+    EXPECT_LT(disk_manager->GetHighWaterMark(), high_water_mark + high_water_mark / 10) << round;
+    EXPECT_LE(stat_buf.st_size, 2 * file_size) << round;
+  }
+
+  EXPECT_GT(disk_manager->ShrinkFile(), 0);
+  EXPECT_EQ(1, disk_manager->GetHighWaterMark());
+  ASSERT_EQ(0, stat("test.db", &stat_buf));
+  EXPECT_EQ(DiskManager::PageOffset(HEADER_PAGE_ID) + BUSTUB_PAGE_SIZE, stat_buf.st_size);
+
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
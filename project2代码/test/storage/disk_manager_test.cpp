@@ -10,7 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>  // NOLINT
 #include <cstring>
+#include <fstream>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -31,6 +39,17 @@ class DiskManagerTest : public ::testing::Test {
     remove("test.db");
     remove("test.log");
   };
+
+  // Flip the bits of one byte of a page behind the manager's back.
+  static void CorruptPage(const std::string &db_file, page_id_t page_id) {
+    int fd = open(db_file.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    char byte;
+    ASSERT_EQ(1, pread(fd, &byte, 1, DiskManager::PageOffset(page_id) + 100));
+    byte = static_cast<char>(~byte);
+    ASSERT_EQ(1, pwrite(fd, &byte, 1, DiskManager::PageOffset(page_id) + 100));
+    close(fd);
+  }
 };
 
 // NOLINTNEXTLINE
@@ -55,6 +74,448 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadPastEndTest) {
+  char buf[BUSTUB_PAGE_SIZE];
+  char zeros[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  // A page that was never written reads as zeros, even past the end of the file
+  dm.WritePage(1, data);
+  std::memset(buf, 'x', sizeof(buf));
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, zeros, sizeof(buf)), 0);
+  std::memset(buf, 'x', sizeof(buf));
+  dm.ReadPage(7, buf);
+  EXPECT_EQ(std::memcmp(buf, zeros, sizeof(buf)), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SyncAndReopenTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      std::memset(data, 'a' + page_id, sizeof(data));
+      dm.WritePage(page_id, data);
+    }
+    EXPECT_EQ(0, dm.GetNumSyncs());
+    dm.SyncDatabase();
+    EXPECT_EQ(1, dm.GetNumSyncs());
+    dm.ShutDown();
+  }
+
+  // The pages are still there when the file is opened again
+  auto dm = DiskManager(db_file);
+  for (page_id_t page_id = 7; page_id >= 0; page_id--) {
+    std::memset(data, 'a' + page_id, sizeof(data));
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  }
+  dm.ShutDown();
+}
+
+// Every thread writes and reads back its own pages, interleaved with the pages of the others in the file.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  const int num_rounds = 4;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(num_threads, 0);
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      char data[BUSTUB_PAGE_SIZE];
+      char buf[BUSTUB_PAGE_SIZE];
+      for (int round = 0; round < num_rounds; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + t;
+          std::memset(data, page_id + round, sizeof(data));
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          mismatches[t] += std::memcmp(buf, data, sizeof(buf)) != 0 ? 1 : 0;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < num_threads; t++) {
+    EXPECT_EQ(0, mismatches[t]);
+  }
+  EXPECT_EQ(num_threads * pages_per_thread * num_rounds, dm.GetNumWrites());
+
+  char data[BUSTUB_PAGE_SIZE];
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_threads * pages_per_thread; page_id++) {
+    std::memset(data, page_id + num_rounds - 1, sizeof(data));
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0) << page_id;
+  }
+  dm.ShutDown();
+}
+
+// Pages past 2 GiB and 4 GiB keep their offsets, and the jumps to them leave holes rather than allocated space.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeFileTest) {
+  const std::vector<page_id_t> page_ids = {0, 1, 2, 524287, 524288, 1048575, 1048576, 1048576 + 12345};
+  std::string db_file("test.db");
+  char data[BUSTUB_PAGE_SIZE];
+  char buf[BUSTUB_PAGE_SIZE];
+  {
+    auto dm = DiskManager(db_file);
+    for (auto page_id : page_ids) {
+      std::memset(data, page_id % 251, sizeof(data));
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+    for (auto page_id : page_ids) {
+      std::memset(data, page_id % 251, sizeof(data));
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.ReadPage(page_id, buf);
+      EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0) << page_id;
+    }
+    dm.ShutDown();
+  }
+
+  // The file ends at its last page, and only the chunks around the written pages take up space
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_file.c_str(), &stat_buf));
+  EXPECT_EQ(DiskManager::PageOffset(page_ids.back()) + BUSTUB_PAGE_SIZE, stat_buf.st_size);
+  EXPECT_LT(static_cast<int64_t>(stat_buf.st_blocks) * 512, 64 << 20);
+
+  auto dm = DiskManager(db_file);
+  for (auto page_id : page_ids) {
+    std::memset(data, page_id % 251, sizeof(data));
+    std::memcpy(data, &page_id, sizeof(page_id));
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0) << page_id;
+  }
+  dm.ReadPage(1048000, buf);
+  EXPECT_EQ(0, buf[0]);
+  dm.ShutDown();
+}
+
+// Freed pages are reused lowest first, and an instance of a parallel buffer pool only gets ids of its own residue.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AllocatePageTest) {
+  auto dm = DiskManager("test.db");
+  for (page_id_t page_id = 0; page_id < 10; page_id++) {
+    EXPECT_EQ(page_id, dm.AllocatePage());
+  }
+  dm.DeallocatePage(5);
+  dm.DeallocatePage(3);
+  dm.DeallocatePage(3);
+  dm.DeallocatePage(42);
+  EXPECT_FALSE(dm.IsAllocated(3));
+  EXPECT_TRUE(dm.IsAllocated(4));
+  EXPECT_EQ(2, dm.GetNumFreePages());
+  EXPECT_EQ(3, dm.AllocatePage());
+  EXPECT_EQ(5, dm.AllocatePage());
+  EXPECT_EQ(10, dm.AllocatePage());
+  EXPECT_EQ(11, dm.GetHighWaterMark());
+
+  // Instance 2 of 4 skips 11 to 13, which the other instances get later
+  dm.DeallocatePage(7);
+  EXPECT_EQ(14, dm.AllocatePage(4, 2));
+  EXPECT_EQ(7, dm.AllocatePage(4, 3));
+  EXPECT_EQ(11, dm.AllocatePage(4, 3));
+  EXPECT_EQ(12, dm.AllocatePage(4, 0));
+  EXPECT_EQ(13, dm.AllocatePage(4, 1));
+  EXPECT_EQ(0, dm.GetNumFreePages());
+  dm.ShutDown();
+}
+
+// Instances allocate and free pages concurrently, each from its own free list.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentAllocatePageTest) {
+  const uint32_t num_instances = 4;
+  const int num_rounds = 1000;
+  auto dm = DiskManager("test.db");
+  std::vector<std::vector<page_id_t>> allocated(num_instances);
+  std::vector<std::thread> threads;
+  for (uint32_t instance = 0; instance < num_instances; instance++) {
+    threads.emplace_back([&, instance] {
+      for (int round = 0; round < num_rounds; round++) {
+        auto page_id = dm.AllocatePage(num_instances, instance);
+        EXPECT_EQ(instance, static_cast<uint32_t>(page_id) % num_instances);
+        if (round % 3 == 2) {
+          dm.DeallocatePage(page_id);
+        } else {
+          allocated[instance].push_back(page_id);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::set<page_id_t> page_ids;
+  for (const auto &page_ids_of_instance : allocated) {
+    for (auto page_id : page_ids_of_instance) {
+      EXPECT_TRUE(page_ids.insert(page_id).second) << page_id;
+      EXPECT_TRUE(dm.IsAllocated(page_id));
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(dm.GetHighWaterMark()) - page_ids.size(), dm.GetNumFreePages());
+  dm.ShutDown();
+}
+
+// The space maps keep the allocated pages and the high-water mark across a restart, and ShrinkFile() gives the
+// trailing free pages back.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreeSpaceRestartTest) {
+  const page_id_t num_pages = 40000;
+  std::string db_file("test.db");
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  char buf[BUSTUB_PAGE_SIZE];
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+    }
+    for (page_id_t page_id = 0; page_id < num_pages; page_id += 1000) {
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+    for (page_id_t page_id = 1; page_id < num_pages; page_id += 2) {
+      dm.DeallocatePage(page_id);
+    }
+    dm.ShutDown();
+  }
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(num_pages - 1, dm.GetHighWaterMark());
+    EXPECT_EQ(num_pages / 2 - 1, dm.GetNumFreePages());
+    EXPECT_TRUE(dm.IsAllocated(num_pages - 2));
+    EXPECT_FALSE(dm.IsAllocated(num_pages - 3));
+    EXPECT_EQ(1, dm.AllocatePage());
+
+    // Free the pages of the second extent and the end of the first, then shrink down to the last allocated page
+    for (page_id_t page_id = 30000; page_id < num_pages; page_id++) {
+      dm.DeallocatePage(page_id);
+    }
+    EXPECT_GT(dm.ShrinkFile(), 0);
+    EXPECT_EQ(29999, dm.GetHighWaterMark());
+    EXPECT_EQ(3, dm.AllocatePage());
+    dm.ShutDown();
+  }
+
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_file.c_str(), &stat_buf));
+  EXPECT_EQ(DiskManager::PageOffset(29998) + BUSTUB_PAGE_SIZE, stat_buf.st_size);
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(29999, dm.GetHighWaterMark());
+  EXPECT_TRUE(dm.IsAllocated(1));
+  EXPECT_TRUE(dm.IsAllocated(3));
+  EXPECT_FALSE(dm.IsAllocated(5));
+  for (page_id_t page_id = 0; page_id < 30000; page_id += 1000) {
+    std::memcpy(data, &page_id, sizeof(page_id));
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0) << page_id;
+  }
+  dm.ShutDown();
+}
+
+// Destroying the manager without a ShutDown() still writes the space maps that changed.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReopenWithoutShutDownTest) {
+  std::string db_file("test.db");
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t page_id = 0; page_id < 10; page_id++) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+      dm.WritePage(page_id, data);
+    }
+    dm.DeallocatePage(4);
+  }
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(10, dm.GetHighWaterMark());
+  EXPECT_EQ(1, dm.GetNumFreePages());
+  EXPECT_FALSE(dm.IsAllocated(4));
+  EXPECT_TRUE(dm.IsAllocated(9));
+  EXPECT_EQ(4, dm.AllocatePage());
+  EXPECT_EQ(10, dm.AllocatePage());
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(ChecksumMode::VERIFY_ON_READ, dm.GetChecksumMode());
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+
+    CorruptPage(db_file, 5);
+    dm.ReadPage(4, buf);
+    EXPECT_EQ(0, dm.GetNumChecksumFailures());
+    dm.ReadPage(5, buf);
+    EXPECT_EQ(1, dm.GetNumChecksumFailures());
+    EXPECT_EQ(std::vector<page_id_t>{5}, dm.GetCorruptPages());
+
+    // The page can be checked on demand
+    EXPECT_TRUE(dm.VerifyPage(4));
+    EXPECT_FALSE(dm.VerifyPage(5));
+    EXPECT_EQ(2, dm.GetNumChecksumFailures());
+
+    // Writing the page again repairs it
+    dm.WritePage(5, data);
+    EXPECT_TRUE(dm.GetCorruptPages().empty());
+    dm.ReadPage(5, buf);
+    EXPECT_EQ(2, dm.GetNumChecksumFailures());
+
+    // Checksums off drops the checksums taken so far, and writes neither take one nor sync
+    dm.SetChecksumMode(ChecksumMode::OFF);
+    CorruptPage(db_file, 3);
+    dm.ReadPage(3, buf);
+    EXPECT_TRUE(dm.VerifyPage(3));
+    EXPECT_EQ(2, dm.GetNumChecksumFailures());
+    dm.SyncDatabase();
+    auto num_barriers = dm.GetNumChecksumBarriers();
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+    EXPECT_EQ(num_barriers, dm.GetNumChecksumBarriers());
+
+    // Back on, the pages are checksummed as they are written again
+    dm.SetChecksumMode(ChecksumMode::VERIFY_ON_READ);
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+
+    // A page that was never written has no checksum to fail
+    dm.ReadPage(100, buf);
+    EXPECT_TRUE(dm.VerifyPage(100));
+    dm.ShutDown();
+  }
+
+  // The checksums survive a restart
+  CorruptPage(db_file, 2);
+  auto dm = DiskManager(db_file);
+  dm.ReadPage(1, buf);
+  dm.ReadPage(2, buf);
+  EXPECT_EQ(1, dm.GetNumChecksumFailures());
+  EXPECT_EQ(std::vector<page_id_t>{2}, dm.GetCorruptPages());
+  dm.ShutDown();
+}
+
+// A crash is simulated by copying the file as the OS sees it, without a SyncDatabase(). The checksums of an extent
+// written since the last sync may not match its pages, so they are dropped, and the pages of a synced extent are still
+// checked.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumWithoutSyncTest) {
+  // A page of the second extent, which holds one page per bit of a space map page
+  const page_id_t synced_page = BUSTUB_PAGE_SIZE * 8 + 1;
+  std::string db_file("test.db");
+  std::string crash_file("crash.db");
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char old_data[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  {
+    auto dm = DiskManager(db_file);
+    dm.WritePage(synced_page, data);
+    dm.SyncDatabase();
+
+    // Only the first write to the extent since the sync waits for a barrier
+    auto num_barriers = dm.GetNumChecksumBarriers();
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+    std::memcpy(old_data, data, BUSTUB_PAGE_SIZE);
+    std::memset(data, 'x', BUSTUB_PAGE_SIZE);
+    dm.WritePage(7, data);
+    EXPECT_EQ(num_barriers + 1, dm.GetNumChecksumBarriers());
+    EXPECT_EQ(1, dm.GetNumSyncs());
+
+    std::ifstream src(db_file, std::ios::binary);
+    std::ofstream dst(crash_file, std::ios::binary | std::ios::trunc);
+    dst << src.rdbuf();
+  }
+
+  // Put back what page 7 held before its last write, as if that write never reached the disk
+  int fd = open(crash_file.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(BUSTUB_PAGE_SIZE, pwrite(fd, old_data, BUSTUB_PAGE_SIZE, DiskManager::PageOffset(7)));
+  close(fd);
+  CorruptPage(crash_file, synced_page);
+  {
+    auto dm = DiskManager(crash_file);
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      EXPECT_TRUE(dm.VerifyPage(page_id)) << page_id;
+    }
+    dm.ReadPage(7, buf);
+    EXPECT_EQ(0, std::memcmp(buf, old_data, BUSTUB_PAGE_SIZE));
+    EXPECT_FALSE(dm.VerifyPage(synced_page));
+    EXPECT_EQ(std::vector<page_id_t>{synced_page}, dm.GetCorruptPages());
+
+    // The pages are checksummed again as they are written
+    dm.WritePage(7, data);
+    dm.SyncDatabase();
+    dm.ShutDown();
+  }
+  CorruptPage(crash_file, 7);
+  {
+    auto dm = DiskManager(crash_file);
+    EXPECT_FALSE(dm.VerifyPage(7));
+  }
+  remove(crash_file.c_str());
+  remove("crash.log");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ScrubberTest) {
+  const page_id_t num_pages = 100;
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto page_id = dm.AllocatePage();
+    std::memcpy(data, &page_id, sizeof(page_id));
+    dm.WritePage(page_id, data);
+  }
+  CorruptPage(db_file, 37);
+  CorruptPage(db_file, 80);
+  // Free pages are not scrubbed
+  dm.DeallocatePage(80);
+
+  // Wait for the scrubber to go over the file twice
+  dm.SetChecksumMode(ChecksumMode::BACKGROUND_SCRUB);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (dm.GetNumPagesScrubbed() < 2 * num_pages && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_GE(dm.GetNumPagesScrubbed(), 2 * num_pages);
+  EXPECT_EQ(std::vector<page_id_t>{37}, dm.GetCorruptPages());
+
+  // Leaving the mode stops the scrubber
+  dm.SetChecksumMode(ChecksumMode::VERIFY_ON_READ);
+  auto num_scrubbed = dm.GetNumPagesScrubbed();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(num_scrubbed, dm.GetNumPagesScrubbed());
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -72,6 +533,49 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// A file of another layout is rejected rather than read at the wrong offsets.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FileFormatTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    std::strncpy(data, "A page", sizeof(data));
+    dm.WritePage(0, data);
+    dm.ShutDown();
+  }
+  // A file of this format opens again, and so does one that was never written to
+  {
+    auto dm = DiskManager(db_file);
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+    dm.ShutDown();
+  }
+  remove(db_file.c_str());
+  EXPECT_NO_THROW(DiskManager(db_file).ShutDown());
+  EXPECT_NO_THROW(DiskManager(db_file).ShutDown());
+
+  // The file layout of the baseline kept page 0 at the start of the file
+  int fd = open(db_file.c_str(), O_RDWR | O_TRUNC);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(BUSTUB_PAGE_SIZE, pwrite(fd, data, BUSTUB_PAGE_SIZE, 0));
+  close(fd);
+  EXPECT_THROW(DiskManager{db_file}, Exception);
+
+  // A later version of the format, which follows the magic number
+  remove(db_file.c_str());
+  DiskManager(db_file).ShutDown();
+  fd = open(db_file.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  uint32_t version;
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(version)), pread(fd, &version, sizeof(version), 8));
+  version++;
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(version)), pwrite(fd, &version, sizeof(version), 8));
+  close(fd);
+  EXPECT_THROW(DiskManager{db_file}, Exception);
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
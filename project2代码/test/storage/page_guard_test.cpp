@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <utility>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, DropUnpins) {
+  const size_t buffer_pool_size = 5;
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+
+  page_id_t page_id;
+  auto *page = bpm.NewPage(&page_id);
+  bpm.UnpinPage(page_id, false);
+
+  {
+    auto guard = bpm.FetchPageBasic(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  auto guard = bpm.FetchPageBasic(page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  guard.Drop();
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_FALSE(guard.IsValid());
+  // Dropping twice, and destroying a dropped guard, must not unpin again.
+  guard.Drop();
+  EXPECT_EQ(0, page->GetPinCount());
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, MoveTransfersPin) {
+  const size_t buffer_pool_size = 5;
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+
+  page_id_t page_id0;
+  page_id_t page_id1;
+  auto *page0 = bpm.NewPage(&page_id0);
+  auto *page1 = bpm.NewPage(&page_id1);
+  bpm.UnpinPage(page_id0, false);
+  bpm.UnpinPage(page_id1, false);
+
+  auto guard0 = bpm.FetchPageBasic(page_id0);
+  auto moved = std::move(guard0);
+  EXPECT_FALSE(guard0.IsValid());  // NOLINT(bugprone-use-after-move)
+  EXPECT_TRUE(moved.IsValid());
+  EXPECT_EQ(1, page0->GetPinCount());
+
+  // Move assignment drops the page the target held before.
+  auto guard1 = bpm.FetchPageBasic(page_id1);
+  EXPECT_EQ(1, page1->GetPinCount());
+  guard1 = std::move(moved);
+  EXPECT_EQ(0, page1->GetPinCount());
+  EXPECT_EQ(1, page0->GetPinCount());
+
+  guard1.Drop();
+  EXPECT_EQ(0, page0->GetPinCount());
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, ReadWriteGuardsLatch) {
+  const size_t buffer_pool_size = 5;
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+
+  page_id_t page_id;
+  auto *page = bpm.NewPage(&page_id);
+  bpm.UnpinPage(page_id, false);
+
+  {
+    auto write_guard = bpm.FetchPageWrite(page_id);
+    ASSERT_TRUE(write_guard.IsValid());
+    EXPECT_EQ(1, page->GetPinCount());
+    std::strcpy(write_guard.GetDataMut(), "Hello");  // NOLINT
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+
+  // The write latch was released, so two readers can share the page.
+  {
+    auto read_guard0 = bpm.FetchPageRead(page_id);
+    auto read_guard1 = bpm.FetchPageRead(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_EQ(0, std::strcmp(read_guard0.GetData(), "Hello"));
+    EXPECT_EQ(0, std::strcmp(read_guard1.GetData(), "Hello"));
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // And a writer can take it again once the readers are gone.
+  auto write_guard = bpm.FetchPageBasic(page_id).UpgradeWrite();
+  EXPECT_EQ(1, page->GetPinCount());
+  write_guard.Drop();
+  EXPECT_EQ(0, page->GetPinCount());
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, DirtyOnlyWhenModified) {
+  const size_t buffer_pool_size = 5;
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+
+  page_id_t page_id;
+  auto *page = bpm.NewPage(&page_id);
+  bpm.UnpinPage(page_id, false);
+  bpm.FlushPage(page_id);
+  ASSERT_FALSE(page->IsDirty());
+
+  bpm.FetchPageWrite(page_id).Drop();
+  EXPECT_FALSE(page->IsDirty());
+
+  {
+    auto guard = bpm.FetchPageBasic(page_id);
+    guard.SetDirty();
+  }
+  EXPECT_TRUE(page->IsDirty());
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, FailedFetchGivesEmptyGuard) {
+  const size_t buffer_pool_size = 2;
+  DiskManagerUnlimitedMemory disk_manager;
+  BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+
+  page_id_t page_id0;
+  page_id_t page_id1;
+  page_id_t page_id2;
+  auto guard0 = bpm.NewPageGuarded(&page_id0);
+  auto guard1 = bpm.NewPageGuarded(&page_id1);
+  ASSERT_TRUE(guard0.IsValid());
+  ASSERT_TRUE(guard1.IsValid());
+
+  // Every frame is pinned by a guard.
+  EXPECT_FALSE(bpm.NewPageGuarded(&page_id2).IsValid());
+  auto read_guard = bpm.FetchPageRead(page_id1 + 1);
+  EXPECT_FALSE(read_guard.IsValid());
+  read_guard.Drop();
+
+  guard1.Drop();
+  EXPECT_TRUE(bpm.NewPageGuarded(&page_id2).IsValid());
+}
+
+}  // namespace bustub
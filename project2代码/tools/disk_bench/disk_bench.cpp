@@ -0,0 +1,270 @@
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <fstream>
+#include <future>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/config.h"
+#include "common/exception.h"
+#include "fmt/core.h"
+#include "storage/disk/async_disk_manager.h"
+#include "storage/disk/disk_manager.h"
+
+namespace {
+
+/**
+ * The stream-based page I/O that DiskManager did before it moved to pread()/pwrite(), kept as the baseline: one
+ * fstream behind one latch, a flush after every write, and a stat() of the file before every read. It never synced the
+ * file, so its SyncDatabase() does nothing.
+ */
+class StreamDiskManager : public bustub::DiskManager {
+ public:
+  explicit StreamDiskManager(const std::string &db_file) : db_file_(db_file) {
+    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    if (!db_io_.is_open()) {
+      throw bustub::Exception("can't open db file");
+    }
+  }
+
+  void WritePage(bustub::page_id_t page_id, const char *page_data) override {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    db_io_.seekp(static_cast<size_t>(page_id) * bustub::BUSTUB_PAGE_SIZE);
+    db_io_.write(page_data, bustub::BUSTUB_PAGE_SIZE);
+    db_io_.flush();
+  }
+
+  void ReadPage(bustub::page_id_t page_id, char *page_data) override {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    auto offset = static_cast<size_t>(page_id) * bustub::BUSTUB_PAGE_SIZE;
+    struct stat stat_buf;
+    if (stat(db_file_.c_str(), &stat_buf) != 0 || offset > static_cast<size_t>(stat_buf.st_size)) {
+      return;
+    }
+    db_io_.seekp(offset);
+    db_io_.read(page_data, bustub::BUSTUB_PAGE_SIZE);
+    if (db_io_.gcount() < bustub::BUSTUB_PAGE_SIZE) {
+      db_io_.clear();
+    }
+  }
+
+ private:
+  std::string db_file_;
+  std::fstream db_io_;
+  std::mutex db_io_latch_;
+};
+
+enum class Workload { RAND_READ, RAND_WRITE, RAND_RW };
+
+struct RunResult {
+  double iops_;
+  double avg_latency_us_;
+};
+
+/**
+ * Issue ops_per_thread random page reads and/or writes from each of num_threads threads, fio-style. With an iodepth of
+ * 0 a thread calls ReadPage() and WritePage(); otherwise it keeps iodepth requests in flight through Schedule(),
+ * scheduling the next one whenever its oldest one completes. With sync_every set, every thread syncs the file after
+ * that many of its writes, once they have completed.
+ */
+auto Run(bustub::DiskManager *disk_manager, Workload workload, size_t num_threads, size_t iodepth, size_t num_pages,
+         size_t ops_per_thread, size_t sync_every) -> RunResult {
+  std::vector<std::thread> threads;
+  std::atomic<size_t> total_latency_ns{0};
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937_64 gen(t);
+      std::uniform_int_distribution<size_t> page_dist(0, num_pages - 1);
+      std::bernoulli_distribution write_dist(workload == Workload::RAND_READ    ? 0.0
+                                             : workload == Workload::RAND_WRITE ? 1.0
+                                                                                : 0.5);
+      size_t writes = 0;
+      size_t latency_ns = 0;
+      if (iodepth > 0) {
+        // One buffer per slot of the window; slot i % iodepth holds the i-th request
+        auto data = std::make_unique<char[]>(iodepth * bustub::BUSTUB_PAGE_SIZE);
+        std::memset(data.get(), static_cast<int>(t), iodepth * bustub::BUSTUB_PAGE_SIZE);
+        std::vector<std::future<bool>> in_flight(iodepth);
+        std::vector<std::chrono::steady_clock::time_point> submitted(iodepth);
+        auto wait_for = [&](size_t slot) {
+          if (in_flight[slot].valid()) {
+            in_flight[slot].wait();
+            in_flight[slot] = {};
+            latency_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                               submitted[slot])
+                              .count();
+          }
+        };
+        for (size_t i = 0; i < ops_per_thread; i++) {
+          auto slot = i % iodepth;
+          wait_for(slot);
+          std::vector<bustub::DiskRequest> requests(1);
+          bool is_write = write_dist(gen);
+          requests[0] = {is_write, &data[slot * bustub::BUSTUB_PAGE_SIZE],
+                         static_cast<bustub::page_id_t>(page_dist(gen)), {}};
+          in_flight[slot] = requests[0].callback_.get_future();
+          submitted[slot] = std::chrono::steady_clock::now();
+          disk_manager->Schedule(&requests);
+          if (is_write && sync_every != 0 && ++writes % sync_every == 0) {
+            for (size_t s = 0; s < iodepth; s++) {
+              wait_for(s);
+            }
+            disk_manager->SyncDatabase();
+          }
+        }
+        for (size_t s = 0; s < iodepth; s++) {
+          wait_for(s);
+        }
+        total_latency_ns += latency_ns;
+        return;
+      }
+
+      auto data = std::make_unique<char[]>(bustub::BUSTUB_PAGE_SIZE);
+      std::memset(data.get(), static_cast<int>(t), bustub::BUSTUB_PAGE_SIZE);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        auto page_id = static_cast<bustub::page_id_t>(page_dist(gen));
+        auto op_start = std::chrono::steady_clock::now();
+        if (write_dist(gen)) {
+          disk_manager->WritePage(page_id, data.get());
+          if (sync_every != 0 && ++writes % sync_every == 0) {
+            disk_manager->SyncDatabase();
+          }
+        } else {
+          disk_manager->ReadPage(page_id, data.get());
+        }
+        latency_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - op_start)
+                          .count();
+      }
+      total_latency_ns += latency_ns;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  auto num_ops = static_cast<double>(num_threads * ops_per_thread);
+  return {num_ops / elapsed, static_cast<double>(total_latency_ns.load()) / num_ops / 1e3};
+}
+
+auto ParseWorkload(const std::string &rw, Workload *workload) -> bool {
+  if (rw == "randread") {
+    *workload = Workload::RAND_READ;
+  } else if (rw == "randwrite") {
+    *workload = Workload::RAND_WRITE;
+  } else if (rw == "randrw") {
+    *workload = Workload::RAND_RW;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+auto ParseList(const std::string &arg) -> std::vector<size_t> {
+  std::vector<size_t> values;
+  std::stringstream in(arg);
+  for (std::string value; std::getline(in, value, ',');) {
+    values.push_back(std::stoul(value));
+  }
+  return values;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-disk-bench");
+  program.add_argument("--file").help("database file to run on; it is created and removed").default_value(
+      std::string("disk-bench.db"));
+  program.add_argument("--rw").help("randread, randwrite or randrw").default_value(std::string("randread"));
+  program.add_argument("--pages").help("size of the file in pages").default_value(std::string("16384"));
+  program.add_argument("--threads").help("comma-separated numbers of threads to run with").default_value(
+      std::string("1,4,16"));
+  program.add_argument("--iodepth")
+      .help("comma-separated numbers of requests each thread keeps in flight with the asynchronous managers")
+      .default_value(std::string("1,4,16,64"));
+  program.add_argument("--ops").help("page reads and writes per thread").default_value(std::string("50000"));
+  program.add_argument("--sync-every").help("sync after this many writes of a thread, 0 for never").default_value(
+      std::string("0"));
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  auto file = program.get<std::string>("--file");
+  Workload workload;
+  if (!ParseWorkload(program.get<std::string>("--rw"), &workload)) {
+    std::cerr << "--rw must be randread, randwrite or randrw" << std::endl;
+    return 1;
+  }
+  auto num_pages = std::stoul(program.get<std::string>("--pages"));
+  auto ops_per_thread = std::stoul(program.get<std::string>("--ops"));
+  auto sync_every = std::stoul(program.get<std::string>("--sync-every"));
+  auto thread_counts = ParseList(program.get<std::string>("--threads"));
+  auto iodepths = ParseList(program.get<std::string>("--iodepth"));
+  if (num_pages == 0 || std::count(thread_counts.begin(), thread_counts.end(), 0) > 0 ||
+      std::count(iodepths.begin(), iodepths.end(), 0) > 0) {
+    std::cerr << "--pages, --threads and --iodepth must be positive" << std::endl;
+    return 1;
+  }
+
+  // Lay the whole file out first, so that reads never run past its end
+  {
+    bustub::DiskManager disk_manager(file);
+    auto data = std::make_unique<char[]>(bustub::BUSTUB_PAGE_SIZE);
+    for (size_t i = 0; i < num_pages; i++) {
+      disk_manager.WritePage(static_cast<bustub::page_id_t>(i), data.get());
+    }
+    disk_manager.ShutDown();
+  }
+
+  fmt::print("{} pages of {} bytes, {} ops per thread, sync every {} writes\n", num_pages, bustub::BUSTUB_PAGE_SIZE,
+             ops_per_thread, sync_every);
+  fmt::print("{:<8} {:<10} {:>8} {:>8} {:>12} {:>10} {:>14}\n", "manager", "rw", "threads", "iodepth", "iops", "MiB/s",
+             "avg lat (us)");
+  auto run = [&](const std::string &manager, bustub::DiskManager *disk_manager, size_t num_threads, size_t iodepth) {
+    auto result = Run(disk_manager, workload, num_threads, iodepth, num_pages, ops_per_thread, sync_every);
+    auto mib_per_sec = result.iops_ * bustub::BUSTUB_PAGE_SIZE / (1 << 20);
+    fmt::print("{:<8} {:<10} {:>8} {:>8} {:>12.0f} {:>10.1f} {:>14.2f}\n", manager, program.get<std::string>("--rw"),
+               num_threads, iodepth == 0 ? "sync" : std::to_string(iodepth), result.iops_, mib_per_sec,
+               result.avg_latency_us_);
+    disk_manager->ShutDown();
+  };
+  for (auto num_threads : thread_counts) {
+    {
+      StreamDiskManager disk_manager(file);
+      run("stream", &disk_manager, num_threads, 0);
+    }
+    {
+      bustub::DiskManager disk_manager(file);
+      run("pread", &disk_manager, num_threads, 0);
+    }
+    for (auto iodepth : iodepths) {
+      // The manager's queue fits the requests of every thread
+      for (bool use_io_uring : {true, false}) {
+        bustub::AsyncDiskManager disk_manager(file, num_threads * iodepth, use_io_uring);
+        if (use_io_uring && disk_manager.GetEngine() != bustub::AsyncIoEngine::IO_URING) {
+          continue;
+        }
+        run(use_io_uring ? "uring" : "pool", &disk_manager, num_threads, iodepth);
+      }
+    }
+  }
+  remove(file.c_str());
+  remove((file.substr(0, file.rfind('.')) + ".log").c_str());
+  return 0;
+}
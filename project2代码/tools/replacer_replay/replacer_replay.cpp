@@ -0,0 +1,121 @@
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/page_access_trace.h"
+#include "buffer/replacement_policy.h"
+#include "common/config.h"
+#include "fmt/core.h"
+
+namespace {
+
+struct ReplayResult {
+  size_t hits_{0};
+  size_t misses_{0};
+  size_t evictions_{0};
+};
+
+/**
+ * Replay a trace against a buffer pool of num_frames frames that only keeps track of which page lives in which frame.
+ * Every request pins its page and unpins it right away, as a buffer pool with a single thread would.
+ */
+auto Replay(const std::vector<bustub::PageAccessTrace::Event> &events, bustub::ReplacerType type, size_t num_frames,
+            size_t k) -> ReplayResult {
+  using bustub::frame_id_t;
+  using bustub::page_id_t;
+
+  auto replacer = bustub::MakeReplacementPolicy(type, num_frames, k);
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frame_pages(num_frames, bustub::INVALID_PAGE_ID);
+  std::list<frame_id_t> free_list;
+  for (size_t i = 0; i < num_frames; i++) {
+    free_list.push_back(static_cast<frame_id_t>(i));
+  }
+
+  ReplayResult result;
+  for (const auto &event : events) {
+    auto it = page_table.find(event.page_id_);
+    if (event.type_ == bustub::PageAccessTrace::EventType::DELETE) {
+      if (it != page_table.end()) {
+        replacer->Remove(it->second);
+        free_list.push_back(it->second);
+        page_table.erase(it);
+      }
+      continue;
+    }
+    if (it != page_table.end()) {
+      result.hits_++;
+      replacer->RecordAccess(it->second, event.page_id_);
+      continue;
+    }
+
+    // A new page is not a miss, but it needs a frame all the same.
+    if (event.type_ == bustub::PageAccessTrace::EventType::FETCH) {
+      result.misses_++;
+    }
+    frame_id_t frame_id;
+    if (!free_list.empty()) {
+      frame_id = free_list.front();
+      free_list.pop_front();
+    } else {
+      replacer->Evict(&frame_id);
+      result.evictions_++;
+      page_table.erase(frame_pages[frame_id]);
+    }
+    page_table[event.page_id_] = frame_id;
+    frame_pages[frame_id] = event.page_id_;
+    replacer->RecordAccess(frame_id, event.page_id_);
+    replacer->SetEvictable(frame_id, true);
+  }
+  return result;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-replacer-replay");
+  program.add_argument("trace").help("a page access trace recorded with --trace by terrier bench or sqllogictest");
+  program.add_argument("--frames").help("number of frames of the simulated buffer pool").default_value(
+      std::string("128"));
+  program.add_argument("--k").help("lookback constant of LRU-K").default_value(std::to_string(bustub::LRUK_REPLACER_K));
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  auto filename = program.get<std::string>("trace");
+  std::ifstream in(filename);
+  if (!in) {
+    std::cerr << "Failed to open " << filename << std::endl;
+    return 1;
+  }
+  auto events = bustub::PageAccessTrace::Read(&in);
+  auto num_frames = std::stoul(program.get<std::string>("--frames"));
+  auto k = std::stoul(program.get<std::string>("--k"));
+  if (num_frames == 0) {
+    std::cerr << "--frames must be positive" << std::endl;
+    return 1;
+  }
+
+  fmt::print("{} events, {} frames\n", events.size(), num_frames);
+  fmt::print("{:<10} {:>10} {:>10} {:>10} {:>9}\n", "policy", "hits", "misses", "evictions", "hit ratio");
+  for (auto type : {bustub::ReplacerType::LRU_K, bustub::ReplacerType::ARC, bustub::ReplacerType::TWO_Q,
+                    bustub::ReplacerType::CLOCK_PRO, bustub::ReplacerType::CLOCK}) {
+    auto result = Replay(events, type, num_frames, k);
+    auto requests = result.hits_ + result.misses_;
+    auto hit_ratio = requests == 0 ? 0.0 : static_cast<double>(result.hits_) / static_cast<double>(requests);
+    fmt::print("{:<10} {:>10} {:>10} {:>10} {:>9.4f}\n", bustub::ReplacerTypeToString(type), result.hits_,
+               result.misses_, result.evictions_, hit_ratio);
+  }
+  return 0;
+}
@@ -8,6 +8,7 @@
 #include <utility>
 
 #include "argparse/argparse.hpp"
+#include "buffer/page_access_trace.h"
 #include "common/bustub_instance.h"
 #include "common/exception.h"
 #include "common/util/string_util.h"
@@ -147,6 +148,7 @@ auto main(int argc, char **argv) -> int {  // NOLINT
   program.add_argument("--verbose").help("increase output verbosity").default_value(false).implicit_value(true);
   program.add_argument("-d", "--diff").help("write diff file").default_value(false).implicit_value(true);
   program.add_argument("--in-memory").help("use in-memory backend").default_value(false).implicit_value(true);
+  program.add_argument("--trace").help("record the page accesses of the buffer pool to a file");
 
   try {
     program.parse_args(argc, argv);
@@ -171,6 +173,18 @@ auto main(int argc, char **argv) -> int {  // NOLINT
 
   auto result = bustub::SQLLogicTestParser::Parse(script);
 
+  // Declared before the instance, so that the trace outlives the buffer pool that records to it.
+  std::ofstream trace_file;
+  std::unique_ptr<bustub::PageAccessTrace> trace;
+  if (program.present("--trace")) {
+    trace_file.open(program.get("--trace"));
+    if (!trace_file) {
+      std::cerr << "Failed to open " << program.get("--trace") << std::endl;
+      return 1;
+    }
+    trace = std::make_unique<bustub::PageAccessTrace>(&trace_file);
+  }
+
   std::unique_ptr<bustub::BustubInstance> bustub;
 
   if (program.get<bool>("--in-memory")) {
@@ -182,6 +196,7 @@ auto main(int argc, char **argv) -> int {  // NOLINT
   bustub->GenerateMockTable();
 
   if (bustub->buffer_pool_manager_ != nullptr) {
+    bustub->buffer_pool_manager_->SetAccessTrace(trace.get());
     bustub->GenerateTestTable();
   }
 
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -9,6 +10,7 @@
 #include <vector>
 
 #include "argparse/argparse.hpp"
+#include "buffer/page_access_trace.h"
 #include "binder/binder.h"
 #include "common/bustub_instance.h"
 #include "common/exception.h"
@@ -120,6 +122,8 @@ auto main(int argc, char **argv) -> int {
   program.add_argument("--duration").help("run terrier bench for n milliseconds");
   program.add_argument("--force-create-index").help("create index in terrier bench");
   program.add_argument("--force-enable-update").help("use update statement in terrier bench");
+  program.add_argument("--bpm-instances").help("number of buffer pool shards (1 = single BufferPoolManagerInstance)");
+  program.add_argument("--trace").help("record the page accesses of the buffer pool to a file");
 
   try {
     program.parse_args(argc, argv);
@@ -129,8 +133,26 @@ auto main(int argc, char **argv) -> int {
     return 1;
   }
 
-  auto bustub = std::make_unique<bustub::BustubInstance>();
+  size_t bpm_instances = 1;
+  if (program.present("--bpm-instances")) {
+    bpm_instances = std::stoi(program.get("--bpm-instances"));
+  }
+
+  // Declared before the instance, so that the trace outlives the buffer pool that records to it.
+  std::ofstream trace_file;
+  std::unique_ptr<bustub::PageAccessTrace> trace;
+  if (program.present("--trace")) {
+    trace_file.open(program.get("--trace"));
+    if (!trace_file) {
+      std::cerr << "cannot open trace file " << program.get("--trace") << std::endl;
+      return 1;
+    }
+    trace = std::make_unique<bustub::PageAccessTrace>(&trace_file);
+  }
+
+  auto bustub = std::make_unique<bustub::BustubInstance>(bpm_instances);
   auto writer = bustub::SimpleStreamWriter(std::cerr);
+  bustub->buffer_pool_manager_->SetAccessTrace(trace.get());
 
   // create schema
   auto schema = "CREATE TABLE nft(id int, terrier int);";
@@ -359,6 +381,7 @@ auto main(int argc, char **argv) -> int {
   }
 
   total_metrics.Report();
+  fmt::print("buffer pool stats:\n{}", bustub->buffer_pool_manager_->GetStats().ToString());
 
   return 0;
 }